@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Secondary CPUs for compute jobs, started with PSCI
+ *
+ * The secondary CPUs are powered on with PSCI CPU_ON for each batch of jobs,
+ * take over the exception level, page tables and global data of the boot CPU
+ * and power themselves off with CPU_OFF once their work is done. So, unlike
+ * with the spin table, nothing is left running by the time an OS is booted
+ * and the OS brings the CPUs up as usual.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <errno.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/psci.h>
+#include <asm/ptrace.h>
+#include <asm/system.h>
+#include <linux/bug.h>
+#include <linux/libfdt.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MP_JOB_STACK_SIZE	SZ_16K
+#define MP_JOB_STOP_TIMEOUT_MS	100
+
+/* Affinity fields of MPIDR_EL1 */
+#define MPIDR_HWID_MASK		0xff00ffffffUL
+
+/*
+ * What a secondary CPU needs to join the boot CPU. This is read by
+ * mp_job_secondary_entry() with the MMU off, so the offsets of the fields up
+ * to @entry are fixed.
+ */
+struct mp_job_cpu {
+	u64 stack;
+	u64 vbar;
+	u64 mair;
+	u64 tcr;
+	u64 ttbr;
+	u64 sctlr;
+	u64 gd;
+	u64 entry;
+	u64 mpidr;
+} __aligned(ARCH_DMA_MINALIGN);
+
+static struct mp_job_cpu mp_job_cpu[CONFIG_MP_JOBS_CPUS];
+static int mp_job_ncpus;
+
+void mp_job_secondary_entry(void);
+
+/* Called by mp_job_secondary_entry() once the MMU is on */
+void __noreturn mp_job_secondary(struct mp_job_cpu *cpu)
+{
+	struct pt_regs regs;
+
+	((void (*)(void))cpu->entry)();
+
+	regs.regs[0] = ARM_PSCI_0_2_FN_CPU_OFF;
+	smc_call(&regs);
+
+	/* CPU_OFF only returns on error */
+	while (1)
+		wfi();
+}
+
+/* Find the secondary CPUs which can be started with PSCI */
+static int mp_job_find_cpus(void)
+{
+	const void *blob = gd->fdt_blob;
+	const char *prop;
+	const fdt32_t *reg;
+	int cpus, node, cells;
+	int count = 1;
+	u64 self, mpidr;
+
+	/* PSCI calls are made with SMC, so EL3 must be below us */
+	if (current_el() > 2)
+		return 1;
+	node = fdt_path_offset(blob, "/psci");
+	prop = fdt_getprop(blob, node, "method", NULL);
+	if (node < 0 || !prop || strcmp(prop, "smc"))
+		return 1;
+	if (fdt_node_check_compatible(blob, node, "arm,psci-0.2") &&
+	    fdt_node_check_compatible(blob, node, "arm,psci-1.0"))
+		return 1;
+
+	cpus = fdt_path_offset(blob, "/cpus");
+	if (cpus < 0)
+		return 1;
+	cells = fdt_address_cells(blob, cpus);
+	self = read_mpidr() & MPIDR_HWID_MASK;
+	fdt_for_each_subnode(node, blob, cpus) {
+		if (count == ARRAY_SIZE(mp_job_cpu))
+			break;
+		prop = fdt_getprop(blob, node, "device_type", NULL);
+		if (!prop || strcmp(prop, "cpu"))
+			continue;
+		prop = fdt_getprop(blob, node, "enable-method", NULL);
+		if (!prop || strcmp(prop, "psci"))
+			continue;
+		reg = fdt_getprop(blob, node, "reg", NULL);
+		if (!reg)
+			continue;
+		mpidr = fdt_read_number(reg, cells);
+		if (mpidr == self)
+			continue;
+		mp_job_cpu[count++].mpidr = mpidr;
+	}
+
+	return count;
+}
+
+int arch_mp_job_cpus(void)
+{
+	if (!mp_job_ncpus)
+		mp_job_ncpus = mp_job_find_cpus();
+
+	return mp_job_ncpus;
+}
+
+/* Record the MMU set-up of the boot CPU for a secondary to use */
+static void mp_job_save_el(struct mp_job_cpu *cpu)
+{
+	if (current_el() == 2) {
+		asm volatile("mrs %0, vbar_el2" : "=r" (cpu->vbar));
+		asm volatile("mrs %0, mair_el2" : "=r" (cpu->mair));
+		asm volatile("mrs %0, tcr_el2" : "=r" (cpu->tcr));
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (cpu->ttbr));
+		asm volatile("mrs %0, sctlr_el2" : "=r" (cpu->sctlr));
+	} else {
+		asm volatile("mrs %0, vbar_el1" : "=r" (cpu->vbar));
+		asm volatile("mrs %0, mair_el1" : "=r" (cpu->mair));
+		asm volatile("mrs %0, tcr_el1" : "=r" (cpu->tcr));
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (cpu->ttbr));
+		asm volatile("mrs %0, sctlr_el1" : "=r" (cpu->sctlr));
+	}
+}
+
+int arch_mp_job_start(int cpu, void (*entry)(void))
+{
+	struct mp_job_cpu *mcpu = &mp_job_cpu[cpu];
+	struct pt_regs regs;
+	void *stack;
+
+	/* These are used by mp_job_secondary_entry() */
+	BUILD_BUG_ON(offsetof(struct mp_job_cpu, vbar) != 8);
+	BUILD_BUG_ON(offsetof(struct mp_job_cpu, tcr) != 24);
+	BUILD_BUG_ON(offsetof(struct mp_job_cpu, sctlr) != 40);
+	BUILD_BUG_ON(offsetof(struct mp_job_cpu, gd) != 48);
+
+	if (!mcpu->stack) {
+		stack = memalign(16, MP_JOB_STACK_SIZE);
+		if (!stack)
+			return -ENOMEM;
+		mcpu->stack = (ulong)stack + MP_JOB_STACK_SIZE;
+	}
+	mp_job_save_el(mcpu);
+	mcpu->gd = (ulong)gd;
+	mcpu->entry = (ulong)entry;
+
+	/* The CPU starts with its MMU and caches off */
+	flush_dcache_range((ulong)mcpu, (ulong)(mcpu + 1));
+
+	regs.regs[0] = ARM_PSCI_0_2_FN64_CPU_ON;
+	regs.regs[1] = mcpu->mpidr;
+	regs.regs[2] = (ulong)mp_job_secondary_entry;
+	regs.regs[3] = (ulong)mcpu;
+	smc_call(&regs);
+	switch ((int)regs.regs[0]) {
+	case ARM_PSCI_RET_SUCCESS:
+		return 0;
+	case ARM_PSCI_RET_ALREADY_ON:
+	case ARM_PSCI_RET_ON_PENDING:
+		return -EBUSY;
+	default:
+		return -EIO;
+	}
+}
+
+int arch_mp_job_stop(int cpu)
+{
+	struct pt_regs regs;
+	ulong start;
+
+	start = get_timer(0);
+	do {
+		regs.regs[0] = ARM_PSCI_0_2_FN64_AFFINITY_INFO;
+		regs.regs[1] = mp_job_cpu[cpu].mpidr;
+		regs.regs[2] = 0;
+		smc_call(&regs);
+		if (regs.regs[0] == PSCI_AFFINITY_LEVEL_OFF)
+			return 0;
+	} while (get_timer(start) < MP_JOB_STOP_TIMEOUT_MS);
+
+	return -ETIMEDOUT;
+}
@@ -129,6 +129,16 @@ struct sunxi_mmc {
 #define SUNXI_MMC_IDIE_TXIRQ		(0x1 << 0)
 #define SUNXI_MMC_IDIE_RXIRQ		(0x1 << 1)
 
+#define SUNXI_MMC_IDST_FATAL_BUS_ERROR	(0x1 << 2)
+#define SUNXI_MMC_IDST_DES_UNAVAILABLE	(0x1 << 4)
+#define SUNXI_MMC_IDST_ABNORMAL_INT_SUM	(0x1 << 9)
+#define SUNXI_MMC_IDST_ERROR		(SUNXI_MMC_IDST_FATAL_BUS_ERROR |\
+					 SUNXI_MMC_IDST_DES_UNAVAILABLE |\
+					 SUNXI_MMC_IDST_ABNORMAL_INT_SUM)
+
+/* RX/TX watermarks and burst size used by the Linux driver for IDMAC */
+#define SUNXI_MMC_FTRGLEVEL_IDMA	0x20070008
+
 #define SUNXI_MMC_COMMON_CLK_GATE		(1 << 16)
 #define SUNXI_MMC_COMMON_RESET			(1 << 18)
 
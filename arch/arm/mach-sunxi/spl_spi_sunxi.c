@@ -9,6 +9,8 @@
 #include <spl.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
+#include <asm/arch/clock.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 #include <linux/libfdt.h>
@@ -18,15 +20,20 @@
 #endif
 
 /*
- * This is a very simple U-Boot image loading implementation, trying to
- * replicate what the boot ROM is doing when loading the SPL. Because we
- * know the exact pins where the SPI Flash is connected and also know
- * that the Read Data Bytes (03h) command is supported, the hardware
- * configuration is very simple and we don't need the extra flexibility
- * of the SPI framework. Moreover, we rely on the default settings of
- * the SPI controler hardware registers and only adjust what needs to
- * be changed. This is good for the code size and this implementation
- * adds less than 400 bytes to the SPL.
+ * This is a very simple U-Boot image loading implementation, based on
+ * what the boot ROM is doing when loading the SPL. Because we know the
+ * exact pins where the SPI Flash is connected and also know that the
+ * Fast Read (0Bh) command is supported, the hardware configuration is
+ * very simple and we don't need the extra flexibility of the SPI
+ * framework. Moreover, we rely on the default settings of the SPI
+ * controler hardware registers and only adjust what needs to be changed.
+ * This is good for the code size and this implementation adds about
+ * 600 bytes to the SPL.
+ *
+ * Unlike the boot ROM, each read is done with a single command as long as
+ * the burst counter allows, draining the RX FIFO while the data comes in.
+ * The SPI clock is set by CONFIG_SPL_SPI_SUNXI_FREQ and the sun6i variant
+ * can receive on two lines with the Fast Read Dual Output (3Bh) command.
  *
  * There are two variants of the SPI controller in Allwinner SoCs:
  * A10/A13/A20 (sun4i variant) and everything else (sun6i variant).
@@ -53,6 +60,7 @@
 #define SUN4I_CTL_TF_RST            BIT(8)
 #define SUN4I_CTL_RF_RST            BIT(9)
 #define SUN4I_CTL_XCH               BIT(10)
+#define SUN4I_CTL_TP                BIT(18)
 
 /*****************************************************************************/
 /* SUN6I variant of the SPI controller                                       */
@@ -70,8 +78,10 @@
 
 #define SUN6I_CTL_ENABLE            BIT(0)
 #define SUN6I_CTL_MASTER            BIT(1)
+#define SUN6I_CTL_TP                BIT(7)
 #define SUN6I_CTL_SRST              BIT(31)
 #define SUN6I_TCR_XCH               BIT(31)
+#define SUN6I_BCC_DRM               BIT(28)
 
 /*****************************************************************************/
 
@@ -87,8 +97,12 @@
 #define AHB_RESET_SPI0_SHIFT        20
 #define AHB_GATE_OFFSET_SPI0        20
 
-#define SPI0_CLK_DIV_BY_2           0x1000
-#define SPI0_CLK_DIV_BY_4           0x1001
+#define SPI0_CLK_DRS                BIT(12)  /* Divide by 2 * (CDR2 + 1) */
+#define SPI0_CLK_CDR2_MAX           0xff
+
+#define CCM_SPI0_CLK_ENABLE         BIT(31)
+#define CCM_SPI0_CLK_PLL6           (1 << 24)
+#define CCM_SPI0_CLK_M_MAX          16
 
 /*****************************************************************************/
 
@@ -138,8 +152,30 @@ static uintptr_t spi0_base_address(void)
 }
 
 /*
- * Setup 6 MHz from OSC24M (because the BROM is doing the same).
+ * Set the SPI clock to CONFIG_SPL_SPI_SUNXI_FREQ or the fastest below it.
+ * The module clock comes from OSC24M, as the BROM uses, or from PLL_PERIPH0
+ * for more than 12 MHz. The controller then divides it by at least 2.
  */
+static void spi0_set_clock(uintptr_t base)
+{
+	uint freq = CONFIG_SPL_SPI_SUNXI_FREQ;
+	uint mod_freq = 24000000;
+	u32 src = 0, m = 1, cdr2;
+
+	if (freq > mod_freq / 2) {
+		src = CCM_SPI0_CLK_PLL6;
+		m = min_t(u32, DIV_ROUND_UP(clock_get_pll6(), 2 * freq),
+			  CCM_SPI0_CLK_M_MAX);
+		mod_freq = clock_get_pll6() / m;
+	}
+	cdr2 = min_t(u32, DIV_ROUND_UP(mod_freq, 2 * freq) - 1,
+		     SPI0_CLK_CDR2_MAX);
+
+	writel(SPI0_CLK_DRS | cdr2, base + (is_sun6i_gen_spi() ?
+					    SUN6I_SPI0_CCTL : SUN4I_SPI0_CCTL));
+	writel(CCM_SPI0_CLK_ENABLE | src | (m - 1), CCM_SPI0_CLK);
+}
+
 static void spi0_enable_clock(void)
 {
 	uintptr_t base = spi0_base_address();
@@ -155,23 +191,28 @@ static void spi0_enable_clock(void)
 	if (!IS_ENABLED(CONFIG_MACH_SUN50I_H6))
 		setbits_le32(CCM_AHB_GATING0, (1 << AHB_GATE_OFFSET_SPI0));
 
-	/* Divide by 4 */
-	writel(SPI0_CLK_DIV_BY_4, base + (is_sun6i_gen_spi() ?
-				  SUN6I_SPI0_CCTL : SUN4I_SPI0_CCTL));
-	/* 24MHz from OSC24M */
-	writel((1 << 31), CCM_SPI0_CLK);
+	spi0_set_clock(base);
 
 	if (is_sun6i_gen_spi()) {
-		/* Enable SPI in the master mode and do a soft reset */
+		/*
+		 * Enable SPI in the master mode with transmit pause, so that
+		 * the clock stops while the RX FIFO is full, and do a soft
+		 * reset
+		 */
 		setbits_le32(base + SUN6I_SPI0_GCR, SUN6I_CTL_MASTER |
-			     SUN6I_CTL_ENABLE | SUN6I_CTL_SRST);
+			     SUN6I_CTL_ENABLE | SUN6I_CTL_TP |
+			     SUN6I_CTL_SRST);
 		/* Wait for completion */
 		while (readl(base + SUN6I_SPI0_GCR) & SUN6I_CTL_SRST)
 			;
 	} else {
-		/* Enable SPI in the master mode and reset FIFO */
+		/*
+		 * Enable SPI in the master mode with transmit pause, as above,
+		 * and reset FIFO
+		 */
 		setbits_le32(base + SUN4I_SPI0_CTL, SUN4I_CTL_MASTER |
 						    SUN4I_CTL_ENABLE |
+						    SUN4I_CTL_TP |
 						    SUN4I_CTL_TF_RST |
 						    SUN4I_CTL_RF_RST);
 	}
@@ -184,10 +225,10 @@ static void spi0_disable_clock(void)
 	/* Disable the SPI0 controller */
 	if (is_sun6i_gen_spi())
 		clrbits_le32(base + SUN6I_SPI0_GCR, SUN6I_CTL_MASTER |
-					     SUN6I_CTL_ENABLE);
+					     SUN6I_CTL_ENABLE | SUN6I_CTL_TP);
 	else
 		clrbits_le32(base + SUN4I_SPI0_CTL, SUN4I_CTL_MASTER |
-					     SUN4I_CTL_ENABLE);
+					     SUN4I_CTL_ENABLE | SUN4I_CTL_TP);
 
 	/* Disable the SPI0 clock */
 	writel(0, CCM_SPI0_CLK);
@@ -230,7 +271,11 @@ static void spi0_deinit(void)
 
 /*****************************************************************************/
 
-#define SPI_READ_MAX_SIZE 60 /* FIFO size, minus 4 bytes of the header */
+/* The burst counter has 24 bits, which must also cover the header */
+#define SPI_READ_MAX_SIZE ((1 << 24) - 16)
+
+/* Command, 3 address bytes and 8 dummy clocks */
+#define SPI_READ_HDR_SIZE 5
 
 static void sunxi_spi0_read_data(u8 *buf, u32 addr, u32 bufsize,
 				 ulong spi_ctl_reg,
@@ -242,30 +287,46 @@ static void sunxi_spi0_read_data(u8 *buf, u32 addr, u32 bufsize,
 				 ulong spi_tc_reg,
 				 ulong spi_bcc_reg)
 {
-	writel(4 + bufsize, spi_bc_reg); /* Burst counter (total bytes) */
-	writel(4, spi_tc_reg);           /* Transfer counter (bytes to send) */
-	if (spi_bcc_reg)
-		writel(4, spi_bcc_reg);  /* SUN6I also needs this */
-
-	/* Send the Read Data Bytes (03h) command header */
-	writeb(0x03, spi_tx_reg);
+	bool dual = spi_bcc_reg && IS_ENABLED(CONFIG_SPL_SPI_SUNXI_DUAL_READ);
+	u32 skip = SPI_READ_HDR_SIZE;
+	u32 avail;
+
+	writel(SPI_READ_HDR_SIZE + bufsize, spi_bc_reg); /* Burst counter */
+	writel(SPI_READ_HDR_SIZE, spi_tc_reg);	/* Bytes to send */
+	if (spi_bcc_reg)			/* SUN6I also needs this */
+		writel(SPI_READ_HDR_SIZE | (dual ? SUN6I_BCC_DRM : 0),
+		       spi_bcc_reg);
+
+	/* Send the Fast Read (0Bh) or Fast Read Dual Output (3Bh) header */
+	writeb(dual ? 0x3b : 0x0b, spi_tx_reg);
 	writeb((u8)(addr >> 16), spi_tx_reg);
 	writeb((u8)(addr >> 8), spi_tx_reg);
 	writeb((u8)(addr), spi_tx_reg);
+	writeb(0, spi_tx_reg);
 
 	/* Start the data transfer */
 	setbits_le32(spi_ctl_reg, spi_ctl_xch_bitmask);
 
-	/* Wait until everything is received in the RX FIFO */
-	while ((readl(spi_fifo_reg) & 0x7F) < 4 + bufsize)
-		;
-
-	/* Skip 4 bytes */
-	readl(spi_rx_reg);
-
-	/* Read the data */
-	while (bufsize-- > 0)
-		*buf++ = readb(spi_rx_reg);
+	/*
+	 * Take the data out of the RX FIFO as it comes in, skipping the bytes
+	 * received while the header was sent. With transmit pause enabled
+	 * by spi0_enable_clock(), the controller stops the clock while the
+	 * FIFO is full, so the transfer can be as long as the burst counter
+	 * allows.
+	 */
+	while (bufsize > 0) {
+		avail = readl(spi_fifo_reg) & 0x7F;
+		for (; skip && avail; skip--, avail--)
+			readb(spi_rx_reg);
+		for (; avail >= 4 && bufsize >= 4; avail -= 4, bufsize -= 4) {
+			put_unaligned_le32(readl(spi_rx_reg), buf);
+			buf += 4;
+		}
+		if (bufsize < 4) {
+			for (; avail && bufsize; avail--, bufsize--)
+				*buf++ = readb(spi_rx_reg);
+		}
+	}
 
 	/* tSHSL time is up to 100 ns in various SPI flash datasheets */
 	udelay(1);
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Secondary CPUs for compute jobs, emulated with host threads
+ */
+
+#include <common.h>
+#include <mp_job.h>
+#include <os.h>
+
+static void *mp_job_threads[CONFIG_MP_JOBS_CPUS];
+
+/* The entry function of each thread, passed by reference */
+static void (*mp_job_entry[CONFIG_MP_JOBS_CPUS])(void);
+
+static void mp_job_thread(void *arg)
+{
+	void (**entry)(void) = arg;
+
+	(*entry)();
+}
+
+int arch_mp_job_cpus(void)
+{
+	return CONFIG_MP_JOBS_CPUS;
+}
+
+int arch_mp_job_start(int cpu, void (*entry)(void))
+{
+	mp_job_entry[cpu] = entry;
+
+	return os_thread_start(mp_job_thread, &mp_job_entry[cpu],
+			       &mp_job_threads[cpu]);
+}
+
+int arch_mp_job_stop(int cpu)
+{
+	int ret;
+
+	ret = os_thread_join(mp_job_threads[cpu]);
+	mp_job_threads[cpu] = NULL;
+
+	return ret;
+}
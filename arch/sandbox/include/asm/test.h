@@ -108,6 +108,16 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_flash_set_max_xfer_blk() - limit the size of reads from a USB flash
+ *
+ * Reads of more blocks than this fail, like they do on some devices.
+ *
+ * @dev:	USB flash emulator to adjust
+ * @blocks:	Largest number of blocks in one read command, 0 for no limit
+ */
+void sandbox_flash_set_max_xfer_blk(struct udevice *dev, int blocks);
+
 /**
  * sandbox_osd_get_mem() - get the internal memory of a sandbox OSD
  *
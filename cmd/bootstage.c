@@ -6,6 +6,9 @@
 #include <common.h>
 #include <bootstage.h>
 #include <command.h>
+#include <env.h>
+#include <mapmem.h>
+#include <linux/sizes.h>
 
 static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 			       char *const argv[])
@@ -59,10 +62,47 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+static int do_bootstage_export(struct cmd_tbl *cmdtp, int flag, int argc,
+			       char *const argv[])
+{
+	ulong addr, size = SZ_1M;
+	char *endp;
+	void *buf;
+	int ret;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	addr = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return CMD_RET_USAGE;
+	if (argc > 2) {
+		size = simple_strtoul(argv[2], &endp, 16);
+		if (*argv[2] == 0 || *endp != 0)
+			return CMD_RET_USAGE;
+	}
+
+	buf = map_sysmem(addr, size);
+	ret = bootstage_export(buf, size);
+	unmap_sysmem(buf);
+	if (ret < 0) {
+		printf("Not enough space for timeline (size %lx)\n", size);
+		return CMD_RET_FAILURE;
+	}
+	printf("%x bytes written\n", ret);
+	env_set_hex("filesize", ret);
+
+	return 0;
+}
+#endif
+
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+	U_BOOT_CMD_MKENT(export, 3, 0, do_bootstage_export, "", ""),
+#endif
 };
 
 /*
@@ -93,4 +133,7 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+	"\nexport <addr> [<size>]      - Write timeline as Chrome trace JSON"
+#endif
 );
@@ -8,9 +8,12 @@
 #include <blk.h>
 #include <command.h>
 #include <console.h>
+#include <dm.h>
 #include <mmc.h>
 #include <part.h>
+#include <time.h>
 #include <sparse_format.h>
+#include <linux/math64.h>
 #include <image-sparse.h>
 
 static int curr_device = -1;
@@ -349,6 +352,173 @@ static int do_mmc_read(struct cmd_tbl *cmdtp, int flag,
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
 
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+enum {
+	BENCH_SEQ,
+	BENCH_RANDOM,
+	BENCH_QUEUED,
+
+	BENCH_COUNT,
+
+	/* Number of requests kept in progress by BENCH_QUEUED */
+	BENCH_DEPTH	= 4,
+};
+
+/* Read without going through the block cache, which would skew the results */
+static ulong mmc_bench_read(struct blk_desc *desc, lbaint_t start,
+			    lbaint_t blkcnt, void *buf)
+{
+#if CONFIG_IS_ENABLED(BLK)
+	return blk_get_ops(desc->bdev)->read(desc->bdev, start, blkcnt, buf);
+#else
+	return desc->block_read(desc, start, blkcnt, buf);
+#endif
+}
+
+#if CONFIG_IS_ENABLED(BLK)
+/*
+ * Read @reqs requests of @len blocks, keeping BENCH_DEPTH in progress.
+ *
+ * These go through blk_submit() and so through the block cache, which is
+ * emptied first so that no request is served from an earlier pass.
+ */
+static int mmc_bench_queued(struct blk_desc *desc, void *buf, u32 blk,
+			    u32 reqs, u32 len)
+{
+	struct blk_req req[BENCH_DEPTH];
+	struct blk_req *r;
+	u32 i, sent = 0;
+	int ret = 0;
+
+	blkcache_invalidate(desc->if_type, desc->devnum);
+	for (i = 0; i < reqs + BENCH_DEPTH; i++) {
+		r = &req[i % BENCH_DEPTH];
+
+		/* Finish the request which had this slot, if it was sent */
+		if (i >= BENCH_DEPTH && i - BENCH_DEPTH < sent &&
+		    blk_wait(desc, r) != len)
+			ret = -EIO;
+		if (i < reqs && !ret) {
+			memset(r, '\0', sizeof(*r));
+			r->start = blk + i * len;
+			r->blkcnt = len;
+			r->buffer = buf + (i % BENCH_DEPTH) * len * desc->blksz;
+			ret = blk_submit(desc, r);
+			if (!ret)
+				sent++;
+		}
+	}
+
+	return ret;
+}
+#else
+static int mmc_bench_queued(struct blk_desc *desc, void *buf, u32 blk,
+			    u32 reqs, u32 len)
+{
+	return -ENOSYS;
+}
+#endif
+
+/**
+ * mmc_bench_run() - Read an area in requests of @len blocks
+ *
+ * @desc:	Block device to read
+ * @pattern:	BENCH_...
+ * @buf:	Buffer of at least @cnt blocks
+ * @blk:	First block of the area
+ * @cnt:	Number of blocks in the area, a multiple of @len
+ * @len:	Number of blocks in each request
+ * @return time taken in microseconds, or 0 on error
+ */
+static ulong mmc_bench_run(struct blk_desc *desc, int pattern, void *buf,
+			   u32 blk, u32 cnt, u32 len)
+{
+	u32 i, start, reqs = cnt / len;
+	u32 seed = 1;
+	ulong base;
+
+	base = timer_get_us();
+	if (pattern == BENCH_QUEUED) {
+		if (mmc_bench_queued(desc, buf, blk, reqs, len))
+			return 0;
+	} else {
+		for (i = 0; i < reqs; i++) {
+			start = blk + i * len;
+			if (pattern == BENCH_RANDOM) {
+				seed = seed * 1103515245 + 12345;
+				start = blk + (seed >> 8) % reqs * len;
+			}
+			if (mmc_bench_read(desc, start, len, buf) != len)
+				return 0;
+		}
+	}
+
+	return max(timer_get_us() - base, 1UL);
+}
+
+static int do_mmc_bench(struct cmd_tbl *cmdtp, int flag,
+			int argc, char *const argv[])
+{
+	static const char *const pattern_name[BENCH_COUNT] = {
+		"sequential", "random", "queued",
+	};
+	struct blk_desc *desc;
+	struct mmc *mmc;
+	u32 blk, cnt, len;
+	void *addr;
+	u64 bytes;
+	ulong us;
+	int pattern;
+
+	if (argc != 4)
+		return CMD_RET_USAGE;
+
+	addr = (void *)simple_strtoul(argv[1], NULL, 16);
+	blk = simple_strtoul(argv[2], NULL, 16);
+	cnt = simple_strtoul(argv[3], NULL, 16);
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+	desc = mmc_get_blk_desc(mmc);
+	if (!cnt || blk + cnt > desc->lba)
+		return CMD_RET_USAGE;
+
+	printf("MMC bench: dev # %d, block # %d, count %d, max transfer %d\n",
+	       curr_device, blk, cnt, mmc->cfg->b_max);
+	printf("%8s", "blocks");
+	for (pattern = 0; pattern < BENCH_COUNT; pattern++)
+		printf("%16s", pattern_name[pattern]);
+	printf("\n");
+
+	for (len = 1; len <= cnt; len <<= 1) {
+		printf("%8d", len);
+		for (pattern = 0; pattern < BENCH_COUNT; pattern++) {
+			/* Queued requests each need their part of the buffer */
+			if (pattern == BENCH_QUEUED &&
+			    (!CONFIG_IS_ENABLED(BLK) || len * BENCH_DEPTH > cnt)) {
+				printf("%16s", "-");
+				continue;
+			}
+			us = mmc_bench_run(desc, pattern, addr, blk,
+					   cnt / len * len, len);
+			if (!us) {
+				printf("\nRead failed\n");
+				return CMD_RET_FAILURE;
+			}
+			bytes = (u64)(cnt / len * len) * desc->blksz;
+			bytes = div_u64(bytes * 10, us);
+			printf("%9llu.%llu MB/s", bytes / 10, bytes % 10);
+		}
+		printf("\n");
+		if (ctrlc())
+			return CMD_RET_FAILURE;
+	}
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
 				 lbaint_t blkcnt, const void *buffer)
@@ -940,6 +1110,9 @@ static struct cmd_tbl cmd_mmc[] = {
 #endif
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	U_BOOT_CMD_MKENT(swrite, 3, 0, do_mmc_sparse_write, "", ""),
+#endif
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+	U_BOOT_CMD_MKENT(bench, 4, 0, do_mmc_bench, "", ""),
 #endif
 	U_BOOT_CMD_MKENT(rescan, 1, 1, do_mmc_rescan, "", ""),
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
@@ -1000,6 +1173,9 @@ U_BOOT_CMD(
 	"mmc swrite addr blk#\n"
 #endif
 	"mmc erase blk# cnt\n"
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+	"mmc bench addr blk# cnt - time reads of increasing size\n"
+#endif
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <div64.h>
 #include <dm.h>
 #include <flash.h>
@@ -14,9 +15,12 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
+#include <time.h>
 #include <asm/cache.h>
 #include <jffs2/jffs2.h>
+#include <linux/math64.h>
 #include <linux/mtd/mtd.h>
 
 #include <asm/io.h>
@@ -546,6 +550,122 @@ static int do_spi_flash_test(int argc, char *const argv[])
 }
 #endif /* CONFIG_CMD_SF_TEST */
 
+#ifdef CONFIG_CMD_SF_BENCH
+/**
+ * spi_flash_bench_run() - Read an area of flash in requests of @len bytes
+ *
+ * @flash:	SPI flash to read
+ * @buf:	Buffer of at least @size bytes
+ * @offset:	Offset of the area within flash
+ * @size:	Size of the area, a multiple of @len
+ * @len:	Size of each request
+ * @return time taken in microseconds, or 0 on error
+ */
+static ulong spi_flash_bench_run(struct spi_flash *flash, u8 *buf,
+				 ulong offset, ulong size, ulong len)
+{
+	ulong base, pos;
+
+	base = timer_get_us();
+	for (pos = 0; pos < size; pos += len) {
+		if (spi_flash_read(flash, offset + pos, len, buf + pos))
+			return 0;
+	}
+
+	return max(timer_get_us() - base, 1UL);
+}
+
+static void spi_flash_bench_show(ulong size, ulong us)
+{
+	u64 speed = div_u64((u64)size * 10, us);	/* 0.1 MB/s */
+
+	printf("%11llu.%llu MB/s", speed / 10, speed % 10);
+}
+
+static int do_spi_flash_bench(int argc, char *const argv[])
+{
+	struct spi_mem_dirmap_desc *rdesc = flash->dirmap.rdesc;
+	enum spi_nor_protocol proto = flash->read_proto;
+	unsigned long addr, offset, size, len, area;
+	uint8_t *buf, *vbuf;
+	char *endp;
+	ulong us;
+	int ret = 1;
+
+	if (argc < 4)
+		return -1;
+	addr = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return -1;
+	offset = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0)
+		return -1;
+	size = simple_strtoul(argv[3], &endp, 16);
+	if (*argv[3] == 0 || *endp != 0 || !size)
+		return -1;
+	if (offset + size > flash->size) {
+		printf("ERROR: attempting %s past flash size (%#x)\n",
+		       argv[0], flash->size);
+		return 1;
+	}
+
+	/* Reads through the direct mapping go here, to be checked */
+	vbuf = memalign(ARCH_DMA_MINALIGN, size);
+	if (!vbuf) {
+		printf("Cannot allocate memory (%lu bytes)\n", size);
+		return 1;
+	}
+	buf = map_sysmem(addr, size);
+
+	printf("SF bench: %#lx bytes @ %#lx, read %02xh (%d-%d-%d) at %u Hz, dirmap: %s\n",
+	       size, offset, flash->read_opcode,
+	       spi_nor_get_protocol_inst_nbits(proto),
+	       spi_nor_get_protocol_addr_nbits(proto),
+	       spi_nor_get_protocol_data_nbits(proto), flash->spi->speed,
+	       !rdesc ? "none" : rdesc->nodirmap ? "emulated" : "controller");
+	printf("%8s%19s%19s\n", "bytes", "spi-mem ops", "dirmap");
+
+	for (len = min(size, 0x1000UL); len <= size; len <<= 1) {
+		area = size / len * len;
+		printf("%8lu", len);
+
+		flash->dirmap.rdesc = NULL;
+		us = spi_flash_bench_run(flash, buf, offset, area, len);
+		flash->dirmap.rdesc = rdesc;
+		if (!us)
+			goto read_err;
+		spi_flash_bench_show(area, us);
+
+		if (rdesc) {
+			us = spi_flash_bench_run(flash, vbuf, offset, area,
+						 len);
+			if (!us)
+				goto read_err;
+			spi_flash_bench_show(area, us);
+			if (memcmp(buf, vbuf, area)) {
+				printf("\nVerify failed, dirmap reads differ\n");
+				goto done;
+			}
+		} else {
+			printf("%19s", "-");
+		}
+		printf("\n");
+		if (ctrlc())
+			goto done;
+	}
+	ret = 0;
+	goto done;
+
+read_err:
+	printf("\nRead failed\n");
+done:
+	unmap_sysmem(buf);
+	free(vbuf);
+
+	return ret;
+}
+#endif /* CONFIG_CMD_SF_BENCH */
+
 static int do_spi_flash(struct cmd_tbl *cmdtp, int flag, int argc,
 			char *const argv[])
 {
@@ -581,6 +701,10 @@ static int do_spi_flash(struct cmd_tbl *cmdtp, int flag, int argc,
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
 #endif
 	else
 		ret = -1;
@@ -600,6 +724,13 @@ usage:
 #define SF_TEST_HELP
 #endif
 
+#ifdef CONFIG_CMD_SF_BENCH
+#define SF_BENCH_HELP "\nsf bench addr offset len	" \
+		"- time reads with and without the direct mapping"
+#else
+#define SF_BENCH_HELP
+#endif
+
 U_BOOT_CMD(
 	sf,	5,	1,	do_spi_flash,
 	"SPI flash sub-system",
@@ -620,4 +751,5 @@ U_BOOT_CMD(
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
+	SF_BENCH_HELP
 );
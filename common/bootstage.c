@@ -25,6 +25,22 @@ enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
 };
 
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+enum {
+	SPAN_COUNT	= CONFIG_BOOTSTAGE_TIMELINE_COUNT,
+	SPAN_NAME_LEN	= 24,
+};
+
+/* An event of the timeline, see bootstage_span() */
+struct bootstage_span {
+	u32 start_us;
+	u32 dur_us;
+	ulong bytes;
+	u8 cat;			/* enum bootstage_span_cat */
+	char name[SPAN_NAME_LEN];
+};
+#endif
+
 struct bootstage_record {
 	ulong time_us;
 	uint32_t start_us;
@@ -37,6 +53,11 @@ struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+	struct bootstage_span *span;	/* Allocated on first use */
+	uint span_count;
+	uint span_dropped;		/* Events not recorded (no space) */
+#endif
 };
 
 enum {
@@ -358,6 +379,184 @@ void bootstage_report(void)
 	}
 }
 
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+static const char *const span_cat_name[BOOTSTAGE_SPAN_COUNT] = {
+	[BOOTSTAGE_SPAN_PROBE]		= "probe",
+	[BOOTSTAGE_SPAN_BLK_READ]	= "blk_read",
+	[BOOTSTAGE_SPAN_BLK_WRITE]	= "blk_write",
+	[BOOTSTAGE_SPAN_NET]		= "net",
+};
+
+/* Track (thread ID) of each kind of event; the boot stages use track 0 */
+static const char *const span_track_name[] = {
+	"bootstage", "probe", "blk", "net",
+};
+
+static int span_track(enum bootstage_span_cat cat)
+{
+	switch (cat) {
+	case BOOTSTAGE_SPAN_PROBE:
+		return 1;
+	case BOOTSTAGE_SPAN_BLK_READ:
+	case BOOTSTAGE_SPAN_BLK_WRITE:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+ulong bootstage_span_start(void)
+{
+	return timer_get_boot_us();
+}
+
+void bootstage_span(enum bootstage_span_cat cat, const char *name,
+		    ulong start_us, ulong bytes)
+{
+	struct bootstage_data *data = gd->bootstage;
+	ulong now = timer_get_boot_us();
+	struct bootstage_span *span;
+
+	/* The timeline is not kept across relocation */
+	if (!data || !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return;
+	if (!data->span) {
+		data->span = calloc(SPAN_COUNT, sizeof(*data->span));
+		if (!data->span) {
+			data->span_dropped++;
+			return;
+		}
+	}
+	if (data->span_count >= SPAN_COUNT) {
+		data->span_dropped++;
+		return;
+	}
+
+	span = &data->span[data->span_count++];
+	span->start_us = start_us;
+	span->dur_us = now - start_us;
+	span->bytes = bytes;
+	span->cat = cat;
+	strlcpy(span->name, name ? name : "", sizeof(span->name));
+}
+
+/**
+ * Append formatted text to a memory buffer
+ *
+ * This works like append_data(): the buffer pointer is incremented even if
+ * there is no space.
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param fmt	printf()-style format string
+ */
+static void append_fmt(char **ptrp, char *end, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(*ptrp, *ptrp < end ? end - *ptrp : 0, fmt, args);
+	va_end(args);
+	*ptrp += len;
+}
+
+/* Append a string as a JSON string, with quotes */
+static void append_json_str(char **ptrp, char *end, const char *str)
+{
+	append_fmt(ptrp, end, "\"");
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			append_fmt(ptrp, end, "\\%c", *str);
+		else if ((uchar)*str < ' ')
+			append_fmt(ptrp, end, "\\u%04x", *str);
+		else
+			append_fmt(ptrp, end, "%c", *str);
+	}
+	append_fmt(ptrp, end, "\"");
+}
+
+/* Append a complete ("X") event, without its args */
+static void append_event(char **ptrp, char *end, const char *name,
+			 const char *cat, int tid, ulong ts, ulong dur)
+{
+	append_fmt(ptrp, end, "{\"name\":");
+	append_json_str(ptrp, end, name);
+	append_fmt(ptrp, end,
+		   ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%d",
+		   cat, ts, dur, tid);
+}
+
+int bootstage_export(char *buf, int size)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+	struct bootstage_span *span;
+	char *ptr = buf, *end = buf + size;
+	char name[20];
+	ulong prev;
+	int i;
+
+	/* The JSON parts are each on a line, so tools can join exports */
+	append_fmt(&ptr, end, "{\"traceEvents\":[\n");
+	for (i = 0; i < ARRAY_SIZE(span_track_name); i++)
+		append_fmt(&ptr, end,
+			   "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+			   i, span_track_name[i]);
+
+	/* Each stage runs from the previous mark to its own */
+	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
+	prev = 0;
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		if (rec->start_us)
+			continue;
+		if (rec->id != BOOTSTAGE_ID_AWAKE) {
+			append_event(&ptr, end,
+				     get_record_name(name, sizeof(name), rec),
+				     "stage", 0, prev, rec->time_us - prev);
+			append_fmt(&ptr, end, "},\n");
+		}
+		prev = rec->time_us;
+	}
+
+	for (i = 0, span = data->span; span && i < data->span_count;
+	     i++, span++) {
+		append_event(&ptr, end, span->name, span_cat_name[span->cat],
+			     span_track(span->cat), span->start_us,
+			     span->dur_us);
+		if (span->bytes)
+			append_fmt(&ptr, end, ",\"args\":{\"bytes\":%lu}",
+				   span->bytes);
+		append_fmt(&ptr, end, "},\n");
+	}
+
+	/* Drop the last comma, which JSON does not allow */
+	if (ptr - buf >= 2 && ptr <= end && ptr[-2] == ',') {
+		ptr -= 2;
+		append_fmt(&ptr, end, "\n");
+	}
+	append_fmt(&ptr, end, "],\n");
+
+	append_fmt(&ptr, end,
+		   "\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":\"%u\"",
+		   data->span_dropped);
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		if (!rec->start_us)
+			continue;
+		append_fmt(&ptr, end, ",");
+		append_json_str(&ptr, end,
+				get_record_name(name, sizeof(name), rec));
+		append_fmt(&ptr, end, ":\"%lu us\"", rec->time_us);
+	}
+	append_fmt(&ptr, end, "}}\n");
+
+	if (ptr >= end)
+		return -ENOSPC;
+
+	return ptr - buf;
+}
+#endif /* ENABLE_BOOTSTAGE_TIMELINE */
+
 /**
  * Append data to a memory buffer
  *
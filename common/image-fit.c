@@ -18,10 +18,14 @@
 #include <linux/kconfig.h>
 #include <common.h>
 #include <errno.h>
+#include <gzip.h>
+#include <hash.h>
 #include <log.h>
 #include <mapmem.h>
+#include <mp_job.h>
 #include <asm/io.h>
 #include <malloc.h>
+#include <linux/sizes.h>
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
@@ -1216,8 +1220,204 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+/**
+ * struct fit_prehash - image hashed by a job
+ *
+ * @ih:		Hashes of the image
+ * @noffset:	Offset of the image node
+ * @data:	Image data
+ * @size:	Size of the image data
+ */
+struct fit_prehash {
+	struct fit_image_hash ih;
+	int noffset;
+	const void *data;
+	size_t size;
+};
+
+#if FIT_IMAGE_ENABLE_LOAD_HASH
+/* Maximum number of images in a FIT which are hashed in parallel */
+#define FIT_PREHASH_MAX_IMAGES	8
+
+int fit_image_hash_start(const void *fit, int noffset,
+			 struct fit_image_hash *ih)
+{
+	struct hash_algo *algo;
+	char *algo_name;
+	int node, ignore;
+	int ret;
+
+	memset(ih, '\0', sizeof(*ih));
+	ih->fit = fit;
+	fdt_for_each_subnode(node, fit, noffset) {
+		if (strncmp(fit_get_name(fit, node, NULL), FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (IMAGE_ENABLE_IGNORE) {
+			fit_image_hash_get_ignore(fit, node, &ignore);
+			if (ignore)
+				continue;
+		}
+		if (ih->count == FIT_IMAGE_HASH_MAX ||
+		    fit_image_hash_get_algo(fit, node, &algo_name) ||
+		    hash_progressive_lookup_algo(algo_name, &algo)) {
+			ret = -EPROTONOSUPPORT;
+			goto err;
+		}
+		if (algo->hash_init(algo, &ih->hash[ih->count].ctx)) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		ih->hash[ih->count].algo = algo;
+		ih->hash[ih->count++].node = node;
+	}
+
+	return 0;
+
+err:
+	fit_image_hash_abort(ih);
+	return ret;
+}
+
+int fit_image_hash_update(struct fit_image_hash *ih, const void *buf,
+			  ulong len)
+{
+	int i;
+
+	for (i = 0; i < ih->count; i++) {
+		struct hash_algo *algo = ih->hash[i].algo;
+
+		if (algo->hash_update(algo, ih->hash[i].ctx, buf, len, 0)) {
+			/* The context is freed on error */
+			ih->hash[i].algo = NULL;
+			fit_image_hash_abort(ih);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+void fit_image_hash_end(struct fit_image_hash *ih)
+{
+	struct hash_algo *algo;
+	int i;
+
+	for (i = 0; i < ih->count; i++) {
+		algo = ih->hash[i].algo;
+		ih->hash[i].algo = NULL;
+		if (algo->hash_finish(algo, ih->hash[i].ctx,
+				      ih->hash[i].value,
+				      sizeof(ih->hash[i].value)))
+			continue;
+		/* FIT stores CRC32 values big-endian, see calculate_hash() */
+		if (!strcmp(algo->name, "crc32"))
+			*(uint32_t *)ih->hash[i].value =
+				cpu_to_uimage(*(uint32_t *)ih->hash[i].value);
+		ih->hash[i].len = algo->digest_size;
+	}
+}
+
+void fit_image_hash_abort(struct fit_image_hash *ih)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	struct hash_algo *algo;
+	int i;
+
+	/* Finishing a hash is the only way to free its context */
+	for (i = 0; i < ih->count; i++) {
+		algo = ih->hash[i].algo;
+		if (algo)
+			algo->hash_finish(algo, ih->hash[i].ctx, value,
+					  sizeof(value));
+	}
+	ih->count = 0;
+}
+
+/* Hash the data of one image, on any CPU */
+static int fit_prehash_job(void *arg)
+{
+	struct fit_prehash *ph = arg;
+	struct fit_image_hash *ih = &ph->ih;
+	struct hash_algo *algo;
+	int i;
+
+	/* As fit_image_hash_update(), but leave the clean-up to the caller */
+	for (i = 0; i < ih->count; i++) {
+		algo = ih->hash[i].algo;
+		if (algo->hash_update(algo, ih->hash[i].ctx, ph->data,
+				      ph->size, 0)) {
+			ih->hash[i].algo = NULL;
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * fit_all_images_prehash() - hash the images of a FIT in parallel
+ *
+ * Each image is hashed by a job, so that several images are hashed at once
+ * when there are secondary CPUs to run the jobs. The hashes are set up and
+ * finished here, on the boot CPU, since that allocates and frees memory. The
+ * caller must check the results straight away with fit_image_verify_hashed().
+ *
+ * @fit:		FIT to use
+ * @images_noffset:	Offset of the images node
+ * @ph:			Returns the hashes of the images, in FIT order
+ * @return number of entries filled in @ph
+ */
+static int fit_all_images_prehash(const void *fit, int images_noffset,
+				  struct fit_prehash *ph)
+{
+	struct mp_job jobs[FIT_PREHASH_MAX_IMAGES];
+	int noffset, i, n = 0;
+
+	if (mp_job_cpus() < 2)
+		return 0;
+	fdt_for_each_subnode(noffset, fit, images_noffset) {
+		if (n == FIT_PREHASH_MAX_IMAGES)
+			break;
+		if (fit_image_get_data_and_size(fit, noffset, &ph[n].data,
+						&ph[n].size) ||
+		    fit_image_hash_start(fit, noffset, &ph[n].ih))
+			continue;
+		if (!ph[n].ih.count)
+			continue;
+		ph[n].noffset = noffset;
+		jobs[n].func = fit_prehash_job;
+		jobs[n].arg = &ph[n];
+		jobs[n].ret = -EBUSY;
+		n++;
+	}
+	if (n > 1) {
+		log_debug("Hashing %d images in parallel\n", n);
+		mp_run_jobs(jobs, n);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (n > 1 && !jobs[i].ret)
+			fit_image_hash_end(&ph[i].ih);
+		else
+			fit_image_hash_abort(&ph[i].ih);
+	}
+
+	return n;
+}
+#else
+#define FIT_PREHASH_MAX_IMAGES	1
+
+static inline int fit_all_images_prehash(const void *fit, int images_noffset,
+					 struct fit_prehash *ph)
+{
+	return 0;
+}
+#endif
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, const struct fit_image_hash *ih,
+				char **err_msgp)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	int value_len;
@@ -1225,6 +1425,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int i;
 
 	*err_msgp = NULL;
 
@@ -1248,7 +1449,17 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	/* Use the value which the caller has just computed, if there is one */
+	for (i = 0, value_len = 0; ih && ih->fit == fit && i < ih->count; i++) {
+		if (ih->hash[i].node == noffset && ih->hash[i].len) {
+			value_len = ih->hash[i].len;
+			memcpy(value, ih->hash[i].value, value_len);
+			break;
+		}
+	}
+
+	if (!value_len && calculate_hash(data, size, algo, value,
+					 &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1264,8 +1475,9 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *data, size_t size)
+int fit_image_verify_hashed(const void *fit, int image_noffset,
+			    const void *data, size_t size,
+			    const struct fit_image_hash *ih)
 {
 	int		noffset = 0;
 	char		*err_msg = "";
@@ -1291,7 +1503,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		 */
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
-			if (fit_image_check_hash(fit, noffset, data, size,
+			if (fit_image_check_hash(fit, noffset, data, size, ih,
 						 &err_msg))
 				goto error;
 			puts("+ ");
@@ -1328,6 +1540,12 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *data, size_t size)
+{
+	return fit_image_verify_hashed(fit, image_noffset, data, size, NULL);
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1373,10 +1591,12 @@ int fit_image_verify(const void *fit, int image_noffset)
  */
 int fit_all_image_verify(const void *fit)
 {
+	struct fit_prehash ph[FIT_PREHASH_MAX_IMAGES];
 	int images_noffset;
 	int noffset;
 	int ndepth;
 	int count;
+	int i, n;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1386,10 +1606,12 @@ int fit_all_image_verify(const void *fit)
 		return 0;
 	}
 
+	n = fit_all_images_prehash(fit, images_noffset, ph);
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
-	for (ndepth = 0, count = 0,
+	for (ndepth = 0, count = 0, i = 0,
 	     noffset = fdt_next_node(fit, images_noffset, &ndepth);
 			(noffset >= 0) && (ndepth > 0);
 			noffset = fdt_next_node(fit, noffset, &ndepth)) {
@@ -1402,8 +1624,17 @@ int fit_all_image_verify(const void *fit)
 			       fit_get_name(fit, noffset, NULL));
 			count++;
 
-			if (!fit_image_verify(fit, noffset))
+			/* Use the hashes just computed for it, if any */
+			if (i < n && ph[i].noffset == noffset) {
+				if (!fit_image_verify_hashed(fit, noffset,
+							     ph[i].data,
+							     ph[i].size,
+							     &ph[i].ih))
+					return 0;
+				i++;
+			} else if (!fit_image_verify(fit, noffset)) {
 				return 0;
+			}
 			printf("\n");
 		}
 	}
@@ -1793,18 +2024,142 @@ int fit_conf_get_prop_node(const void *fit, int noffset,
 	return fit_conf_get_prop_node_index(fit, noffset, prop_name, 0);
 }
 
+#if FIT_IMAGE_ENABLE_STREAM_DECOMP
+/* Amount of compressed data hashed and decompressed at a time */
+#define FIT_STREAM_CHUNK	SZ_64K
+
+/**
+ * fit_image_stream_ok() - check whether an image can be hashed as it is
+ * decompressed
+ *
+ * This is possible for gzip-compressed images which are decompressed here,
+ * have only hash nodes with algorithms that support progressive hashing, and
+ * have no signatures, ciphers or post-processing that need the whole buffer.
+ *
+ * The compressed data is read from the FIT in memory, not from storage: this
+ * saves a second pass over it but not the memory that holds it.
+ */
+static bool fit_image_stream_ok(const void *fit, int noffset, int image_type)
+{
+	struct hash_algo *algo;
+	int node, count = 0;
+	uint8_t comp;
+	char *algo_name;
+
+	if (fit_image_get_comp(fit, noffset, &comp) || comp != IH_COMP_GZIP ||
+	    image_type == IH_TYPE_KERNEL ||
+	    image_type == IH_TYPE_KERNEL_NOLOAD ||
+	    image_type == IH_TYPE_RAMDISK)
+		return false;
+	if (IS_ENABLED(CONFIG_FIT_IMAGE_POST_PROCESS))
+		return false;
+	/* Any key in the control FDT may be required for this image */
+	if (FIT_IMAGE_ENABLE_VERIFY && gd_fdt_blob() &&
+	    fdt_subnode_offset(gd_fdt_blob(), 0, FIT_SIG_NODENAME) >= 0)
+		return false;
+
+	fdt_for_each_subnode(node, fit, noffset) {
+		const char *name = fit_get_name(fit, node, NULL);
+
+		if (!strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)) ||
+		    !strncmp(name, FIT_CIPHER_NODENAME,
+			     strlen(FIT_CIPHER_NODENAME)))
+			return false;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, node, &algo_name) ||
+		    hash_progressive_lookup_algo(algo_name, &algo) ||
+		    ++count > FIT_IMAGE_HASH_MAX)
+			return false;
+	}
+
+	return true;
+}
+
+static int fit_stream_update(void *priv, const void *buf, unsigned long len)
+{
+	/* On error the hashes are dropped, but decompression can go on */
+	fit_image_hash_update(priv, buf, len);
+
+	return 0;
+}
+
+/**
+ * fit_image_gunzip_verify() - decompress an image and check its hashes
+ *
+ * The compressed data is hashed one chunk at a time, just before that chunk
+ * is decompressed, so that it is only read from memory once. The hashes are
+ * checked as soon as decompression is done.
+ *
+ * @fit:	FIT to use
+ * @noffset:	Offset of the image node
+ * @buf:	Compressed data
+ * @len:	Length of the compressed data
+ * @loadbuf:	Buffer for the decompressed data
+ * @max_len:	Size of @loadbuf
+ * @lenp:	Returns the length of the decompressed data
+ * @return 0 if OK, -EACCES if a hash does not match, other -ve on error
+ */
+static int fit_image_gunzip_verify(const void *fit, int noffset,
+				   const void *buf, ulong len, void *loadbuf,
+				   ulong max_len, ulong *lenp)
+{
+	struct fit_image_hash ih;
+	int ret;
+
+	/* If this fails, the data is hashed again when it is verified */
+	fit_image_hash_start(fit, noffset, &ih);
+	ret = gunzip_chunked(loadbuf, max_len, (unsigned char *)buf, len,
+			     FIT_STREAM_CHUNK, fit_stream_update, &ih, lenp);
+	if (ret) {
+		fit_image_hash_abort(&ih);
+		return -ENOEXEC;
+	}
+	fit_image_hash_end(&ih);
+
+	puts("   Verifying Hash Integrity ... ");
+	if (!fit_image_verify_hashed(fit, noffset, buf, len, &ih)) {
+		puts("Bad Data Hash\n");
+		return -EACCES;
+	}
+	puts("OK\n");
+
+	return 0;
+}
+#else
+static inline bool fit_image_stream_ok(const void *fit, int noffset,
+				       int image_type)
+{
+	return false;
+}
+
+static inline int fit_image_gunzip_verify(const void *fit, int noffset,
+					  const void *buf, ulong len,
+					  void *loadbuf, ulong max_len,
+					  ulong *lenp)
+{
+	return -ENOSYS;
+}
+#endif
+
+static int fit_image_check(const void *fit, int noffset)
+{
+	puts("   Verifying Hash Integrity ... ");
+	if (!fit_image_verify(fit, noffset)) {
+		puts("Bad Data Hash\n");
+		return -EACCES;
+	}
+	puts("OK\n");
+
+	return 0;
+}
+
 static int fit_image_select(const void *fit, int rd_noffset, int verify)
 {
 	fit_image_print(fit, rd_noffset, "   ");
 
-	if (verify) {
-		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_verify(fit, rd_noffset)) {
-			puts("Bad Data Hash\n");
-			return -EACCES;
-		}
-		puts("OK\n");
-	}
+	if (verify)
+		return fit_image_check(fit, rd_noffset);
 
 	return 0;
 }
@@ -1889,6 +2244,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	uint8_t os_arch;
 #endif
 	const char *prop_name;
+	bool stream;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -1960,7 +2316,9 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
-	ret = fit_image_select(fit, noffset, images->verify);
+	/* If possible, check the hashes while decompressing the image */
+	stream = images->verify && fit_image_stream_ok(fit, noffset, image_type);
+	ret = fit_image_select(fit, noffset, images->verify && !stream);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
@@ -2089,13 +2447,26 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		} else {
 			loadbuf = map_sysmem(load, max_decomp_len);
 		}
-		if (image_decomp(comp, load, data, image_type,
+		if (stream) {
+			ret = fit_image_gunzip_verify(fit, noffset, buf, len,
+						      loadbuf, max_decomp_len,
+						      &len);
+			if (ret == -EACCES) {
+				bootstage_error(bootstage_id +
+						BOOTSTAGE_SUB_HASH);
+				return ret;
+			} else if (ret) {
+				printf("Error decompressing %s\n", prop_name);
+				return -ENOEXEC;
+			}
+		} else if (image_decomp(comp, load, data, image_type,
 				loadbuf, buf, len, max_decomp_len, &load_end)) {
 			printf("Error decompressing %s\n", prop_name);
 
 			return -ENOEXEC;
+		} else {
+			len = load_end - load;
 		}
-		len = load_end - load;
 	} else if (load != data) {
 		loadbuf = map_sysmem(load, len);
 		memcpy(loadbuf, buf, len);
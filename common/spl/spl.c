@@ -21,6 +21,7 @@
 #include <asm/u-boot.h>
 #include <nand.h>
 #include <fat.h>
+#include <of_live.h>
 #include <u-boot/crc.h>
 #include <version.h>
 #include <image.h>
@@ -425,6 +426,15 @@ static int spl_common_init(bool setup_malloc)
 			return ret;
 		}
 	}
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	bootstage_start(BOOTSTAGE_ID_ACCUM_OF_LIVE, "of_live");
+	ret = of_live_build(gd->fdt_blob, (struct device_node **)&gd->of_root);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_OF_LIVE);
+	if (ret) {
+		debug("of_live_build() returned error %d\n", ret);
+		return ret;
+	}
+#endif
 	if (CONFIG_IS_ENABLED(DM)) {
 		bootstage_start(BOOTSTAGE_ID_ACCUM_DM_SPL,
 				spl_phase() == PHASE_TPL ? "dm tpl" : "dm_spl");
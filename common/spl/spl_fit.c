@@ -15,6 +15,8 @@
 #include <spl.h>
 #include <asm/cache.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
+#include <u-boot/zstd.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -219,6 +221,52 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+/* Amount of image data read at a time when hashing it while loading */
+#define SPL_FIT_HASH_CHUNK	SZ_128K
+
+/*
+ * Read external image data in chunks, hashing each chunk as soon as it has
+ * been read. The caller passes the hashes to fit_image_verify_hashed() right
+ * after this, instead of going over the whole image again.
+ *
+ * This is only worth doing for raw block and SPI loaders. Filesystem loaders
+ * open and seek the file on each read, so they read the image in one go.
+ */
+static int spl_fit_read_hashed(struct spl_load_info *info, ulong sector,
+			       int count, void *buf, const void *fit,
+			       int node, ulong overhead, size_t length,
+			       struct fit_image_hash *ih)
+{
+	int chunk = max(SPL_FIT_HASH_CHUNK / info->bl_len, 1);
+	ulong start, end;
+	bool hashed;
+	int done, n;
+
+	hashed = !fit_image_hash_start(fit, node, ih);
+	for (done = 0; done < count; done += n) {
+		n = min(chunk, count - done);
+		if (info->read(info, sector + done, n,
+			       buf + done * info->bl_len) != n) {
+			if (hashed)
+				fit_image_hash_abort(ih);
+			return -EIO;
+		}
+		if (!hashed)
+			continue;
+
+		/* Only hash the image data, not the alignment around it */
+		start = max((ulong)done * info->bl_len, overhead);
+		end = min((ulong)(done + n) * info->bl_len, overhead + length);
+		if (start < end &&
+		    fit_image_hash_update(ih, buf + start, end - start))
+			hashed = false;
+	}
+	if (hashed)
+		fit_image_hash_end(ih);
+
+	return 0;
+}
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -241,7 +289,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			      struct spl_image_info *image_info)
 {
 	int offset;
-	size_t length;
+	size_t length, unc_len;
 	int len;
 	ulong size;
 	ulong load_addr, load_ptr;
@@ -252,6 +300,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+	struct fit_image_hash ih = { .count = 0 };
 
 	if (IS_ENABLED(CONFIG_SPL_FPGA_SUPPORT) ||
 	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP))) {
@@ -261,7 +310,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			debug("%s ", genimg_get_type_name(type));
 	}
 
-	if (IS_ENABLED(CONFIG_SPL_GZIP)) {
+	if (IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_ZSTD)) {
 		fit_image_get_comp(fit, node, &image_comp);
 		debug("%s ", genimg_get_comp_name(image_comp));
 	}
@@ -287,10 +336,21 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		overhead = get_aligned_image_overhead(info, offset);
 		nr_sectors = get_aligned_image_size(info, length, offset);
 
-		if (info->read(info,
-			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
+		if (CONFIG_IS_ENABLED(FIT_LOAD_HASH) && !info->filename) {
+			if (spl_fit_read_hashed(info, sector +
+						get_aligned_image_offset(info,
+									 offset),
+						nr_sectors, (void *)load_ptr,
+						fit, node, overhead, length,
+						&ih))
+				return -EIO;
+		} else if (info->read(info,
+				      sector + get_aligned_image_offset(info,
+									offset),
+				      nr_sectors, (void *)load_ptr) !=
+			   nr_sectors) {
 			return -EIO;
+		}
 
 		debug("External data: dst=%lx, offset=%x, size=%lx\n",
 		      load_ptr, offset, (unsigned long)length);
@@ -309,8 +369,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 #ifdef CONFIG_SPL_FIT_SIGNATURE
 	printf("## Checking hash(es) for Image %s ... ",
 	       fit_get_name(fit, node, NULL));
-	if (!fit_image_verify_with_data(fit, node,
-					 src, length))
+	if (!fit_image_verify_hashed(fit, node, src, length, &ih))
 		return -EPERM;
 	puts("OK\n");
 #endif
@@ -327,6 +386,14 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			return -EIO;
 		}
 		length = size;
+	} else if (IS_ENABLED(CONFIG_SPL_ZSTD) && image_comp == IH_COMP_ZSTD) {
+		unc_len = CONFIG_SYS_BOOTM_LEN;
+		if (zstd_decompress(src, length, (void *)load_addr,
+				    &unc_len)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		length = unc_len;
 	} else {
 		memcpy((void *)load_addr, src, length);
 	}
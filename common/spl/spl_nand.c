@@ -19,6 +19,32 @@ uint32_t __weak spl_nand_get_uboot_raw_page(void)
 	return CONFIG_SYS_NAND_U_BOOT_OFFS;
 }
 
+/**
+ * nand_page_size() - Get the unit in which images are read
+ *
+ * Drivers which can only read whole pages return the page size, so that the
+ * FIT and container loaders read page-aligned data.
+ *
+ * @return size of a page, or 1 if any offset can be read
+ */
+unsigned int __weak nand_page_size(void)
+{
+	return 1;
+}
+
+/**
+ * nand_spl_adjust_offset() - Skip bad blocks in an image
+ *
+ * @sector:	Offset of the start of the image on the NAND
+ * @offs:	Offset within the image
+ * @return offset from the start of the image of the data at @offs once bad
+ * blocks are skipped
+ */
+u32 __weak nand_spl_adjust_offset(u32 sector, u32 offs)
+{
+	return offs;
+}
+
 #if defined(CONFIG_SPL_NAND_RAW_ONLY)
 static int spl_nand_load_image(struct spl_image_info *spl_image,
 			struct spl_boot_device *bootdev)
@@ -42,11 +68,15 @@ static int spl_nand_load_image(struct spl_image_info *spl_image,
 static ulong spl_nand_fit_read(struct spl_load_info *load, ulong offs,
 			       ulong size, void *dst)
 {
+	ulong sector = *(int *)load->priv;
 	int ret;
 
+	offs *= load->bl_len;
+	size *= load->bl_len;
+	offs = sector + nand_spl_adjust_offset(sector, offs - sector);
 	ret = nand_spl_load_image(offs, size, dst);
 	if (!ret)
-		return size;
+		return size / load->bl_len;
 	else
 		return 0;
 }
@@ -66,20 +96,22 @@ static int spl_nand_load_element(struct spl_image_info *spl_image,
 
 		debug("Found FIT\n");
 		load.dev = NULL;
-		load.priv = NULL;
+		load.priv = &offset;
 		load.filename = NULL;
-		load.bl_len = 1;
+		load.bl_len = nand_page_size();
 		load.read = spl_nand_fit_read;
-		return spl_load_simple_fit(spl_image, &load, offset, header);
+		return spl_load_simple_fit(spl_image, &load,
+					   offset / load.bl_len, header);
 	} else if (IS_ENABLED(CONFIG_SPL_LOAD_IMX_CONTAINER)) {
 		struct spl_load_info load;
 
 		load.dev = NULL;
-		load.priv = NULL;
+		load.priv = &offset;
 		load.filename = NULL;
-		load.bl_len = 1;
+		load.bl_len = nand_page_size();
 		load.read = spl_nand_fit_read;
-		return spl_load_imx_container(spl_image, &load, offset);
+		return spl_load_imx_container(spl_image, &load,
+					      offset / load.bl_len);
 	} else {
 		err = spl_parse_image_header(spl_image, header);
 		if (err)
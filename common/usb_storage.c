@@ -45,6 +45,8 @@
 #include <asm/processor.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <div64.h>
+#include <time.h>
 #include <linux/delay.h>
 
 #include <part.h>
@@ -101,6 +103,7 @@ struct us_data {
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
 	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
+	struct usb_stor_stats stats;		/* transfer statistics */
 };
 
 #if !CONFIG_IS_ENABLED(BLK)
@@ -111,6 +114,9 @@ static struct us_data usb_stor[USB_MAX_STOR_DEV];
 #define USB_STOR_TRANSPORT_FAILED -1
 #define USB_STOR_TRANSPORT_ERROR  -2
 
+/* Transfer size which all devices are known to cope with, see below */
+#define USB_STOR_SAFE_XFER_BLK	240
+
 int usb_stor_get_info(struct usb_device *dev, struct us_data *us,
 		      struct blk_desc *dev_desc);
 int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
@@ -133,6 +139,62 @@ static void usb_show_progress(void)
 	debug(".");
 }
 
+static struct us_data *usb_stor_get_us(struct blk_desc *desc)
+{
+	struct usb_device *udev;
+
+	if (desc->if_type != IF_TYPE_USB)
+		return NULL;
+#if CONFIG_IS_ENABLED(BLK)
+	udev = dev_get_parent_priv(dev_get_parent(desc->bdev));
+#else
+	udev = desc->priv;
+#endif
+	if (!udev)
+		return NULL;
+
+	return udev->privptr;
+}
+
+int usb_stor_get_stats(struct blk_desc *desc, struct usb_stor_stats *stats)
+{
+	struct us_data *ss = usb_stor_get_us(desc);
+
+	if (!ss)
+		return -ENODEV;
+	*stats = ss->stats;
+	stats->max_xfer_blk = ss->max_xfer_blk;
+
+	return 0;
+}
+
+/* Rate in KiB/s of @bytes transferred in @us microseconds */
+static ulong usb_stor_rate(u64 bytes, u64 us)
+{
+	if (!us)
+		return 0;
+
+	return lldiv(bytes * 1000000 / 1024, us);
+}
+
+static void usb_stor_show_stats(struct blk_desc *desc)
+{
+	struct usb_stor_stats stats;
+
+	if (usb_stor_get_stats(desc, &stats))
+		return;
+	printf("            Max transfer: %u blocks, %u transfers, %u errors\n",
+	       stats.max_xfer_blk, stats.xfers, stats.errors);
+	if (stats.read_bytes)
+		printf("            Read: %llu KiB in %llu ms, %lu KiB/s\n",
+		       stats.read_bytes >> 10, lldiv(stats.read_us, 1000),
+		       usb_stor_rate(stats.read_bytes, stats.read_us));
+	if (stats.write_bytes)
+		printf("            Write: %llu KiB in %llu ms, %lu KiB/s\n",
+		       stats.write_bytes >> 10, lldiv(stats.write_us, 1000),
+		       usb_stor_rate(stats.write_bytes, stats.write_us));
+}
+
 /*******************************************************************************
  * show info on storage devices; 'usb start/init' must be invoked earlier
  * as we only retrieve structures populated during devices initialization
@@ -150,6 +212,7 @@ int usb_stor_info(void)
 
 		printf("  Device %d: ", desc->devnum);
 		dev_print(desc);
+		usb_stor_show_stats(desc);
 		count++;
 	}
 #else
@@ -159,6 +222,7 @@ int usb_stor_info(void)
 		for (i = 0; i < usb_max_devs; i++) {
 			printf("  Device %d: ", i);
 			dev_print(&usb_dev_desc[i]);
+			usb_stor_show_stats(&usb_dev_desc[i]);
 		}
 		return 0;
 	}
@@ -958,21 +1022,53 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Only one command is ever in flight with the Bulk-Only transport, so
+	 * larger transfers are the way to keep the bus busy. When the host
+	 * controller tells how much it can take in one go, start from
+	 * CONFIG_USB_STORAGE_MAX_XFER_BLK, or from
+	 * CONFIG_USB_STORAGE_MAX_XFER_BLK_SS for USB3 devices. A device which
+	 * fails such a transfer is dropped back to the safe limit, see
+	 * usb_stor_fall_back().
 	 */
-	unsigned short blk = 240;
+	unsigned short blk = USB_STOR_SAFE_XFER_BLK;
 
 #if CONFIG_IS_ENABLED(DM_USB)
+	unsigned int max = CONFIG_USB_STORAGE_MAX_XFER_BLK;
 	size_t size;
 	int ret;
 
+	if (udev->speed >= USB_SPEED_SUPER)
+		max = CONFIG_USB_STORAGE_MAX_XFER_BLK_SS;
+
 	ret = usb_get_max_xfer_size(udev, (size_t *)&size);
-	if ((ret >= 0) && (size < blk * 512))
-		blk = size / 512;
+	if (ret >= 0) {
+		size /= 512;
+		blk = min_t(size_t, size, max);
+	}
 #endif
 
 	us->max_xfer_blk = blk;
 }
 
+/*
+ * Drop back to the transfer size which all devices cope with after a failed
+ * transfer larger than that, so that it can be retried straight away. Returns
+ * true if the transfer is to be retried in smaller pieces.
+ */
+static bool usb_stor_fall_back(struct us_data *ss, unsigned short *smallblks)
+{
+	if (*smallblks <= USB_STOR_SAFE_XFER_BLK)
+		return false;
+
+	debug("usb: falling back to %d blocks per transfer\n",
+	      USB_STOR_SAFE_XFER_BLK);
+	ss->max_xfer_blk = USB_STOR_SAFE_XFER_BLK;
+	*smallblks = USB_STOR_SAFE_XFER_BLK;
+
+	return true;
+}
+
 static int usb_inquiry(struct scsi_cmd *srb, struct us_data *ss)
 {
 	int retry, i;
@@ -1138,6 +1234,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	struct usb_device *udev;
 	struct us_data *ss;
 	int retry;
+	ulong start_us;
 	struct scsi_cmd *srb = &usb_ccb;
 #if CONFIG_IS_ENABLED(BLK)
 	struct blk_desc *block_dev;
@@ -1166,6 +1263,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	buf_addr = (uintptr_t)buffer;
 	start = blknr;
 	blks = blkcnt;
+	start_us = timer_get_us();
 
 	debug("\nusb_read: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, buf_addr);
@@ -1186,12 +1284,14 @@ retry_it:
 		if (usb_read_10(srb, ss, start, smallblks)) {
 			debug("Read ERROR\n");
 			ss->flags &= ~USB_READY;
+			ss->stats.errors++;
 			usb_request_sense(srb, ss);
-			if (retry--)
+			if (usb_stor_fall_back(ss, &smallblks) || retry--)
 				goto retry_it;
 			blkcnt -= blks;
 			break;
 		}
+		ss->stats.xfers++;
 		start += smallblks;
 		blks -= smallblks;
 		buf_addr += srb->datalen;
@@ -1200,6 +1300,9 @@ retry_it:
 	debug("usb_read: end startblk " LBAF ", blccnt %x buffer %lx\n",
 	      start, smallblks, buf_addr);
 
+	ss->stats.read_bytes += (u64)blkcnt * block_dev->blksz;
+	ss->stats.read_us += timer_get_us() - start_us;
+
 	usb_lock_async(udev, 0);
 	usb_disable_asynch(0); /* asynch transfer allowed */
 	if (blkcnt >= ss->max_xfer_blk)
@@ -1221,6 +1324,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	struct usb_device *udev;
 	struct us_data *ss;
 	int retry;
+	ulong start_us;
 	struct scsi_cmd *srb = &usb_ccb;
 #if CONFIG_IS_ENABLED(BLK)
 	struct blk_desc *block_dev;
@@ -1251,6 +1355,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	buf_addr = (uintptr_t)buffer;
 	start = blknr;
 	blks = blkcnt;
+	start_us = timer_get_us();
 
 	debug("\nusb_write: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, buf_addr);
@@ -1273,12 +1378,14 @@ retry_it:
 		if (usb_write_10(srb, ss, start, smallblks)) {
 			debug("Write ERROR\n");
 			ss->flags &= ~USB_READY;
+			ss->stats.errors++;
 			usb_request_sense(srb, ss);
-			if (retry--)
+			if (usb_stor_fall_back(ss, &smallblks) || retry--)
 				goto retry_it;
 			blkcnt -= blks;
 			break;
 		}
+		ss->stats.xfers++;
 		start += smallblks;
 		blks -= smallblks;
 		buf_addr += srb->datalen;
@@ -1287,6 +1394,9 @@ retry_it:
 	debug("usb_write: end startblk " LBAF ", blccnt %x buffer %lx\n",
 	      start, smallblks, buf_addr);
 
+	ss->stats.write_bytes += (u64)blkcnt * block_dev->blksz;
+	ss->stats.write_us += timer_get_us() - start_us;
+
 	usb_lock_async(udev, 0);
 	usb_disable_asynch(0); /* asynch transfer allowed */
 	if (blkcnt >= ss->max_xfer_blk)
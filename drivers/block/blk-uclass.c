@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
@@ -430,20 +431,171 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * struct blk_queue - asynchronous requests in progress on a device
+ *
+ * @reqs:	Requests, oldest first
+ * @count:	Number of requests in @reqs
+ */
+struct blk_queue {
+	struct list_head reqs;
+	int count;
+};
+
+static void blk_req_sync(struct blk_desc *block_dev, struct blk_req *req)
+{
+	if (req->write)
+		req->result = blk_dwrite(block_dev, req->start, req->blkcnt,
+					 req->buffer);
+	else
+		req->result = blk_dread(block_dev, req->start, req->blkcnt,
+					req->buffer);
+	req->done = true;
+}
+
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_queue *queue = dev_get_uclass_priv(dev);
+	int ret;
+
+	if (req->done)
+		return 0;
+	ret = ops->poll(dev, req);
+	if (ret == -EBUSY)
+		return ret;
+	if (ret)
+		req->result = ret;
+
+	list_del(&req->node);
+	queue->count--;
+	if (!req->write && req->result == req->blkcnt)
+		blkcache_fill(block_dev->if_type, block_dev->devnum,
+			      req->start, req->blkcnt, block_dev->blksz,
+			      req->buffer);
+	req->done = true;
+
+	return 0;
+}
+
+long blk_wait(struct blk_desc *block_dev, struct blk_req *req)
+{
+	while (blk_poll(block_dev, req) == -EBUSY)
+		;
+
+	return req->result;
+}
+
+/* Wait for all the asynchronous requests in progress on a device */
+static void blk_drain(struct blk_desc *block_dev)
+{
+	struct blk_queue *queue = dev_get_uclass_priv(block_dev->bdev);
+
+	while (queue->count)
+		blk_wait(block_dev, list_first_entry(&queue->reqs,
+						     struct blk_req, node));
+}
+
+/*
+ * Wait for the requests in progress which overlap @req, where either is a
+ * write. Otherwise a read could finish after a later write to the same
+ * blocks and fill the block cache with the old data, or see the new data.
+ */
+static void blk_wait_overlap(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct blk_queue *queue = dev_get_uclass_priv(block_dev->bdev);
+	struct blk_req *old, *next;
+
+	list_for_each_entry_safe(old, next, &queue->reqs, node) {
+		if ((old->write || req->write) &&
+		    old->start < req->start + req->blkcnt &&
+		    req->start < old->start + old->blkcnt)
+			blk_wait(block_dev, old);
+	}
+}
+
+int blk_submit(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_queue *queue = dev_get_uclass_priv(dev);
+	int ret;
+
+	req->done = false;
+	req->result = 0;
+	if (!req->blkcnt) {
+		req->done = true;
+		return 0;
+	}
+	if (!ops->submit) {
+		blk_req_sync(block_dev, req);
+		return 0;
+	}
+	blk_wait_overlap(block_dev, req);
+	if (req->write) {
+		block_dev->write_count++;
+		blkcache_invalidate_range(block_dev->if_type,
+					  block_dev->devnum, req->start,
+					  req->blkcnt);
+	} else if (blkcache_read(block_dev->if_type, block_dev->devnum,
+				 req->start, req->blkcnt, block_dev->blksz,
+				 req->buffer)) {
+		req->result = req->blkcnt;
+		req->done = true;
+		return 0;
+	}
+
+	while (1) {
+		ret = -EBUSY;
+		if (queue->count < CONFIG_BLK_ASYNC_DEPTH)
+			ret = ops->submit(dev, req);
+		if (ret != -EBUSY || !queue->count)
+			break;
+		/* Make room by finishing the oldest request */
+		blk_wait(block_dev, list_first_entry(&queue->reqs,
+						     struct blk_req, node));
+	}
+	if (ret == -ENOSYS || ret == -EBUSY) {
+		blk_req_sync(block_dev, req);
+		return 0;
+	}
+	if (ret)
+		return ret;
+	list_add_tail(&req->node, &queue->reqs);
+	queue->count++;
+
+	return 0;
+}
+#else
+static inline void blk_drain(struct blk_desc *block_dev)
+{
+}
+#endif
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	ulong blks_read, start_us;
 
 	if (!ops->read)
 		return -ENOSYS;
 
+	blk_drain(block_dev);
+
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+	if (blkcache_read_ahead(block_dev, start, blkcnt, buffer))
+		return blkcnt;
+	start_us = bootstage_span_start();
 	blks_read = ops->read(dev, start, blkcnt, buffer);
+	bootstage_span(BOOTSTAGE_SPAN_BLK_READ, dev->name, start_us,
+		       IS_ERR_VALUE(blks_read) ? 0 :
+		       blks_read * block_dev->blksz);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
@@ -456,12 +608,22 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_written, start_us;
 
 	if (!ops->write)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	blk_drain(block_dev);
+	block_dev->write_count++;
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
+	start_us = bootstage_span_start();
+	blks_written = ops->write(dev, start, blkcnt, buffer);
+	bootstage_span(BOOTSTAGE_SPAN_BLK_WRITE, dev->name, start_us,
+		       IS_ERR_VALUE(blks_written) ? 0 :
+		       blks_written * block_dev->blksz);
+
+	return blks_written;
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -473,7 +635,10 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->erase)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blk_drain(block_dev);
+	block_dev->write_count++;
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
 	return ops->erase(dev, start, blkcnt);
 }
 
@@ -642,6 +807,17 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int blk_pre_probe(struct udevice *dev)
+{
+	struct blk_queue *queue = dev_get_uclass_priv(dev);
+
+	INIT_LIST_HEAD(&queue->reqs);
+
+	return 0;
+}
+#endif
+
 static int blk_post_probe(struct udevice *dev)
 {
 #if defined(CONFIG_PARTITIONS) && defined(CONFIG_HAVE_BLOCK_DEVICE)
@@ -653,9 +829,27 @@ static int blk_post_probe(struct udevice *dev)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+	blk_drain(desc);
+	/* Another device may be given the same number later */
+	blkcache_invalidate(desc->if_type, desc->devnum);
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.pre_probe	= blk_pre_probe,
+#endif
 	.post_probe	= blk_post_probe,
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.per_device_auto_alloc_size = sizeof(struct blk_queue),
+#endif
 };
@@ -6,14 +6,29 @@
  */
 #include <common.h>
 #include <blk.h>
+#include <dm.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * Entries are hashed on the 'granule' their first block falls in. No entry
+ * may be larger than a granule, so a block can only be cached by an entry
+ * which starts in the same granule or in the one before it.
+ */
+#define BLKCACHE_GRANULE_BITS	8
+#define BLKCACHE_MAX_BLOCKS	(1 << BLKCACHE_GRANULE_BITS)
+#define BLKCACHE_HASH_BITS	6
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+
+/* Number of devices for which sequential access is tracked */
+#define BLKCACHE_STREAMS	4
+
 struct block_cache_node {
-	struct list_head lh;
+	struct list_head lh;		/* LRU list, most recently used first */
+	struct hlist_node hash;		/* hash bucket of the start granule */
 	int iftype;
 	int devnum;
 	lbaint_t start;
@@ -22,15 +37,35 @@ struct block_cache_node {
 	char *cache;
 };
 
+/**
+ * struct block_cache_stream - sequential read detection for one device
+ *
+ * @iftype:	IF_TYPE_x of the device, or -1 if the slot is unused
+ * @devnum:	Device number
+ * @next:	Block following the last one read
+ */
+struct block_cache_stream {
+	int iftype;
+	int devnum;
+	lbaint_t next;
+};
+
 #ifndef CONFIG_M68K
 static LIST_HEAD(block_cache);
 #else
 static struct list_head block_cache;
 #endif
 
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
+static struct block_cache_stream block_cache_streams[BLKCACHE_STREAMS] = {
+	[0 ... BLKCACHE_STREAMS - 1] = { .iftype = -1 },
+};
+static int next_stream;
+
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_entries = 32,
+	.max_readahead = 32,
 };
 
 #ifdef CONFIG_M68K
@@ -42,26 +77,171 @@ int blkcache_init(void)
 }
 #endif
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+static struct hlist_head *cache_bucket(int iftype, int devnum,
+				       lbaint_t granule)
+{
+	u32 key = (u32)granule ^ ((u32)iftype << 24) ^ ((u32)devnum << 16);
+
+	/* Fibonacci hashing, as used by hash_32() in Linux */
+	return &block_cache_hash[(key * 0x61c88647) >>
+				 (32 - BLKCACHE_HASH_BITS)];
+}
+
+static struct block_cache_node *cache_find_in(struct hlist_head *bucket,
+					      int iftype, int devnum,
+					      lbaint_t start, lbaint_t blkcnt,
+					      unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
+	hlist_for_each_entry(node, pos, bucket, hash)
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
 		    (node->blksz == blksz) &&
 		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->start + node->blkcnt >= start + blkcnt))
 			return node;
+
+	return NULL;
+}
+
+static struct block_cache_node *cache_find(int iftype, int devnum,
+					   lbaint_t start, lbaint_t blkcnt,
+					   unsigned long blksz)
+{
+	lbaint_t granule = start >> BLKCACHE_GRANULE_BITS;
+	struct block_cache_node *node;
+
+	node = cache_find_in(cache_bucket(iftype, devnum, granule), iftype,
+			     devnum, start, blkcnt, blksz);
+	if (!node && granule)
+		node = cache_find_in(cache_bucket(iftype, devnum, granule - 1),
+				     iftype, devnum, start, blkcnt, blksz);
+	if (node && block_cache.next != &node->lh) {
+		/* maintain MRU ordering */
+		list_del(&node->lh);
+		list_add(&node->lh, &block_cache);
+	}
+
+	return node;
+}
+
+static void cache_remove(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hash);
+	_stats.entries--;
+}
+
+static void cache_free(struct block_cache_node *node)
+{
+	free(node->cache);
+	free(node);
+}
+
+/*
+ * Get a node with room for @bytes of data, either by evicting the least
+ * recently used entry or by allocating a new one. The node is not on any
+ * list when returned.
+ */
+static struct block_cache_node *cache_get_node(lbaint_t bytes)
+{
+	struct block_cache_node *node;
+
+	if (_stats.max_entries <= _stats.entries) {
+		/* pop LRU */
+		node = list_last_entry(&block_cache, struct block_cache_node,
+				       lh);
+		cache_remove(node);
+		debug("drop: start " LBAF ", count " LBAFU "\n",
+		      node->start, node->blkcnt);
+		if (node->blkcnt * node->blksz < bytes) {
+			free(node->cache);
+			node->cache = 0;
 		}
-	return 0;
+	} else {
+		node = malloc(sizeof(*node));
+		if (!node)
+			return NULL;
+		node->cache = 0;
+	}
+
+	if (!node->cache) {
+		node->cache = malloc(bytes);
+		if (!node->cache) {
+			free(node);
+			return NULL;
+		}
+	}
+
+	return node;
+}
+
+static void cache_insert(struct block_cache_node *node, int iftype,
+			 int devnum, lbaint_t start, lbaint_t blkcnt,
+			 unsigned long blksz)
+{
+	node->iftype = iftype;
+	node->devnum = devnum;
+	node->start = start;
+	node->blkcnt = blkcnt;
+	node->blksz = blksz;
+	list_add(&node->lh, &block_cache);
+	hlist_add_head(&node->hash,
+		       cache_bucket(iftype, devnum,
+				    start >> BLKCACHE_GRANULE_BITS));
+	_stats.entries++;
+}
+
+static struct block_cache_stream *stream_find(int iftype, int devnum)
+{
+	int i;
+
+	for (i = 0; i < BLKCACHE_STREAMS; i++) {
+		struct block_cache_stream *stream = &block_cache_streams[i];
+
+		if (stream->iftype == iftype && stream->devnum == devnum)
+			return stream;
+	}
+
+	return NULL;
+}
+
+/* Record a read and return true if it continues the previous one */
+static bool stream_update(int iftype, int devnum, lbaint_t start,
+			  lbaint_t blkcnt)
+{
+	struct block_cache_stream *stream = stream_find(iftype, devnum);
+	bool sequential = false;
+
+	if (stream) {
+		sequential = stream->next == start;
+	} else {
+		stream = &block_cache_streams[next_stream];
+		next_stream = (next_stream + 1) % BLKCACHE_STREAMS;
+		stream->iftype = iftype;
+		stream->devnum = devnum;
+	}
+	stream->next = start + blkcnt;
+
+	return sequential;
+}
+
+static void stream_reset(int iftype, int devnum)
+{
+	struct block_cache_stream *stream = stream_find(iftype, devnum);
+
+	if (stream)
+		stream->iftype = -1;
+}
+
+static void stream_reset_all(void)
+{
+	int i;
+
+	for (i = 0; i < BLKCACHE_STREAMS; i++)
+		block_cache_streams[i].iftype = -1;
 }
 
 int blkcache_read(int iftype, int devnum,
@@ -76,6 +256,7 @@ int blkcache_read(int iftype, int devnum,
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		stream_update(iftype, devnum, start, blkcnt);
 		return 1;
 	}
 
@@ -85,11 +266,53 @@ int blkcache_read(int iftype, int devnum,
 	return 0;
 }
 
+static ulong blkcache_dev_read(struct blk_desc *block_dev, lbaint_t start,
+			       lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+
+	return blk_get_ops(dev)->read(dev, start, blkcnt, buffer);
+}
+
+int blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer)
+{
+	int iftype = block_dev->if_type, devnum = block_dev->devnum;
+	unsigned long blksz = block_dev->blksz;
+	struct block_cache_node *node;
+	lbaint_t count;
+
+	if (!stream_update(iftype, devnum, start, blkcnt))
+		return 0;
+
+	count = _stats.max_readahead;
+	if (blkcnt >= count || !_stats.max_entries || start >= block_dev->lba)
+		return 0;
+	if (count > block_dev->lba - start)
+		count = block_dev->lba - start;
+	if (blkcnt >= count)
+		return 0;
+
+	node = cache_get_node(count * blksz);
+	if (!node)
+		return 0;
+	if (blkcache_dev_read(block_dev, start, count, node->cache) != count) {
+		cache_free(node);
+		return 0;
+	}
+
+	debug("read-ahead: start " LBAF ", count " LBAFU "\n", start, count);
+	cache_insert(node, iftype, devnum, start, count, blksz);
+	memcpy(buffer, node->cache, blkcnt * blksz);
+	++_stats.readaheads;
+
+	return 1;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
 
 	/* don't cache big stuff */
@@ -99,83 +322,75 @@ void blkcache_fill(int iftype, int devnum,
 	if (_stats.max_entries == 0)
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
-
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
-	}
+	node = cache_get_node(blksz * blkcnt);
+	if (!node)
+		return;
 
 	debug("fill: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	memcpy(node->cache, buffer, blksz * blkcnt);
+	cache_insert(node, iftype, devnum, start, blkcnt, blksz);
+}
+
+void blkcache_invalidate_range(int iftype, int devnum, lbaint_t start,
+			       lbaint_t blkcnt)
+{
+	struct block_cache_node *node, *n;
+
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
+		if ((node->iftype == iftype) &&
+		    (node->devnum == devnum) &&
+		    (node->start < start + blkcnt) &&
+		    (node->start + node->blkcnt > start)) {
+			cache_remove(node);
+			cache_free(node);
+		}
+	}
+	stream_reset(iftype, devnum);
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
+			cache_remove(node);
+			cache_free(node);
 		}
 	}
+	stream_reset(iftype, devnum);
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned entries,
+			unsigned readahead)
 {
 	struct block_cache_node *node;
+
+	blocks = min(blocks, (unsigned)BLKCACHE_MAX_BLOCKS);
+	readahead = min(readahead, (unsigned)BLKCACHE_MAX_BLOCKS);
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
+	    (entries != _stats.max_entries) ||
+	    (readahead != _stats.max_readahead)) {
 		/* invalidate cache */
 		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
+			node = list_first_entry(&block_cache,
+						struct block_cache_node, lh);
+			cache_remove(node);
+			cache_free(node);
 		}
-		_stats.entries = 0;
 	}
+	stream_reset_all();
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
+	_stats.max_readahead = readahead;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -183,4 +398,5 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
 }
@@ -87,6 +87,81 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 	return -1;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * struct host_block_async - transfer done by a host thread
+ *
+ * @fd:		File to transfer to or from
+ * @blksz:	Block size of the device
+ * @req:	Request being carried out
+ * @thread:	Host thread doing the transfer
+ * @result:	Number of blocks transferred, or -ve error number
+ * @done:	Set by the thread once @result is valid
+ */
+struct host_block_async {
+	int fd;
+	ulong blksz;
+	struct blk_req *req;
+	void *thread;
+	long result;
+	int done;
+};
+
+/* Runs in a host thread, so must not use anything but the OS layer */
+static void host_block_worker(void *arg)
+{
+	struct host_block_async *async = arg;
+	struct blk_req *req = async->req;
+	size_t len = req->blkcnt * async->blksz;
+	off_t offset = req->start * async->blksz;
+	ssize_t ret;
+
+	if (req->write)
+		ret = os_pwrite(async->fd, req->buffer, len, offset);
+	else
+		ret = os_pread(async->fd, req->buffer, len, offset);
+	async->result = ret < 0 ? -EIO : ret / async->blksz;
+	__atomic_store_n(&async->done, 1, __ATOMIC_RELEASE);
+}
+
+static int host_block_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct host_block_dev *host_dev = dev_get_platdata(dev);
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct host_block_async *async;
+	int ret;
+
+	async = calloc(1, sizeof(*async));
+	if (!async)
+		return -ENOMEM;
+	async->fd = host_dev->fd;
+	async->blksz = block_dev->blksz;
+	async->req = req;
+	ret = os_thread_start(host_block_worker, async, &async->thread);
+	if (ret) {
+		free(async);
+		return ret;
+	}
+	req->priv = async;
+
+	return 0;
+}
+
+static int host_block_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct host_block_async *async = req->priv;
+
+	if (!__atomic_load_n(&async->done, __ATOMIC_ACQUIRE))
+		return -EBUSY;
+	os_thread_join(async->thread);
+	req->result = async->result;
+	req->priv = NULL;
+	free(async);
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_BLK
 int host_dev_bind(int devnum, char *filename)
 {
@@ -222,6 +297,10 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit	= host_block_submit,
+	.poll	= host_block_poll,
+#endif
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
@@ -69,7 +69,7 @@ int device_unbind(struct udevice *dev)
 	if (!dev)
 		return log_msg_ret("dev", -EINVAL);
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
 		return log_msg_ret("active", -EINVAL);
 
 	if (!(dev->flags & DM_FLAG_BOUND))
@@ -166,6 +166,10 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
+	/* Let a probe going on in the background finish before undoing it */
+	if ((dev->flags & DM_FLAG_PROBE_PENDING) && device_probe(dev))
+		return 0;
+
 	if (!(dev->flags & DM_FLAG_ACTIVATED))
 		return 0;
 
@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <log.h>
 #include <asm/io.h>
@@ -30,6 +31,7 @@
 #include <linux/err.h>
 #include <linux/list.h>
 #include <power-domain.h>
+#include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -393,15 +395,67 @@ fail:
 	return ret;
 }
 
-int device_probe(struct udevice *dev)
+/* Undo the work of device_probe_start() after an error */
+static int device_probe_fail(struct udevice *dev, int ret)
+{
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+
+	dev->seq = -1;
+	device_free(dev);
+
+	return ret;
+}
+
+/* Last steps of probing a device, once the probe() method is done */
+static int device_probe_finish(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret) {
+		if (device_remove(dev, DM_REMOVE_NORMAL)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		return device_probe_fail(dev, ret);
+	}
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+}
+
+/*
+ * Check whether the probe() method of a device has left the rest of the work
+ * to its probe_poll() method, and mark the device as such. It is not active
+ * until probe_poll() has finished.
+ */
+static bool device_probe_deferred(struct udevice *dev, int ret)
+{
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	if (ret == -EINPROGRESS && dev->driver->probe_poll) {
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->flags |= DM_FLAG_PROBE_PENDING;
+		return true;
+	}
+#endif
+
+	return false;
+}
+
+int device_probe_start(struct udevice *dev)
 {
 	const struct driver *drv;
+	ulong start_us;
 	int ret;
 	int seq;
 
 	if (!dev)
 		return -EINVAL;
 
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		return -EINPROGRESS;
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return 0;
 
@@ -424,10 +478,18 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
+		if (dev->flags & DM_FLAG_PROBE_PENDING)
+			return -EINPROGRESS;
 		if (dev->flags & DM_FLAG_ACTIVATED)
 			return 0;
 	}
 
+	/*
+	 * The timeline shows the probe of this device without its parents. For
+	 * a probe finished by probe_poll() it only covers the probe() call.
+	 */
+	start_us = bootstage_span_start();
+
 	seq = uclass_resolve_seq(dev);
 	if (seq < 0) {
 		ret = seq;
@@ -477,28 +539,57 @@ int device_probe(struct udevice *dev)
 
 	if (drv->probe) {
 		ret = drv->probe(dev);
+		if (device_probe_deferred(dev, ret)) {
+			bootstage_span(BOOTSTAGE_SPAN_PROBE, dev->name,
+				       start_us, 0);
+			return -EINPROGRESS;
+		}
 		if (ret)
 			goto fail;
 	}
 
-	ret = uclass_post_probe_device(dev);
+	ret = device_probe_finish(dev);
+	if (!ret)
+		bootstage_span(BOOTSTAGE_SPAN_PROBE, dev->name, start_us, 0);
+
+	return ret;
+fail:
+	return device_probe_fail(dev, ret);
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int device_probe_poll(struct udevice *dev)
+{
+	int ret;
+
+	if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+		return device_active(dev) ? 0 : -ENODEV;
+
+	ret = dev->driver->probe_poll(dev);
+	if (ret == -EINPROGRESS)
+		return ret;
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
 	if (ret)
-		goto fail_uclass;
+		return device_probe_fail(dev, ret);
+	dev->flags |= DM_FLAG_ACTIVATED;
 
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
+	return device_probe_finish(dev);
+}
+#endif
 
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
-fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+int device_probe(struct udevice *dev)
+{
+	int ret;
 
-	dev->seq = -1;
-	device_free(dev);
+	ret = device_probe_start(dev);
+
+	/* Wait for a probe which is going on in the background */
+	if (CONFIG_IS_ENABLED(DM_PROBE_ASYNC)) {
+		while (ret == -EINPROGRESS) {
+			WATCHDOG_RESET();
+			ret = device_probe_poll(dev);
+		}
+	}
 
 	return ret;
 }
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Probing several devices at once
+ *
+ * A driver whose probe() method has to wait for a while can leave the rest of
+ * the work to its probe_poll() method, see dev_probe_defer(). The devices
+ * passed to device_probe_all() are then stepped through in turn, so that
+ * other devices are probed while one is waiting.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <dm/device.h>
+#include <dm/device-internal.h>
+
+/*
+ * Take one step towards probing a device: start or poll the device itself,
+ * or the top-most parent which is not ready yet
+ *
+ * @return 0 if @dev is ready, -EINPROGRESS if not yet, other -ve on error
+ */
+static int device_probe_step(struct udevice *dev)
+{
+	struct udevice *todo = NULL, *parent;
+	int ret;
+
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		return device_probe_poll(dev);
+	if (device_active(dev))
+		return 0;
+
+	for (parent = dev->parent; parent; parent = parent->parent) {
+		if (!device_active(parent))
+			todo = parent;
+	}
+	if (!todo)
+		return device_probe_start(dev);
+
+	if (todo->flags & DM_FLAG_PROBE_PENDING)
+		ret = device_probe_poll(todo);
+	else
+		ret = device_probe_start(todo);
+
+	/* If the parent is ready, @dev itself is started on the next pass */
+	return ret ? ret : -EINPROGRESS;
+}
+
+int device_probe_all(struct udevice *const devs[], int count)
+{
+	int *status;
+	int busy, i, ret;
+
+	status = malloc(count * sizeof(*status));
+	if (!status)
+		return -ENOMEM;
+	for (i = 0; i < count; i++)
+		status[i] = -EINPROGRESS;
+
+	do {
+		busy = 0;
+		for (i = 0; i < count; i++) {
+			if (status[i] != -EINPROGRESS)
+				continue;
+			status[i] = device_probe_step(devs[i]);
+			if (status[i] == -EINPROGRESS)
+				busy++;
+		}
+		WATCHDOG_RESET();
+	} while (busy);
+
+	ret = 0;
+	for (i = 0; i < count && !ret; i++)
+		ret = status[i];
+	free(status);
+
+	return ret;
+}
@@ -626,6 +626,42 @@ int uclass_next_device_check(struct udevice **devp)
 	return device_probe(*devp);
 }
 
+int uclass_probe_all(enum uclass_id id)
+{
+	struct udevice **devs;
+	struct udevice *dev;
+	struct uclass *uc;
+	int count, ret;
+
+	ret = uclass_get(id, &uc);
+	if (ret)
+		return ret;
+
+	if (!CONFIG_IS_ENABLED(DM_PROBE_ASYNC)) {
+		uclass_foreach_dev(dev, uc) {
+			int err = device_probe(dev);
+
+			if (err && !ret)
+				ret = err;
+		}
+		return ret;
+	}
+
+	count = list_count_items(&uc->dev_head);
+	if (!count)
+		return 0;
+	devs = malloc(count * sizeof(*devs));
+	if (!devs)
+		return -ENOMEM;
+	count = 0;
+	uclass_foreach_dev(dev, uc)
+		devs[count++] = dev;
+	ret = device_probe_all(devs, count);
+	free(devs);
+
+	return ret;
+}
+
 int uclass_first_device_drvdata(enum uclass_id id, ulong driver_data,
 				struct udevice **devp)
 {
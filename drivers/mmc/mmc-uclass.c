@@ -52,6 +52,51 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	if (!ops->send_cmd_start || !ops->send_cmd_poll)
+		return -ENOSYS;
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_start(dev, cmd, data);
+	if (ret)
+		mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int mmc_send_cmd_start(struct mmc *mmc, struct mmc_cmd *cmd,
+		       struct mmc_data *data)
+{
+	return dm_mmc_send_cmd_start(mmc->dev, cmd, data);
+}
+
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	ret = ops->send_cmd_poll(dev, cmd, data);
+	if (ret != -EBUSY)
+		mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int mmc_send_cmd_poll(struct mmc *mmc, struct mmc_cmd *cmd,
+		      struct mmc_data *data)
+{
+	return dm_mmc_send_cmd_poll(mmc->dev, cmd, data);
+}
+#endif
+
 int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -193,6 +238,8 @@ int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg)
 
 	/* f_max is obtained from the optional "max-frequency" property */
 	dev_read_u32(dev, "max-frequency", &cfg->f_max);
+	/* b_max may be lowered by "u-boot,max-blk-count" to tune transfers */
+	dev_read_u32(dev, "u-boot,max-blk-count", &cfg->b_max);
 
 	if (dev_read_bool(dev, "cap-sd-highspeed"))
 		cfg->host_caps |= MMC_CAP(SD_HS);
@@ -459,6 +506,10 @@ static const struct blk_ops mmc_blk_ops = {
 	.erase	= mmc_berase,
 #endif
 	.select_hwpart	= mmc_select_hwpart,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit	= mmc_bsubmit,
+	.poll	= mmc_bpoll,
+#endif
 };
 
 U_BOOT_DRIVER(mmc_blk) = {
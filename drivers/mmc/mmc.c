@@ -372,11 +372,42 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	if (blkcnt < 2 || mmc->host_caps & MMC_CAP_AUTO_STOP)
+		return 0;
+
+	/* The count has 16 bits on eMMC, so longer transfers are stopped */
+	if (!(mmc->host_caps & mmc->card_caps & MMC_CAP_CMD23) ||
+	    blkcnt > 0xffff)
+		return 1;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blkcnt;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
+int mmc_stop_transmission(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = MMC_RSP_R1b;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	int stop;
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -395,19 +426,18 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	data.blocksize = mmc->read_bl_len;
 	data.flags = MMC_DATA_READ;
 
+	stop = mmc_set_block_count(mmc, blkcnt);
+	if (stop < 0)
+		return 0;
+
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
-		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
-		cmd.cmdarg = 0;
-		cmd.resp_type = MMC_RSP_R1b;
-		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+	if (stop && mmc_stop_transmission(mmc)) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-			pr_err("mmc fail to send stop cmd\n");
+		pr_err("mmc fail to send stop cmd\n");
 #endif
-			return 0;
-		}
+		return 0;
 	}
 
 	return blkcnt;
@@ -482,6 +512,79 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && CONFIG_IS_ENABLED(DM_MMC)
+int mmc_bsubmit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_cmd *cmd;
+	struct mmc_data *data;
+	int ret;
+
+	/* Only reads which fit in one command are done asynchronously */
+	if (!mmc || req->write ||
+	    req->blkcnt > mmc_get_b_max(mmc, req->buffer, req->blkcnt))
+		return -ENOSYS;
+	if (mmc->async_req)
+		return -EBUSY;
+	if (blk_dselect_hwpart(block_dev, block_dev->hwpart) < 0)
+		return -EIO;
+	if (req->start + req->blkcnt > block_dev->lba)
+		return -EINVAL;
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
+		return -EIO;
+
+	cmd = &mmc->async_cmd;
+	data = &mmc->async_data;
+	if (req->blkcnt > 1)
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+	else
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+	if (mmc->high_capacity)
+		cmd->cmdarg = req->start;
+	else
+		cmd->cmdarg = req->start * mmc->read_bl_len;
+	cmd->resp_type = MMC_RSP_R1;
+	data->dest = req->buffer;
+	data->blocks = req->blkcnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
+
+	ret = mmc_set_block_count(mmc, req->blkcnt);
+	if (ret < 0)
+		return -EIO;
+	mmc->async_stop = ret;
+
+	ret = mmc_send_cmd_start(mmc, cmd, data);
+	if (ret)
+		return ret;
+	mmc->async_req = req;
+
+	return 0;
+}
+
+int mmc_bpoll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int ret;
+
+	ret = mmc_send_cmd_poll(mmc, &mmc->async_cmd, &mmc->async_data);
+	if (ret == -EBUSY)
+		return ret;
+	mmc->async_req = NULL;
+
+	if (!ret && mmc->async_stop) {
+		ret = mmc_stop_transmission(mmc);
+		if (ret)
+			pr_err("mmc fail to send stop cmd\n");
+	}
+	req->result = ret ? -EIO : req->blkcnt;
+
+	return 0;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -911,6 +1014,10 @@ static int mmc_get_capabilities(struct mmc *mmc)
 	if (mmc_host_is_spi(mmc))
 		return 0;
 
+	/* SET_BLOCK_COUNT is supported from version 3 */
+	if (mmc->version >= MMC_VERSION_3)
+		mmc->card_caps |= MMC_CAP_CMD23;
+
 	/* Only version 4 supports high-speed */
 	if (mmc->version < MMC_VERSION_4)
 		return 0;
@@ -1316,6 +1423,8 @@ retry_scr:
 
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
+	if (mmc->scr[0] & SD_SCR_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_CAP_CMD23;
 
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
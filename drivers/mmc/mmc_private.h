@@ -12,10 +12,35 @@
 #include <mmc.h>
 
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data);
+int mmc_send_cmd_start(struct mmc *mmc, struct mmc_cmd *cmd,
+		       struct mmc_data *data);
+int mmc_send_cmd_poll(struct mmc *mmc, struct mmc_cmd *cmd,
+		      struct mmc_data *data);
 int mmc_send_status(struct mmc *mmc, unsigned int *status);
 int mmc_poll_for_busy(struct mmc *mmc, int timeout);
 
 int mmc_set_blocklen(struct mmc *mmc, int len);
+
+/**
+ * mmc_set_block_count() - Prepare for a transfer of @blkcnt blocks
+ *
+ * Sends SET_BLOCK_COUNT ahead of a multiple-block transfer if the host and
+ * card both support it, so that the transfer stops by itself.
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks to be transferred by the next command
+ * @return 1 if the transfer must be ended with mmc_stop_transmission(), 0 if
+ *	it need not be, -ve on error
+ */
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
+/**
+ * mmc_stop_transmission() - Send STOP_TRANSMISSION to end a transfer
+ *
+ * @mmc:	MMC device
+ * @return 0 if OK, -ve on error
+ */
+int mmc_stop_transmission(struct mmc *mmc);
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -28,6 +53,11 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
 #endif
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+int mmc_bsubmit(struct udevice *dev, struct blk_req *req);
+int mmc_bpoll(struct udevice *dev, struct blk_req *req);
+#endif
+
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 
 #if CONFIG_IS_ENABLED(BLK)
@@ -7,11 +7,14 @@
  * MMC driver for allwinner sunxi platform.
  */
 
+#include <bouncebuf.h>
 #include <common.h>
+#include <cpu_func.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <clk.h>
 #include <reset.h>
@@ -22,10 +25,15 @@
 #include <asm/arch/mmc.h>
 #include <asm-generic/gpio.h>
 #include <linux/delay.h>
+#include "sunxi_mmc.h"
+
+/* Largest buffer a single IDMAC descriptor can describe on older SoCs */
+#define SUNXI_MMC_IDMA_DES_BITS_DEFAULT	13
 
 #ifdef CONFIG_DM_MMC
 struct sunxi_mmc_variant {
 	u16 mclk_offset;
+	u8 idma_des_size_bits;
 };
 #endif
 
@@ -42,6 +50,12 @@ struct sunxi_mmc_priv {
 	int cd_inverted;		/* Inverted Card Detect */
 	struct sunxi_mmc *reg;
 	struct mmc_config cfg;
+	struct sunxi_mmc_des *des;	/* IDMAC descriptors, NULL for PIO */
+	uint des_bits;			/* log2 of max bytes per descriptor */
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct bounce_buffer async_bb;	/* buffer of the command in progress */
+	ulong async_start;		/* time it was started */
+#endif
 #ifdef CONFIG_DM_MMC
 	const struct sunxi_mmc_variant *variant;
 #endif
@@ -319,7 +333,7 @@ static int mmc_trans_data_by_cpu(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 	if (timeout_msecs < 2000)
 		timeout_msecs = 2000;
 
-	/* Always read / write data through the CPU */
+	/* Read / write data through the CPU */
 	setbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_ACCESS_BY_AHB);
 
 	start = get_timer(0);
@@ -339,6 +353,116 @@ static int mmc_trans_data_by_cpu(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(MMC_SUNXI_IDMA)
+/*
+ * Allocate the IDMAC descriptor table and limit the transfer size to what it
+ * can describe. If the allocation fails, data is moved by the CPU.
+ */
+static void sunxi_mmc_idma_init(struct sunxi_mmc_priv *priv,
+				struct mmc_config *cfg, uint des_bits)
+{
+	ulong max_blks;
+
+	priv->des_bits = des_bits;
+	priv->des = memalign(ARCH_DMA_MINALIGN, ALIGN(SUNXI_MMC_IDMA_DES_NUM *
+			     sizeof(struct sunxi_mmc_des), ARCH_DMA_MINALIGN));
+	if (!priv->des) {
+		debug("mmc %u: no memory for IDMAC, using PIO\n", priv->mmc_no);
+		return;
+	}
+
+	max_blks = (SUNXI_MMC_IDMA_DES_NUM << des_bits) / 512;
+	if (cfg->b_max > max_blks)
+		cfg->b_max = max_blks;
+}
+
+/*
+ * Set up the descriptor chain and start the IDMAC. Returns 0 if the transfer
+ * will be done by DMA, or an error if the caller should fall back to PIO.
+ */
+static int mmc_trans_data_by_dma_start(struct sunxi_mmc_priv *priv,
+				       struct mmc_data *data,
+				       struct bounce_buffer *bbstate)
+{
+	const int reading = !!(data->flags & MMC_DATA_READ);
+	unsigned byte_cnt = data->blocksize * data->blocks;
+	struct sunxi_mmc_des *des = priv->des;
+	void *buf;
+	int ret, num;
+
+	if (!des)
+		return -ENOSYS;
+	if (reading)
+		ret = bounce_buffer_start(bbstate, data->dest, byte_cnt,
+					  GEN_BB_WRITE);
+	else
+		ret = bounce_buffer_start(bbstate, (void *)data->src, byte_cnt,
+					  GEN_BB_READ);
+	if (ret)
+		return ret;
+	buf = bbstate->bounce_buffer;
+
+	num = sunxi_mmc_idma_build(des, SUNXI_MMC_IDMA_DES_NUM,
+				   (ulong)buf, byte_cnt, priv->des_bits);
+	if (num < 0) {
+		bounce_buffer_stop(bbstate);
+		return num;
+	}
+	flush_dcache_range((ulong)des,
+			   ALIGN((ulong)&des[num], ARCH_DMA_MINALIGN));
+
+	clrbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_ACCESS_BY_AHB);
+	setbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DMA_ENABLE |
+		     SUNXI_MMC_GCTRL_DMA_RESET);
+	writel(SUNXI_MMC_IDMAC_RESET, &priv->reg->dmac);
+	writel(readl(&priv->reg->idst), &priv->reg->idst);
+	writel(0, &priv->reg->idie);
+	writel((u32)(ulong)des, &priv->reg->dlba);
+	writel(SUNXI_MMC_FTRGLEVEL_IDMA, &priv->reg->ftrglevel);
+	writel(SUNXI_MMC_IDMAC_FIXBURST | SUNXI_MMC_IDMAC_ENABLE,
+	       &priv->reg->dmac);
+
+	return 0;
+}
+
+static int mmc_trans_data_by_dma_stop(struct sunxi_mmc_priv *priv,
+				      struct bounce_buffer *bbstate)
+{
+	u32 idst = readl(&priv->reg->idst);
+
+	writel(idst, &priv->reg->idst);
+	writel(0, &priv->reg->dmac);
+	clrbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DMA_ENABLE);
+	setbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DMA_RESET);
+	bounce_buffer_stop(bbstate);
+
+	if (idst & SUNXI_MMC_IDST_ERROR) {
+		debug("mmc %u: IDMAC error %x\n", priv->mmc_no, idst);
+		return -EIO;
+	}
+
+	return 0;
+}
+#else
+static void sunxi_mmc_idma_init(struct sunxi_mmc_priv *priv,
+				struct mmc_config *cfg, uint des_bits)
+{
+}
+
+static int mmc_trans_data_by_dma_start(struct sunxi_mmc_priv *priv,
+				       struct mmc_data *data,
+				       struct bounce_buffer *bbstate)
+{
+	return -ENOSYS;
+}
+
+static int mmc_trans_data_by_dma_stop(struct sunxi_mmc_priv *priv,
+				      struct bounce_buffer *bbstate)
+{
+	return 0;
+}
+#endif
+
 static int mmc_rint_wait(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 			 uint timeout_msecs, uint done_bit, const char *what)
 {
@@ -358,22 +482,18 @@ static int mmc_rint_wait(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 	return 0;
 }
 
-static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
-				     struct mmc *mmc, struct mmc_cmd *cmd,
-				     struct mmc_data *data)
+/*
+ * Send a command and, without DMA, transfer its data. With DMA the transfer
+ * must have been started with mmc_trans_data_by_dma_start() already.
+ */
+static int sunxi_mmc_cmd_issue(struct sunxi_mmc_priv *priv, struct mmc *mmc,
+			       struct mmc_cmd *cmd, struct mmc_data *data,
+			       bool use_dma)
 {
 	unsigned int cmdval = SUNXI_MMC_CMD_START;
-	unsigned int timeout_msecs;
-	int error = 0;
-	unsigned int status = 0;
-	unsigned int bytecnt = 0;
 
-	if (priv->fatal_err)
-		return -1;
 	if (cmd->resp_type & MMC_RSP_BUSY)
 		debug("mmc cmd %d check rsp busy\n", cmd->cmdidx);
-	if (cmd->cmdidx == 12)
-		return 0;
 
 	if (!cmd->cmdidx)
 		cmdval |= SUNXI_MMC_CMD_SEND_INIT_SEQ;
@@ -385,10 +505,8 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 		cmdval |= SUNXI_MMC_CMD_CHK_RESPONSE_CRC;
 
 	if (data) {
-		if ((u32)(long)data->dest & 0x3) {
-			error = -1;
-			goto out;
-		}
+		if (!use_dma && (u32)(long)data->dest & 0x3)
+			return -1;
 
 		cmdval |= SUNXI_MMC_CMD_DATA_EXPIRE|SUNXI_MMC_CMD_WAIT_PRE_OVER;
 		if (data->flags & MMC_DATA_WRITE)
@@ -414,25 +532,43 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 	if (data) {
 		int ret = 0;
 
-		bytecnt = data->blocksize * data->blocks;
-		debug("trans data %d bytes\n", bytecnt);
+		debug("trans data %d bytes\n", data->blocksize * data->blocks);
 		writel(cmdval | cmd->cmdidx, &priv->reg->cmd);
-		ret = mmc_trans_data_by_cpu(priv, mmc, data);
-		if (ret) {
-			error = readl(&priv->reg->rint) &
-				SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT;
-			error = -ETIMEDOUT;
-			goto out;
-		}
+		if (!use_dma)
+			ret = mmc_trans_data_by_cpu(priv, mmc, data);
+		if (ret)
+			return -ETIMEDOUT;
 	}
 
+	return 0;
+}
+
+/*
+ * Wait for a command sent by sunxi_mmc_cmd_issue() to finish, read its
+ * response and clean up. If @error is set, the command failed already and
+ * this only cleans up.
+ */
+static int sunxi_mmc_cmd_finish(struct sunxi_mmc_priv *priv, struct mmc *mmc,
+				struct mmc_cmd *cmd, struct mmc_data *data,
+				struct bounce_buffer *bbstate, bool use_dma,
+				int error)
+{
+	unsigned int timeout_msecs;
+	unsigned int status = 0;
+	unsigned int bytecnt;
+
+	if (error)
+		goto out;
+
 	error = mmc_rint_wait(priv, mmc, 1000, SUNXI_MMC_RINT_COMMAND_DONE,
 			      "cmd");
 	if (error)
 		goto out;
 
 	if (data) {
-		timeout_msecs = 120;
+		/* With DMA the data is still being moved at this point */
+		bytecnt = data->blocksize * data->blocks;
+		timeout_msecs = use_dma ? max(bytecnt >> 8, 2000U) : 120;
 		debug("cacl timeout %x msec\n", timeout_msecs);
 		error = mmc_rint_wait(priv, mmc, timeout_msecs,
 				      data->blocks > 1 ?
@@ -470,6 +606,12 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 		debug("mmc resp 0x%08x\n", cmd->response[0]);
 	}
 out:
+	if (use_dma) {
+		int ret = mmc_trans_data_by_dma_stop(priv, bbstate);
+
+		if (!error)
+			error = ret;
+	}
 	if (error < 0) {
 		writel(SUNXI_MMC_GCTRL_RESET, &priv->reg->gctrl);
 		mmc_update_clk(priv);
@@ -481,6 +623,27 @@ out:
 	return error;
 }
 
+static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
+				     struct mmc *mmc, struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	struct bounce_buffer bbstate;
+	bool use_dma = false;
+	int error;
+
+	if (priv->fatal_err)
+		return -1;
+	if (cmd->cmdidx == 12)
+		return 0;
+
+	if (data)
+		use_dma = !mmc_trans_data_by_dma_start(priv, data, &bbstate);
+	error = sunxi_mmc_cmd_issue(priv, mmc, cmd, data, use_dma);
+
+	return sunxi_mmc_cmd_finish(priv, mmc, cmd, data, &bbstate, use_dma,
+				    error);
+}
+
 #if !CONFIG_IS_ENABLED(DM_MMC)
 static int sunxi_mmc_set_ios_legacy(struct mmc *mmc)
 {
@@ -534,7 +697,7 @@ struct mmc *sunxi_mmc_init(int sdc_no)
 	if (sdc_no == 2)
 		cfg->host_caps = MMC_MODE_8BIT;
 #endif
-	cfg->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
+	cfg->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_CAP_AUTO_STOP;
 	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
 
 	cfg->f_min = 400000;
@@ -543,6 +706,8 @@ struct mmc *sunxi_mmc_init(int sdc_no)
 	if (mmc_resource_init(sdc_no) != 0)
 		return NULL;
 
+	sunxi_mmc_idma_init(priv, cfg, SUNXI_MMC_IDMA_DES_BITS_DEFAULT);
+
 	/* config ahb clock */
 	debug("init mmc %d clock and io\n", sdc_no);
 #if !defined(CONFIG_MACH_SUN50I_H6)
@@ -587,6 +752,52 @@ static int sunxi_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return sunxi_mmc_send_cmd_common(priv, &plat->mmc, cmd, data);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int sunxi_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				    struct mmc_data *data)
+{
+	struct sunxi_mmc_plat *plat = dev_get_platdata(dev);
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+	int error;
+
+	/* Only DMA transfers can go on in the background */
+	if (priv->fatal_err || !data ||
+	    mmc_trans_data_by_dma_start(priv, data, &priv->async_bb))
+		return -ENOSYS;
+	error = sunxi_mmc_cmd_issue(priv, &plat->mmc, cmd, data, true);
+	if (error)
+		return sunxi_mmc_cmd_finish(priv, &plat->mmc, cmd, data,
+					    &priv->async_bb, true, error);
+	priv->async_start = get_timer(0);
+
+	return 0;
+}
+
+static int sunxi_mmc_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+				   struct mmc_data *data)
+{
+	struct sunxi_mmc_plat *plat = dev_get_platdata(dev);
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+	u32 done = SUNXI_MMC_RINT_COMMAND_DONE;
+	uint timeout_msecs;
+	u32 rint;
+
+	done |= data->blocks > 1 ? SUNXI_MMC_RINT_AUTO_COMMAND_DONE :
+		SUNXI_MMC_RINT_DATA_OVER;
+	timeout_msecs = 1000 + max(data->blocksize * data->blocks >> 8,
+				   2000U);
+	rint = readl(&priv->reg->rint);
+	if ((rint & done) != done &&
+	    !(rint & SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT) &&
+	    get_timer(priv->async_start) < timeout_msecs)
+		return -EBUSY;
+
+	/* This does not wait unless the command has timed out */
+	return sunxi_mmc_cmd_finish(priv, &plat->mmc, cmd, data,
+				    &priv->async_bb, true, 0);
+}
+#endif
+
 static int sunxi_mmc_getcd(struct udevice *dev)
 {
 	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
@@ -601,6 +812,10 @@ static int sunxi_mmc_getcd(struct udevice *dev)
 
 static const struct dm_mmc_ops sunxi_mmc_ops = {
 	.send_cmd	= sunxi_mmc_send_cmd,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_start	= sunxi_mmc_send_cmd_start,
+	.send_cmd_poll	= sunxi_mmc_send_cmd_poll,
+#endif
 	.set_ios	= sunxi_mmc_set_ios,
 	.get_cd		= sunxi_mmc_getcd,
 };
@@ -626,8 +841,9 @@ static int sunxi_mmc_probe(struct udevice *dev)
 		cfg->host_caps |= MMC_MODE_8BIT;
 	if (bus_width >= 4)
 		cfg->host_caps |= MMC_MODE_4BIT;
-	cfg->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
-	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+	cfg->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_CAP_AUTO_STOP;
+	cfg->b_max = dev_read_u32_default(dev, "u-boot,max-blk-count",
+					  CONFIG_SYS_MMC_MAX_BLK_COUNT);
 
 	cfg->f_min = 400000;
 	cfg->f_max = 52000000;
@@ -635,6 +851,7 @@ static int sunxi_mmc_probe(struct udevice *dev)
 	priv->reg = (void *)dev_read_addr(dev);
 	priv->variant =
 		(const struct sunxi_mmc_variant *)dev_get_driver_data(dev);
+	sunxi_mmc_idma_init(priv, cfg, priv->variant->idma_des_size_bits);
 
 	/* We don't have a sunxi clock driver so find the clock address here */
 	ret = dev_read_phandle_with_args(dev, "clocks", "#clock-cells", 0,
@@ -689,14 +906,17 @@ static int sunxi_mmc_bind(struct udevice *dev)
 
 static const struct sunxi_mmc_variant sun4i_a10_variant = {
 	.mclk_offset = 0x88,
+	.idma_des_size_bits = 13,
 };
 
 static const struct sunxi_mmc_variant sun9i_a80_variant = {
 	.mclk_offset = 0x410,
+	.idma_des_size_bits = 16,
 };
 
 static const struct sunxi_mmc_variant sun50i_h6_variant = {
 	.mclk_offset = 0x830,
+	.idma_des_size_bits = 16,
 };
 
 static const struct udevice_id sunxi_mmc_ids[] = {
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Internal DMA (IDMAC) descriptor definitions for the Allwinner sunxi
+ * SD/MMC controller.
+ *
+ * These are kept separate from asm/arch/mmc.h so that the descriptor chain
+ * builder can be compiled and tested on sandbox.
+ */
+
+#ifndef _SUNXI_MMC_IDMA_H
+#define _SUNXI_MMC_IDMA_H
+
+#include <linux/types.h>
+
+/**
+ * struct sunxi_mmc_des - IDMAC descriptor, used in chained mode
+ *
+ * @config:	SUNXI_MMC_IDMA_DES0_... flags
+ * @buf_size:	Number of bytes in the buffer, 0 means the maximum size
+ * @buf_addr:	Bus address of the data buffer
+ * @next_addr:	Bus address of the next descriptor, 0 for the last one
+ */
+struct sunxi_mmc_des {
+	u32 config;
+	u32 buf_size;
+	u32 buf_addr;
+	u32 next_addr;
+};
+
+#define SUNXI_MMC_IDMA_DES0_DIC		(0x1 << 1)	/* no irq on done */
+#define SUNXI_MMC_IDMA_DES0_LD		(0x1 << 2)	/* last descriptor */
+#define SUNXI_MMC_IDMA_DES0_FD		(0x1 << 3)	/* first descriptor */
+#define SUNXI_MMC_IDMA_DES0_CH		(0x1 << 4)	/* chain mode */
+#define SUNXI_MMC_IDMA_DES0_ER		(0x1 << 5)	/* end of ring */
+#define SUNXI_MMC_IDMA_DES0_CES		(0x1 << 30)	/* card error summary */
+#define SUNXI_MMC_IDMA_DES0_OWN		(0x1 << 31)	/* owned by IDMAC */
+
+/* Number of descriptors allocated per host */
+#define SUNXI_MMC_IDMA_DES_NUM		128
+
+/**
+ * sunxi_mmc_idma_build() - Fill in an IDMAC descriptor chain
+ *
+ * The buffer is split into pieces of at most (1 << @des_bits) bytes, one per
+ * descriptor. Each descriptor is linked to the next one by its address; the
+ * first one is flagged FD and the last one LD/ER with its interrupt enabled.
+ *
+ * @des:	Descriptor table to fill in
+ * @max_des:	Number of entries available in @des
+ * @buf:	Bus address of the data buffer (must be DMA-aligned)
+ * @len:	Number of bytes to transfer
+ * @des_bits:	log2 of the maximum buffer size of a single descriptor
+ * @return number of descriptors used, -EINVAL if @len is 0, or -E2BIG if
+ *	the buffer does not fit into @max_des descriptors
+ */
+int sunxi_mmc_idma_build(struct sunxi_mmc_des *des, int max_des, ulong buf,
+			 uint len, uint des_bits);
+
+#endif /* _SUNXI_MMC_IDMA_H */
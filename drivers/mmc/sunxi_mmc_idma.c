@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Descriptor chain builder for the sunxi SD/MMC internal DMA controller
+ *
+ * Based on the Linux sunxi-mmc driver.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include "sunxi_mmc.h"
+
+int sunxi_mmc_idma_build(struct sunxi_mmc_des *des, int max_des, ulong buf,
+			 uint len, uint des_bits)
+{
+	const uint max_len = 1U << des_bits;
+	int i;
+
+	if (!len)
+		return -EINVAL;
+	if (DIV_ROUND_UP(len, max_len) > max_des)
+		return -E2BIG;
+
+	for (i = 0; len; i++) {
+		uint size = min(len, max_len);
+
+		des[i].config = SUNXI_MMC_IDMA_DES0_CH | SUNXI_MMC_IDMA_DES0_OWN |
+				SUNXI_MMC_IDMA_DES0_DIC;
+		/* A size of 0 means the maximum the descriptor can hold */
+		des[i].buf_size = size == max_len ? 0 : size;
+		des[i].buf_addr = (u32)buf;
+		des[i].next_addr = (u32)(ulong)&des[i + 1];
+
+		buf += size;
+		len -= size;
+	}
+
+	des[0].config |= SUNXI_MMC_IDMA_DES0_FD;
+	des[i - 1].config |= SUNXI_MMC_IDMA_DES0_LD | SUNXI_MMC_IDMA_DES0_ER;
+	des[i - 1].config &= ~SUNXI_MMC_IDMA_DES0_DIC;
+	des[i - 1].next_addr = 0;
+
+	return i;
+}
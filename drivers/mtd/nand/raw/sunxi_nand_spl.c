@@ -83,6 +83,8 @@
 #define NFC_CMD_RNDOUTSTART        0xE0
 #define NFC_CMD_RNDOUT             0x05
 #define NFC_CMD_READSTART          0x30
+#define NFC_CMD_READCACHESEQ       0x31
+#define NFC_CMD_READCACHEEND       0x3F
 
 struct nfc_config {
 	int page_size;
@@ -439,8 +441,78 @@ static int nand_detect_ecc_config(struct nfc_config *conf, u32 offs,
 	return -EINVAL;
 }
 
+/* Size of an eraseblock, or 0 if the board does not give it */
+static u32 nand_block_size(void)
+{
+#ifdef CONFIG_SYS_NAND_BLOCK_SIZE
+	return CONFIG_SYS_NAND_BLOCK_SIZE;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Check the bad block marker, i.e. the first OOB byte of the first page, of
+ * the eraseblock at @offs. It is read raw: Linux writes it so that it is 0xff
+ * on flash in good blocks even when the randomizer is used.
+ */
+static int nand_is_bad_block(const struct nfc_config *conf, u32 offs)
+{
+	int ret;
+
+	ret = nand_load_page(conf, offs);
+	if (!ret)
+		ret = nand_change_column(conf->page_size);
+	if (ret)
+		return ret;
+
+	writel(readl(SUNXI_NFC_BASE + NFC_ECC_CTL) &
+	       ~(NFC_ECC_EN | NFC_ECC_RANDOM_EN),
+	       SUNXI_NFC_BASE + NFC_ECC_CTL);
+	writel(1, SUNXI_NFC_BASE + NFC_CNT);
+	ret = nand_exec_cmd(NFC_DATA_TRANS);
+	if (ret)
+		return ret;
+
+	return readb(SUNXI_NFC_BASE + NFC_RAM0_BASE) != 0xff;
+}
+
+/* Number of bad blocks in a row which are skipped to detect the config */
+#define NAND_DETECT_MAX_BAD_BLOCKS	8
+
+/*
+ * Find the first good block from the one at @offs, with the page size and
+ * address cycles being tried, and return @offs moved into it in @probep.
+ * The bad block markers are read raw, so this works before the ECC config
+ * is known.
+ */
+static int nand_find_good_block(struct nfc_config *conf, u32 offs,
+				u32 *probep)
+{
+	u32 block_size = nand_block_size();
+	int i, ret;
+
+	*probep = offs;
+	if (!block_size)
+		return 0;
+
+	nand_apply_config(conf);
+	for (i = 0; i < NAND_DETECT_MAX_BAD_BLOCKS; i++) {
+		ret = nand_is_bad_block(conf, *probep - *probep % block_size);
+		if (ret <= 0)
+			return ret;
+		*probep += block_size;
+	}
+
+	/* Likely the wrong page size, rather than so many bad blocks */
+	return -ENOENT;
+}
+
 static int nand_detect_config(struct nfc_config *conf, u32 offs, void *dest)
 {
+	u32 probe;
+	int ret;
+
 	if (conf->valid)
 		return 0;
 
@@ -459,10 +531,14 @@ static int nand_detect_config(struct nfc_config *conf, u32 offs, void *dest)
 		 */
 		for (conf->page_size = 2048; conf->page_size <= max_page_size;
 		     conf->page_size <<= 1) {
-			if (nand_load_page(conf, offs))
+			/* Detect on the first good block from @offs */
+			ret = nand_find_good_block(conf, offs, &probe);
+			if (ret == -ENOENT)
+				continue;
+			if (ret || nand_load_page(conf, probe))
 				return -1;
 
-			if (!nand_detect_ecc_config(conf, offs, dest)) {
+			if (!nand_detect_ecc_config(conf, probe, dest)) {
 				conf->valid = true;
 				return 0;
 			}
@@ -472,19 +548,76 @@ static int nand_detect_config(struct nfc_config *conf, u32 offs, void *dest)
 	return -EINVAL;
 }
 
+/*
+ * Number of pages, starting at @page, which can be read with a single
+ * sequence of cache reads. The sequence stops at the end of the eraseblock,
+ * so that the next one can be checked for a bad block marker.
+ */
+static int nand_cache_read_pages(const struct nfc_config *conf, int page,
+				 int count)
+{
+	int pages_per_block = nand_block_size() / conf->page_size;
+
+	if (!IS_ENABLED(CONFIG_NAND_SUNXI_SPL_CACHE_READ))
+		return 1;
+	if (pages_per_block)
+		count = min(count, pages_per_block - page % pages_per_block);
+
+	return count;
+}
+
 static int nand_read_buffer(struct nfc_config *conf, uint32_t offs,
 			    unsigned int size, void *dest)
 {
-	int first_seed = 0, page, ret;
+	u32 block_size = nand_block_size();
+	int first_seed = 0, page, left = 0, ret;
+	bool cache = false, check = true;
 
 	size = ALIGN(size, conf->page_size);
 	page = offs / conf->page_size;
 	if (conf->randomize)
 		first_seed = page % conf->nseeds;
 
-	for (; size; size -= conf->page_size) {
-		if (nand_load_page(conf, offs))
-			return -1;
+	while (size) {
+		/*
+		 * Skip bad blocks, keeping the position within the block. No
+		 * sequence of cache reads crosses the start of a block, so
+		 * none is in progress here.
+		 */
+		if (block_size && check) {
+			ret = nand_is_bad_block(conf, offs - offs % block_size);
+			if (ret < 0)
+				return ret;
+			if (ret) {
+				debug("nand: skipping bad block at 0x%x\n",
+				      offs - offs % block_size);
+				offs += block_size;
+				page = offs / conf->page_size;
+				continue;
+			}
+			check = false;
+		}
+
+		/*
+		 * Start a new sequence: the first page is read to the cache
+		 * register with a normal read. With cache reads, each page of
+		 * the sequence is then moved to the cache register by READ
+		 * CACHE SEQUENTIAL, which starts reading the next page from
+		 * the array while this one is transferred, or READ CACHE END
+		 * for the last page.
+		 */
+		if (!left) {
+			if (nand_load_page(conf, offs))
+				return -1;
+			left = nand_cache_read_pages(conf, page,
+						     size / conf->page_size);
+			cache = left > 1;
+		}
+		if (cache && nand_exec_cmd(NFC_SEND_CMD1 | NFC_WAIT_FLAG |
+					   (left > 1 ? NFC_CMD_READCACHESEQ :
+					    NFC_CMD_READCACHEEND)))
+			return -EIO;
+		left--;
 
 		ret = nand_read_page(conf, offs, dest, conf->page_size);
 		/*
@@ -518,14 +651,42 @@ static int nand_read_buffer(struct nfc_config *conf, uint32_t offs,
 		page++;
 		offs += conf->page_size;
 		dest += conf->page_size;
+		size -= conf->page_size;
+		if (block_size && !(offs % block_size))
+			check = true;
 	}
 
 	return 0;
 }
 
+static struct nfc_config conf;
+
+unsigned int nand_page_size(void)
+{
+	return conf.valid ? conf.page_size : 1;
+}
+
+u32 nand_spl_adjust_offset(u32 sector, u32 offs)
+{
+	u32 block_size = nand_block_size();
+	u32 block, last;
+
+	if (!block_size || !conf.valid)
+		return offs;
+
+	last = (sector + offs) / block_size;
+	for (block = sector / block_size; block <= last; block++) {
+		if (nand_is_bad_block(&conf, block * block_size) > 0) {
+			offs += block_size;
+			last++;
+		}
+	}
+
+	return offs;
+}
+
 int nand_spl_load_image(uint32_t offs, unsigned int size, void *dest)
 {
-	static struct nfc_config conf = { };
 	int ret;
 
 	ret = nand_detect_config(&conf, offs, dest);
@@ -48,6 +48,10 @@ static int spi_flash_probe_slave(struct spi_flash *flash)
 #if CONFIG_IS_ENABLED(SPI_FLASH_MTD)
 	ret = spi_flash_mtd_register(flash);
 #endif
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	if (ret)
+		spi_nor_remove(flash);
+#endif
 
 err_read_id:
 	spi_release_bus(spi);
@@ -86,6 +90,9 @@ void spi_flash_free(struct spi_flash *flash)
 {
 #if CONFIG_IS_ENABLED(SPI_FLASH_MTD)
 	spi_flash_mtd_unregister();
+#endif
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	spi_nor_remove(flash);
 #endif
 	spi_free_slave(flash->spi);
 	free(flash);
@@ -155,6 +162,9 @@ static int spi_flash_std_remove(struct udevice *dev)
 {
 #if CONFIG_IS_ENABLED(SPI_FLASH_MTD)
 	spi_flash_mtd_unregister();
+#endif
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	spi_nor_remove(dev_get_uclass_priv(dev));
 #endif
 	return 0;
 }
@@ -38,6 +38,12 @@
 
 #define DEFAULT_READY_WAIT_JIFFIES		(40UL * HZ)
 
+/* Reads shorter than this do not use the direct mapping */
+#define SPI_NOR_DIRMAP_MIN_LEN			256
+
+/* Number of bytes compared when calibrating the read settings */
+#define SPI_NOR_CALIB_LEN			256
+
 static int spi_nor_read_write_reg(struct spi_nor *nor, struct spi_mem_op
 		*op, void *buf)
 {
@@ -73,26 +79,43 @@ static int spi_nor_write_reg(struct spi_nor *nor, u8 opcode, u8 *buf, int len)
 	return spi_nor_read_write_reg(nor, &op, buf);
 }
 
-static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
-				 u_char *buf)
+/* Set up @op for the (Fast) Read command currently selected for @nor */
+static void spi_nor_get_read_op(struct spi_nor *nor, struct spi_mem_op *op,
+				loff_t from, size_t len, u_char *buf)
 {
-	struct spi_mem_op op =
+	struct spi_mem_op tmpl =
 			SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 1),
 				   SPI_MEM_OP_ADDR(nor->addr_width, from, 1),
 				   SPI_MEM_OP_DUMMY(nor->read_dummy, 1),
 				   SPI_MEM_OP_DATA_IN(len, buf, 1));
-	size_t remaining = len;
-	int ret;
+
+	*op = tmpl;
 
 	/* get transfer protocols. */
-	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
-	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
-	op.dummy.buswidth = op.addr.buswidth;
-	op.data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+	op->cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
+	op->addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
+	op->dummy.buswidth = op->addr.buswidth;
+	op->data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
 
 	/* convert the dummy cycles to the number of bytes */
-	op.dummy.nbytes = (nor->read_dummy * op.dummy.buswidth) / 8;
+	op->dummy.nbytes = (nor->read_dummy * op->dummy.buswidth) / 8;
+}
+
+static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
+				 u_char *buf)
+{
+	struct spi_mem_op op;
+	size_t remaining = len;
+	int ret;
+
+	/*
+	 * The direct mapping may return less than asked for, in which case
+	 * spi_nor_read() calls back for the rest
+	 */
+	if (nor->dirmap.rdesc && len >= SPI_NOR_DIRMAP_MIN_LEN)
+		return spi_mem_dirmap_read(nor->dirmap.rdesc, from, len, buf);
 
+	spi_nor_get_read_op(nor, &op, from, len, buf);
 	while (remaining) {
 		op.data.nbytes = remaining < UINT_MAX ? remaining : UINT_MAX;
 		ret = spi_mem_adjust_op_size(nor->spi, &op);
@@ -310,6 +333,7 @@ static void spi_nor_set_4byte_opcodes(struct spi_nor *nor,
 	nor->read_opcode = spi_nor_convert_3to4_read(nor->read_opcode);
 	nor->program_opcode = spi_nor_convert_3to4_program(nor->program_opcode);
 	nor->erase_opcode = spi_nor_convert_3to4_erase(nor->erase_opcode);
+	nor->flags |= SNOR_F_4B_OPCODES;
 }
 #endif /* !CONFIG_SPI_FLASH_BAR */
 
@@ -2470,6 +2494,136 @@ static int spi_nor_init(struct spi_nor *nor)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SPI_FLASH_CALIBRATE)
+static void spi_nor_set_read(struct spi_nor *nor,
+			     const struct spi_nor_read_command *read)
+{
+	nor->read_opcode = read->opcode;
+	nor->read_proto = read->proto;
+	nor->read_dummy = read->num_mode_clocks + read->num_wait_states;
+	if (nor->flags & SNOR_F_4B_OPCODES)
+		nor->read_opcode = spi_nor_convert_3to4_read(nor->read_opcode);
+}
+
+/**
+ * spi_nor_calibrate_read() - Select the fastest read settings which work
+ *
+ * SFDP and the SPI mode only tell which read commands both the flash and the
+ * controller support, not whether the board carries them at the bus clock.
+ * Read the start of the flash with a plain Read (03h) at a quarter of the
+ * clock, then with each shared read command at the full and half clock. The
+ * setting which gives the same data with the highest throughput is kept.
+ *
+ * This needs data which is not all the same, so nothing changes on a flash
+ * which is erased at its start.
+ *
+ * @nor:		SPI NOR, with the read command selected by spi_nor_setup()
+ * @params:		Parameters of the flash
+ * @shared_hwcaps:	Capabilities of both the flash and the controller
+ */
+static void spi_nor_calibrate_read(struct spi_nor *nor,
+				   const struct spi_nor_flash_parameter *params,
+				   u32 shared_hwcaps)
+{
+	const struct spi_nor_read_command *read, *best = NULL;
+	u8 ref[SPI_NOR_CALIB_LEN], buf[SPI_NOR_CALIB_LEN];
+	struct spi_slave *spi = nor->spi;
+	uint max_hz = spi->max_hz, hz, best_hz = max_hz;
+	ulong rate, best_rate = 0;
+	struct spi_mem_op op;
+	u8 read_opcode, read_dummy;
+	enum spi_nor_protocol read_proto;
+	u32 hwcaps;
+	int cmd, div, i;
+
+	read_opcode = nor->read_opcode;
+	read_proto = nor->read_proto;
+	read_dummy = nor->read_dummy;
+
+	spi_nor_set_read(nor, &params->reads[SNOR_CMD_READ]);
+	spi->max_hz = max_hz / 4;
+	if (spi_nor_read_data(nor, 0, sizeof(ref), ref) != sizeof(ref) ||
+	    !memchr_inv(ref, ref[0], sizeof(ref))) {
+		dev_dbg(nor->dev, "no data to calibrate reads with\n");
+		goto done;
+	}
+
+	for (hwcaps = shared_hwcaps & SNOR_HWCAPS_READ_MASK; hwcaps;
+	     hwcaps &= ~BIT(i)) {
+		i = fls(hwcaps) - 1;
+		cmd = spi_nor_hwcaps_read2cmd(BIT(i));
+		if (cmd < 0)
+			continue;
+		read = &params->reads[cmd];
+		/* SPI n-n-n protocols are not supported yet */
+		if (spi_nor_get_protocol_inst_nbits(read->proto) != 1)
+			continue;
+		spi_nor_set_read(nor, read);
+		spi_nor_get_read_op(nor, &op, 0, 0, NULL);
+		if (!spi_mem_supports_op(spi, &op))
+			continue;
+
+		for (div = 1; div <= 2; div *= 2) {
+			hz = max_hz / div;
+			rate = (max_hz ? hz / 1000 : 1) *
+				spi_nor_get_protocol_data_nbits(read->proto);
+			if (rate <= best_rate)
+				break;
+			spi->max_hz = hz;
+			if (spi_nor_read_data(nor, 0, sizeof(buf), buf) ==
+			    sizeof(buf) && !memcmp(buf, ref, sizeof(buf))) {
+				best = read;
+				best_hz = hz;
+				best_rate = rate;
+				break;
+			}
+			/* Without a maximum clock, only the command can change */
+			if (!max_hz)
+				break;
+		}
+	}
+
+	if (best) {
+		spi_nor_set_read(nor, best);
+		spi->max_hz = best_hz;
+		dev_dbg(nor->dev, "reading with %02xh at %u Hz\n",
+			nor->read_opcode, best_hz);
+		return;
+	}
+	dev_dbg(nor->dev, "no read settings work, keeping SFDP ones\n");
+done:
+	nor->read_opcode = read_opcode;
+	nor->read_proto = read_proto;
+	nor->read_dummy = read_dummy;
+	spi->max_hz = max_hz;
+}
+#endif /* SPI_FLASH_CALIBRATE */
+
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+/* Map the whole flash for reads, with the read command selected for it */
+static void spi_nor_create_read_dirmap(struct spi_nor *nor)
+{
+	struct spi_mem_dirmap_info info = {
+		.offset = 0,
+		.length = nor->mtd.size,
+	};
+	struct spi_mem_dirmap_desc *desc;
+
+	/* Reads are split at each bank with a bank address register */
+	if (IS_ENABLED(CONFIG_SPI_FLASH_BAR) && nor->mtd.size > SZ_16M)
+		return;
+
+	spi_nor_get_read_op(nor, &info.op_tmpl, 0, 0, NULL);
+	desc = spi_mem_dirmap_create(nor->spi, &info);
+	if (IS_ERR(desc)) {
+		dev_dbg(nor->dev, "cannot map flash for reads (err=%ld)\n",
+			PTR_ERR(desc));
+		return;
+	}
+	nor->dirmap.rdesc = desc;
+}
+#endif /* SPI_DIRMAP */
+
 int spi_nor_scan(struct spi_nor *nor)
 {
 	struct spi_nor_flash_parameter params;
@@ -2625,6 +2779,13 @@ int spi_nor_scan(struct spi_nor *nor)
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(SPI_FLASH_CALIBRATE)
+	spi_nor_calibrate_read(nor, &params, hwcaps.mask & params.hwcaps.mask);
+#endif
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	spi_nor_create_read_dirmap(nor);
+#endif
+
 	nor->name = mtd->name;
 	nor->size = mtd->size;
 	nor->erase_size = mtd->erasesize;
@@ -2641,6 +2802,12 @@ int spi_nor_scan(struct spi_nor *nor)
 	return 0;
 }
 
+void spi_nor_remove(struct spi_nor *nor)
+{
+	spi_mem_dirmap_destroy(nor->dirmap.rdesc);
+	nor->dirmap.rdesc = NULL;
+}
+
 /* U-Boot specific functions, need to extend MTD to support these */
 int spi_flash_cmd_get_sw_write_prot(struct spi_nor *nor)
 {
@@ -832,6 +832,8 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_read_ahead_hdrs(ubi, pnum);
+
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1213,6 +1215,27 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	kfree(ai);
 }
 
+/**
+ * alloc_hdrs_buf - allocate the buffer for reading headers ahead.
+ * @ubi: UBI device description object
+ *
+ * Scanning works without the buffer, only slower, so failing to allocate it is
+ * not an error.
+ */
+static void alloc_hdrs_buf(struct ubi_device *ubi)
+{
+	ubi->hdrs_len = 0;
+	ubi->hdrs_buf = kmalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize,
+				GFP_KERNEL);
+}
+
+static void free_hdrs_buf(struct ubi_device *ubi)
+{
+	ubi->hdrs_len = 0;
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
+}
+
 /**
  * scan_all - scan entire MTD device.
  * @ubi: UBI device description object
@@ -1241,6 +1264,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	alloc_hdrs_buf(ubi);
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -1249,6 +1273,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		if (err < 0)
 			goto out_vidh;
 	}
+	free_hdrs_buf(ubi);
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1293,6 +1318,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	return 0;
 
 out_vidh:
+	free_hdrs_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
@@ -1350,6 +1376,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (!vidh)
 		goto out_ech;
 
+	alloc_hdrs_buf(ubi);
 	for (pnum = 0; pnum < UBI_FM_MAX_START; pnum++) {
 		int vol_id = -1;
 		unsigned long long sqnum = -1;
@@ -1366,6 +1393,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 		}
 	}
 
+	free_hdrs_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 	kfree(ech);
 
@@ -1380,6 +1408,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	return ubi_scan_fastmap(ubi, *ai, fm_anchor);
 
 out_vidh:
+	free_hdrs_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
@@ -1017,6 +1017,19 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 			goto out_detach;
 	}
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	/*
+	 * A device attached by scanning gets a fastmap when it is detached,
+	 * which U-Boot seldom does before booting. Write it now so that the
+	 * next attach, here or in the SPL, does not need to scan.
+	 */
+	if (!ubi->fm && !ubi->fm_disabled && !ubi->ro_mode) {
+		err = ubi_update_fastmap(ubi);
+		if (err)
+			ubi_warn(ubi, "unable to write a fastmap: %d", err);
+	}
+#endif
+
 	err = uif_init(ubi, &ref);
 	if (err)
 		goto out_detach;
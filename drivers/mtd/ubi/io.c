@@ -136,6 +136,12 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	/* Headers read ahead by 'ubi_io_read_ahead_hdrs()' */
+	if (pnum == ubi->hdrs_pnum && offset + len <= ubi->hdrs_len) {
+		memcpy(buf, ubi->hdrs_buf + offset, len);
+		return 0;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -211,6 +217,34 @@ retry:
 	return err;
 }
 
+/**
+ * ubi_io_read_ahead_hdrs - read the EC and VID headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ *
+ * Attaching by scanning reads both headers of each physical eraseblock. This
+ * function reads them with a single flash read into @ubi->hdrs_buf, from where
+ * 'ubi_io_read()' then copies them. This saves a flash command per eraseblock,
+ * and a whole page read on NAND when both headers are in the same page.
+ *
+ * Nothing is kept if the read returned an error or bit-flips, so that the
+ * headers are then read and checked one by one as usual.
+ */
+void ubi_io_read_ahead_hdrs(struct ubi_device *ubi, int pnum)
+{
+	int len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+
+	ubi->hdrs_len = 0;
+	if (!ubi->hdrs_buf)
+		return;
+
+	if (ubi_io_read(ubi, ubi->hdrs_buf, pnum, 0, len))
+		return;
+
+	ubi->hdrs_pnum = pnum;
+	ubi->hdrs_len = len;
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -238,6 +272,8 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	dbg_io("write %d bytes to PEB %d:%d", len, pnum, offset);
 
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_len = 0;
 	ubi_assert(offset >= 0 && offset + len <= ubi->peb_size);
 	ubi_assert(offset % ubi->hdrs_min_io_size == 0);
 	ubi_assert(len > 0 && len % ubi->hdrs_min_io_size == 0);
@@ -566,6 +602,8 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 	int err, ret = 0;
 
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_len = 0;
 
 	err = self_check_not_bad(ubi, pnum);
 	if (err != 0)
@@ -526,6 +526,9 @@ struct ubi_debug_info {
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
+ * @hdrs_buf: EC and VID headers read ahead while attaching by scanning
+ * @hdrs_pnum: physical eraseblock whose headers are in @hdrs_buf
+ * @hdrs_len: count of valid bytes in @hdrs_buf, zero if none
  * @ckvol_mutex: serializes static volume checking when opening
  *
  * @dbg: debugging information for this UBI device
@@ -625,6 +628,9 @@ struct ubi_device {
 
 	void *peb_buf;
 	struct mutex buf_mutex;
+	void *hdrs_buf;
+	int hdrs_pnum;
+	int hdrs_len;
 	struct mutex ckvol_mutex;
 
 	struct ubi_debug_info dbg;
@@ -885,6 +891,7 @@ int ubi_ensure_anchor_pebs(struct ubi_device *ubi);
 /* io.c */
 int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len);
+void ubi_io_read_ahead_hdrs(struct ubi_device *ubi, int pnum);
 int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		 int len);
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
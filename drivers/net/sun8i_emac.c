@@ -32,6 +32,7 @@
 #if CONFIG_IS_ENABLED(DM_GPIO)
 #include <asm-generic/gpio.h>
 #endif
+#include "sun8i_emac.h"
 
 #define MDIO_CMD_MII_BUSY		BIT(0)
 #define MDIO_CMD_MII_WRITE		BIT(1)
@@ -41,19 +42,8 @@
 #define MDIO_CMD_MII_PHY_ADDR_MASK	0x0001f000
 #define MDIO_CMD_MII_PHY_ADDR_SHIFT	12
 
-#define CONFIG_TX_DESCR_NUM	32
-#define CONFIG_RX_DESCR_NUM	32
-#define CONFIG_ETH_BUFSIZE	2048 /* Note must be dma aligned */
-
-/*
- * The datasheet says that each descriptor can transfers up to 4096 bytes
- * But later, the register documentation reduces that value to 2048,
- * using 2048 cause strange behaviours and even BSP driver use 2047
- */
-#define CONFIG_ETH_RXSIZE	2044 /* Note must fit in ETH_BUFSIZE */
-
-#define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
-#define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
+#define TX_TOTAL_BUFSIZE	(SUN8I_EMAC_BUFSIZE * CONFIG_SUN8I_EMAC_TX_DESC_NUM)
+#define RX_TOTAL_BUFSIZE	(SUN8I_EMAC_BUFSIZE * CONFIG_SUN8I_EMAC_RX_DESC_NUM)
 
 #define H3_EPHY_DEFAULT_VALUE	0x58000
 #define H3_EPHY_DEFAULT_MASK	GENMASK(31, 15)
@@ -114,18 +104,13 @@ enum emac_variant {
 	H6_EMAC,
 };
 
-struct emac_dma_desc {
-	u32 status;
-	u32 st;
-	u32 buf_addr;
-	u32 next;
-} __aligned(ARCH_DMA_MINALIGN);
-
 struct emac_eth_dev {
-	struct emac_dma_desc rx_chain[CONFIG_TX_DESCR_NUM];
-	struct emac_dma_desc tx_chain[CONFIG_RX_DESCR_NUM];
+	struct emac_dma_desc rx_chain[CONFIG_SUN8I_EMAC_RX_DESC_NUM];
+	struct emac_dma_desc tx_chain[CONFIG_SUN8I_EMAC_TX_DESC_NUM];
 	char rxbuffer[RX_TOTAL_BUFSIZE] __aligned(ARCH_DMA_MINALIGN);
 	char txbuffer[TX_TOTAL_BUFSIZE] __aligned(ARCH_DMA_MINALIGN);
+	struct emac_ring rx_ring;
+	struct emac_ring tx_ring;
 
 	u32 interface;
 	u32 phyaddr;
@@ -133,8 +118,6 @@ struct emac_eth_dev {
 	u32 speed;
 	u32 duplex;
 	u32 phy_configured;
-	u32 tx_currdescnum;
-	u32 rx_currdescnum;
 	u32 addr;
 	u32 tx_slot;
 	bool use_internal_phy;
@@ -374,61 +357,26 @@ static int sun8i_phy_init(struct emac_eth_dev *priv, void *dev)
 
 static void rx_descs_init(struct emac_eth_dev *priv)
 {
-	struct emac_dma_desc *desc_table_p = &priv->rx_chain[0];
-	char *rxbuffs = &priv->rxbuffer[0];
-	struct emac_dma_desc *desc_p;
-	u32 idx;
-
-	/* flush Rx buffers */
-	flush_dcache_range((uintptr_t)rxbuffs, (ulong)rxbuffs +
-			RX_TOTAL_BUFSIZE);
-
-	for (idx = 0; idx < CONFIG_RX_DESCR_NUM; idx++) {
-		desc_p = &desc_table_p[idx];
-		desc_p->buf_addr = (uintptr_t)&rxbuffs[idx * CONFIG_ETH_BUFSIZE]
-			;
-		desc_p->next = (uintptr_t)&desc_table_p[idx + 1];
-		desc_p->st |= CONFIG_ETH_RXSIZE;
-		desc_p->status = BIT(31);
-	}
-
-	/* Correcting the last pointer of the chain */
-	desc_p->next = (uintptr_t)&desc_table_p[0];
+	struct emac_ring *ring = &priv->rx_ring;
 
-	flush_dcache_range((uintptr_t)priv->rx_chain,
-			   (uintptr_t)priv->rx_chain +
-			sizeof(priv->rx_chain));
+	ring->desc = priv->rx_chain;
+	ring->buf = priv->rxbuffer;
+	ring->num = CONFIG_SUN8I_EMAC_RX_DESC_NUM;
+	emac_rx_ring_init(ring);
 
-	writel((uintptr_t)&desc_table_p[0], (priv->mac_reg + EMAC_RX_DMA_DESC));
-	priv->rx_currdescnum = 0;
+	writel((uintptr_t)&ring->desc[0], priv->mac_reg + EMAC_RX_DMA_DESC);
 }
 
 static void tx_descs_init(struct emac_eth_dev *priv)
 {
-	struct emac_dma_desc *desc_table_p = &priv->tx_chain[0];
-	char *txbuffs = &priv->txbuffer[0];
-	struct emac_dma_desc *desc_p;
-	u32 idx;
-
-	for (idx = 0; idx < CONFIG_TX_DESCR_NUM; idx++) {
-		desc_p = &desc_table_p[idx];
-		desc_p->buf_addr = (uintptr_t)&txbuffs[idx * CONFIG_ETH_BUFSIZE]
-			;
-		desc_p->next = (uintptr_t)&desc_table_p[idx + 1];
-		desc_p->status = (1 << 31);
-		desc_p->st = 0;
-	}
-
-	/* Correcting the last pointer of the chain */
-	desc_p->next =  (uintptr_t)&desc_table_p[0];
+	struct emac_ring *ring = &priv->tx_ring;
 
-	/* Flush all Tx buffer descriptors */
-	flush_dcache_range((uintptr_t)priv->tx_chain,
-			   (uintptr_t)priv->tx_chain +
-			sizeof(priv->tx_chain));
+	ring->desc = priv->tx_chain;
+	ring->buf = priv->txbuffer;
+	ring->num = CONFIG_SUN8I_EMAC_TX_DESC_NUM;
+	emac_tx_ring_init(ring);
 
-	writel((uintptr_t)&desc_table_p[0], priv->mac_reg + EMAC_TX_DMA_DESC);
-	priv->tx_currdescnum = 0;
+	writel((uintptr_t)&ring->desc[0], priv->mac_reg + EMAC_TX_DMA_DESC);
 }
 
 static int _sun8i_emac_eth_init(struct emac_eth_dev *priv, u8 *enetaddr)
@@ -558,93 +506,15 @@ static int parse_phy_pins(struct udevice *dev)
 	return 0;
 }
 
-static int _sun8i_eth_recv(struct emac_eth_dev *priv, uchar **packetp)
-{
-	u32 status, desc_num = priv->rx_currdescnum;
-	struct emac_dma_desc *desc_p = &priv->rx_chain[desc_num];
-	int length = -EAGAIN;
-	int good_packet = 1;
-	uintptr_t desc_start = (uintptr_t)desc_p;
-	uintptr_t desc_end = desc_start +
-		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
-
-	ulong data_start = (uintptr_t)desc_p->buf_addr;
-	ulong data_end;
-
-	/* Invalidate entire buffer descriptor */
-	invalidate_dcache_range(desc_start, desc_end);
-
-	status = desc_p->status;
-
-	/* Check for DMA own bit */
-	if (!(status & BIT(31))) {
-		length = (desc_p->status >> 16) & 0x3FFF;
-
-		if (length < 0x40) {
-			good_packet = 0;
-			debug("RX: Bad Packet (runt)\n");
-		}
-
-		data_end = data_start + length;
-		/* Invalidate received data */
-		invalidate_dcache_range(rounddown(data_start,
-						  ARCH_DMA_MINALIGN),
-					roundup(data_end,
-						ARCH_DMA_MINALIGN));
-		if (good_packet) {
-			if (length > CONFIG_ETH_RXSIZE) {
-				printf("Received packet is too big (len=%d)\n",
-				       length);
-				return -EMSGSIZE;
-			}
-			*packetp = (uchar *)(ulong)desc_p->buf_addr;
-			return length;
-		}
-	}
-
-	return length;
-}
-
 static int _sun8i_emac_eth_send(struct emac_eth_dev *priv, void *packet,
 				int len)
 {
-	u32 v, desc_num = priv->tx_currdescnum;
-	struct emac_dma_desc *desc_p = &priv->tx_chain[desc_num];
-	uintptr_t desc_start = (uintptr_t)desc_p;
-	uintptr_t desc_end = desc_start +
-		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
-
-	uintptr_t data_start = (uintptr_t)desc_p->buf_addr;
-	uintptr_t data_end = data_start +
-		roundup(len, ARCH_DMA_MINALIGN);
-
-	/* Invalidate entire buffer descriptor */
-	invalidate_dcache_range(desc_start, desc_end);
-
-	desc_p->st = len;
-	/* Mandatory undocumented bit */
-	desc_p->st |= BIT(24);
-
-	memcpy((void *)data_start, packet, len);
-
-	/* Flush data to be sent */
-	flush_dcache_range(data_start, data_end);
-
-	/* frame end */
-	desc_p->st |= BIT(30);
-	desc_p->st |= BIT(31);
-
-	/*frame begin */
-	desc_p->st |= BIT(29);
-	desc_p->status = BIT(31);
-
-	/*Descriptors st and status field has changed, so FLUSH it */
-	flush_dcache_range(desc_start, desc_end);
+	u32 v;
+	int ret;
 
-	/* Move to next Descriptor and wrap around */
-	if (++desc_num >= CONFIG_TX_DESCR_NUM)
-		desc_num = 0;
-	priv->tx_currdescnum = desc_num;
+	ret = emac_tx_ring_send(&priv->tx_ring, packet, len);
+	if (ret)
+		return ret;
 
 	/* Start the DMA */
 	v = readl(priv->mac_reg + EMAC_TX_CTL1);
@@ -777,29 +647,8 @@ static int sun8i_emac_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct emac_eth_dev *priv = dev_get_priv(dev);
 
-	return _sun8i_eth_recv(priv, packetp);
-}
-
-static int _sun8i_free_pkt(struct emac_eth_dev *priv)
-{
-	u32 desc_num = priv->rx_currdescnum;
-	struct emac_dma_desc *desc_p = &priv->rx_chain[desc_num];
-	uintptr_t desc_start = (uintptr_t)desc_p;
-	uintptr_t desc_end = desc_start +
-		roundup(sizeof(u32), ARCH_DMA_MINALIGN);
-
-	/* Make the current descriptor valid again */
-	desc_p->status |= BIT(31);
-
-	/* Flush Status field of descriptor */
-	flush_dcache_range(desc_start, desc_end);
-
-	/* Move to next desc and wrap-around condition. */
-	if (++desc_num >= CONFIG_RX_DESCR_NUM)
-		desc_num = 0;
-	priv->rx_currdescnum = desc_num;
-
-	return 0;
+	/* The frame is handed to the stack in its DMA buffer, not copied */
+	return emac_rx_ring_recv(&priv->rx_ring, packetp);
 }
 
 static int sun8i_eth_free_pkt(struct udevice *dev, uchar *packet,
@@ -807,7 +656,7 @@ static int sun8i_eth_free_pkt(struct udevice *dev, uchar *packet,
 {
 	struct emac_eth_dev *priv = dev_get_priv(dev);
 
-	return _sun8i_free_pkt(priv);
+	return emac_rx_ring_free(&priv->rx_ring, packet, length);
 }
 
 static void sun8i_emac_eth_stop(struct udevice *dev)
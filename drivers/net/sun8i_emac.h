@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * DMA descriptor rings of the Allwinner sun8i EMAC
+ *
+ * These are kept apart from the driver so that the ring handling can be
+ * compiled and tested on sandbox.
+ */
+
+#ifndef _SUN8I_EMAC_H
+#define _SUN8I_EMAC_H
+
+#include <asm/cache.h>
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+#define SUN8I_EMAC_BUFSIZE	2048 /* Note must be dma aligned */
+
+/*
+ * The datasheet says that each descriptor can transfers up to 4096 bytes
+ * But later, the register documentation reduces that value to 2048,
+ * using 2048 cause strange behaviours and even BSP driver use 2047
+ */
+#define SUN8I_EMAC_RXSIZE	2044 /* Note must fit in SUN8I_EMAC_BUFSIZE */
+
+/* Fields of emac_dma_desc.status */
+#define EMAC_DESC_OWN_DMA	BIT(31)
+#define EMAC_DESC_RX_LEN_SHIFT	16
+#define EMAC_DESC_RX_LEN_MASK	0x3fff
+
+/* Fields of emac_dma_desc.st for transmit */
+#define EMAC_DESC_TX_INT	BIT(31)
+#define EMAC_DESC_TX_LAST	BIT(30)
+#define EMAC_DESC_TX_FIRST	BIT(29)
+#define EMAC_DESC_TX_CHAIN	BIT(24)	/* Mandatory undocumented bit */
+
+/* Frames shorter than this are runts, dropped by the receive path */
+#define EMAC_RX_MIN_LEN		0x40
+
+struct emac_dma_desc {
+	u32 status;
+	u32 st;
+	u32 buf_addr;
+	u32 next;
+} __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct emac_ring - A chain of DMA descriptors, linked into a ring
+ *
+ * Each descriptor owns a buffer of SUN8I_EMAC_BUFSIZE bytes.
+ *
+ * @desc:	Descriptors, @num of them
+ * @buf:	Buffers, @num * SUN8I_EMAC_BUFSIZE bytes
+ * @num:	Number of descriptors in the ring
+ * @cur:	Next descriptor to be used by the CPU
+ */
+struct emac_ring {
+	struct emac_dma_desc *desc;
+	char *buf;
+	int num;
+	int cur;
+};
+
+/**
+ * emac_rx_ring_init() - Hand all receive descriptors to the DMA engine
+ *
+ * @ring:	Ring to set up, with @desc, @buf and @num filled in
+ */
+void emac_rx_ring_init(struct emac_ring *ring);
+
+/**
+ * emac_rx_ring_recv() - Get the next frame received by the DMA engine
+ *
+ * The frame is not copied: @packetp points into the buffer of the
+ * descriptor, which stays with the CPU until emac_rx_ring_free() is called
+ * for it.
+ *
+ * @ring:	Receive ring
+ * @packetp:	Returns a pointer to the frame
+ * @return length of the frame, 0 if it is a runt which must be freed
+ *	without being processed, -EAGAIN if nothing was received or
+ *	-EMSGSIZE if the frame does not fit into the buffer
+ */
+int emac_rx_ring_recv(struct emac_ring *ring, uchar **packetp);
+
+/**
+ * emac_rx_ring_free() - Give a receive buffer back to the DMA engine
+ *
+ * @ring:	Receive ring
+ * @packet:	Frame returned by emac_rx_ring_recv()
+ * @length:	Length returned by emac_rx_ring_recv()
+ * @return 0 if OK, -EINVAL if @packet is not the frame at the head of the
+ *	ring
+ */
+int emac_rx_ring_free(struct emac_ring *ring, uchar *packet, int length);
+
+/**
+ * emac_tx_ring_init() - Set up an empty transmit ring
+ *
+ * @ring:	Ring to set up, with @desc, @buf and @num filled in
+ */
+void emac_tx_ring_init(struct emac_ring *ring);
+
+/**
+ * emac_tx_ring_send() - Queue a frame for transmission
+ *
+ * The frame is copied into the buffer of the next descriptor, which is then
+ * handed to the DMA engine. The caller must (re)start transmit DMA.
+ *
+ * @ring:	Transmit ring
+ * @packet:	Frame to send
+ * @len:	Length of the frame in bytes
+ * @return 0 if OK, -EMSGSIZE if the frame does not fit into a buffer
+ */
+int emac_tx_ring_send(struct emac_ring *ring, const void *packet, int len);
+
+#endif /* _SUN8I_EMAC_H */
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * DMA descriptor rings of the Allwinner sun8i EMAC
+ *
+ * Received frames are passed up in place: the buffer of a descriptor is only
+ * given back to the DMA engine when the network stack is done with it.
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <errno.h>
+#include <log.h>
+#include <linux/kernel.h>
+#include "sun8i_emac.h"
+
+static void emac_ring_link(struct emac_ring *ring)
+{
+	struct emac_dma_desc *desc_p;
+	int idx;
+
+	for (idx = 0; idx < ring->num; idx++) {
+		desc_p = &ring->desc[idx];
+		desc_p->buf_addr = (uintptr_t)&ring->buf[idx *
+							 SUN8I_EMAC_BUFSIZE];
+		desc_p->next = (uintptr_t)&ring->desc[(idx + 1) % ring->num];
+	}
+	ring->cur = 0;
+}
+
+static void emac_desc_flush(struct emac_dma_desc *desc_p)
+{
+	flush_dcache_range((uintptr_t)desc_p, (uintptr_t)(desc_p + 1));
+}
+
+void emac_rx_ring_init(struct emac_ring *ring)
+{
+	struct emac_dma_desc *desc_p;
+	int idx;
+
+	/* flush Rx buffers */
+	flush_dcache_range((uintptr_t)ring->buf, (uintptr_t)ring->buf +
+			   ring->num * SUN8I_EMAC_BUFSIZE);
+
+	emac_ring_link(ring);
+	for (idx = 0; idx < ring->num; idx++) {
+		desc_p = &ring->desc[idx];
+		desc_p->st = SUN8I_EMAC_RXSIZE;
+		desc_p->status = EMAC_DESC_OWN_DMA;
+	}
+
+	flush_dcache_range((uintptr_t)ring->desc,
+			   (uintptr_t)&ring->desc[ring->num]);
+}
+
+/* Hand the descriptor at the head of the ring back and move on */
+static void emac_rx_ring_next(struct emac_ring *ring)
+{
+	struct emac_dma_desc *desc_p = &ring->desc[ring->cur];
+
+	desc_p->status = EMAC_DESC_OWN_DMA;
+	emac_desc_flush(desc_p);
+
+	if (++ring->cur >= ring->num)
+		ring->cur = 0;
+}
+
+int emac_rx_ring_recv(struct emac_ring *ring, uchar **packetp)
+{
+	struct emac_dma_desc *desc_p = &ring->desc[ring->cur];
+	char *data = &ring->buf[ring->cur * SUN8I_EMAC_BUFSIZE];
+	u32 status;
+	int length;
+
+	/* Invalidate entire buffer descriptor */
+	invalidate_dcache_range((uintptr_t)desc_p, (uintptr_t)(desc_p + 1));
+
+	status = desc_p->status;
+	if (status & EMAC_DESC_OWN_DMA)
+		return -EAGAIN;
+
+	length = (status >> EMAC_DESC_RX_LEN_SHIFT) & EMAC_DESC_RX_LEN_MASK;
+	if (length > SUN8I_EMAC_RXSIZE) {
+		printf("Received packet is too big (len=%d)\n", length);
+		emac_rx_ring_next(ring);
+		return -EMSGSIZE;
+	}
+
+	*packetp = (uchar *)data;
+	if (length < EMAC_RX_MIN_LEN) {
+		debug("RX: Bad Packet (runt)\n");
+		return 0;
+	}
+
+	/* Invalidate received data */
+	invalidate_dcache_range((uintptr_t)data,
+				(uintptr_t)data + roundup(length,
+							  ARCH_DMA_MINALIGN));
+
+	return length;
+}
+
+int emac_rx_ring_free(struct emac_ring *ring, uchar *packet, int length)
+{
+	char *data = &ring->buf[ring->cur * SUN8I_EMAC_BUFSIZE];
+
+	if ((char *)packet != data)
+		return -EINVAL;
+
+	/*
+	 * The stack may have written to the frame (e.g. to turn a ping
+	 * request into its reply), so make sure that no dirty line is left
+	 * to be evicted over the next frame received into this buffer.
+	 */
+	if (length > 0)
+		flush_dcache_range((uintptr_t)data, (uintptr_t)data +
+				   roundup(length, ARCH_DMA_MINALIGN));
+
+	emac_rx_ring_next(ring);
+
+	return 0;
+}
+
+void emac_tx_ring_init(struct emac_ring *ring)
+{
+	struct emac_dma_desc *desc_p;
+	int idx;
+
+	emac_ring_link(ring);
+	for (idx = 0; idx < ring->num; idx++) {
+		desc_p = &ring->desc[idx];
+		desc_p->status = EMAC_DESC_OWN_DMA;
+		desc_p->st = 0;
+	}
+
+	/* Flush all Tx buffer descriptors */
+	flush_dcache_range((uintptr_t)ring->desc,
+			   (uintptr_t)&ring->desc[ring->num]);
+}
+
+int emac_tx_ring_send(struct emac_ring *ring, const void *packet, int len)
+{
+	struct emac_dma_desc *desc_p = &ring->desc[ring->cur];
+	char *data = &ring->buf[ring->cur * SUN8I_EMAC_BUFSIZE];
+
+	if (len > SUN8I_EMAC_BUFSIZE)
+		return -EMSGSIZE;
+
+	/* Invalidate entire buffer descriptor */
+	invalidate_dcache_range((uintptr_t)desc_p, (uintptr_t)(desc_p + 1));
+
+	memcpy(data, packet, len);
+
+	/* Flush data to be sent */
+	flush_dcache_range((uintptr_t)data,
+			   (uintptr_t)data + roundup(len, ARCH_DMA_MINALIGN));
+
+	desc_p->st = len | EMAC_DESC_TX_CHAIN | EMAC_DESC_TX_INT |
+		     EMAC_DESC_TX_LAST | EMAC_DESC_TX_FIRST;
+	desc_p->status = EMAC_DESC_OWN_DMA;
+
+	/* Descriptors st and status field has changed, so FLUSH it */
+	emac_desc_flush(desc_p);
+
+	/* Move to next Descriptor and wrap around */
+	if (++ring->cur >= ring->num)
+		ring->cur = 0;
+
+	return 0;
+}
@@ -15,10 +15,12 @@
 #include <log.h>
 #include <malloc.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <os.h>
 
 #include <linux/errno.h>
+#include <linux/sizes.h>
 #include <asm/spi.h>
 #include <asm/state.h>
 #include <dm/device-internal.h>
@@ -133,12 +135,61 @@ static int sandbox_spi_get_mmap(struct udevice *dev, ulong *map_basep,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+/* Size of the window through which the flash appears to be mapped */
+#define SANDBOX_SPI_DIRMAP_WINDOW	SZ_64K
+
+static int sandbox_spi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	/* Only reads are mapped, writes go through spi_mem_exec_op() */
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -ENOTSUPP;
+
+	return 0;
+}
+
+/*
+ * Behave like a controller with a memory-mapped window of the flash: a read
+ * stops at the end of the window, so callers must cope with short reads
+ */
+static ssize_t sandbox_spi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				       u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	u64 end;
+	int ret;
+
+	if (offs >= desc->info.length)
+		return -EINVAL;
+	end = (offs & ~(u64)(SANDBOX_SPI_DIRMAP_WINDOW - 1)) +
+		SANDBOX_SPI_DIRMAP_WINDOW;
+	end = min(end, desc->info.length);
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.nbytes = min_t(u64, len, end - offs);
+	op.data.buf.in = buf;
+	ret = spi_mem_exec_op(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	return op.data.nbytes;
+}
+
+static const struct spi_controller_mem_ops sandbox_spi_mem_ops = {
+	.dirmap_create	= sandbox_spi_dirmap_create,
+	.dirmap_read	= sandbox_spi_dirmap_read,
+};
+#endif
+
 static const struct dm_spi_ops sandbox_spi_ops = {
 	.xfer		= sandbox_spi_xfer,
 	.set_speed	= sandbox_spi_set_speed,
 	.set_mode	= sandbox_spi_set_mode,
 	.cs_info	= sandbox_cs_info,
 	.get_mmap	= sandbox_spi_get_mmap,
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	.mem_ops	= &sandbox_spi_mem_ops,
+#endif
 };
 
 static const struct udevice_id sandbox_spi_ids[] = {
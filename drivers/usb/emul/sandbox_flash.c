@@ -10,6 +10,7 @@
 #include <os.h>
 #include <scsi.h>
 #include <usb.h>
+#include <asm/test.h>
 
 /*
  * This driver emulates a flash stick using the UFI command specification and
@@ -49,6 +50,8 @@ enum {
  * @file_size:	Size of file in bytes
  * @status_buff:	Data buffer for outgoing status
  * @buff_used:	Number of bytes ready to transfer back to host
+ * @max_xfer_blk: Largest number of blocks in one read command, 0 for no limit
+ * @sense_key:	Sense key to report for the last failed command
  * @buff:	Data buffer for outgoing data
  */
 struct sandbox_flash_priv {
@@ -62,6 +65,8 @@ struct sandbox_flash_priv {
 	loff_t file_size;
 	struct umass_bbb_csw status;
 	int buff_used;
+	int max_xfer_blk;
+	u8 sense_key;
 	u8 buff[512];
 };
 
@@ -87,6 +92,19 @@ struct scsi_read_capacity_resp {
 	u32 block_len;
 };
 
+struct scsi_request_sense_resp {
+	u8 error_code;
+	u8 segment;
+	u8 sense_key;
+	u8 info[4];
+	u8 additional_len;
+	u8 cmd_info[4];
+	u8 asc;
+	u8 ascq;
+	u8 fru;
+	u8 sks[3];
+};
+
 struct __packed scsi_read10_req {
 	u8 cmd;
 	u8 lun_flags;
@@ -228,7 +246,11 @@ static void handle_read(struct sandbox_flash_priv *priv, ulong lba,
 			ulong transfer_len)
 {
 	debug("%s: lba=%lx, transfer_len=%lx\n", __func__, lba, transfer_len);
-	if (priv->fd != -1) {
+	if (priv->max_xfer_blk && transfer_len > priv->max_xfer_blk) {
+		/* Like devices which cannot cope with large transfers */
+		priv->sense_key = SENSE_ILLEGAL_REQUEST;
+		setup_fail_response(priv);
+	} else if (priv->fd != -1) {
 		os_lseek(priv->fd, lba * SANDBOX_FLASH_BLOCK_LEN, OS_SEEK_SET);
 		priv->read_len = transfer_len;
 		setup_response(priv, priv->buff,
@@ -265,6 +287,18 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 	case SCSI_TST_U_RDY:
 		setup_response(priv, NULL, 0);
 		break;
+	case SCSI_REQ_SENSE: {
+		struct scsi_request_sense_resp *resp = (void *)priv->buff;
+
+		priv->alloc_len = req->cmd[4];
+		memset(resp, '\0', sizeof(*resp));
+		resp->error_code = 0x70;
+		resp->sense_key = priv->sense_key;
+		resp->additional_len = sizeof(*resp) - 8;
+		priv->sense_key = 0;
+		setup_response(priv, resp, sizeof(*resp));
+		break;
+	}
 	case SCSI_RD_CAPAC: {
 		struct scsi_read_capacity_resp *resp = (void *)priv->buff;
 		uint blocks;
@@ -345,6 +379,8 @@ static int sandbox_flash_bulk(struct udevice *dev, struct usb_device *udev,
 			} else {
 				if (priv->alloc_len && len > priv->alloc_len)
 					len = priv->alloc_len;
+				if (len > priv->buff_used)
+					len = priv->buff_used;
 				memcpy(buff, priv->buff, len);
 				priv->phase = PHASE_STATUS;
 			}
@@ -366,6 +402,13 @@ err:
 	return 0;
 }
 
+void sandbox_flash_set_max_xfer_blk(struct udevice *dev, int blocks)
+{
+	struct sandbox_flash_priv *priv = dev_get_priv(dev);
+
+	priv->max_xfer_blk = blocks;
+}
+
 static int sandbox_flash_ofdata_to_platdata(struct udevice *dev)
 {
 	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
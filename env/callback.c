@@ -7,6 +7,7 @@
 #include <common.h>
 #include <env.h>
 #include <env_internal.h>
+#include <linux/ctype.h>
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 DECLARE_GLOBAL_DATA_PTR;
@@ -78,6 +79,62 @@ void env_callback_init(struct env_entry *var_entry)
 	}
 }
 
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+/*
+ * Look up a variable bound to a callback. For a regular expression, look up
+ * all variables which start with its literal part instead.
+ */
+static int load_callback_var(const char *name, const char *value, void *priv)
+{
+	struct env_entry e, *ep;
+	char key[256];
+	bool pattern;
+	int i, n;
+
+	pattern = IS_ENABLED(CONFIG_REGEX) && strchr(name, '|');
+	for (i = 0, n = 0; !pattern && name[i] && n < sizeof(key) - 1; i++) {
+		char c = name[i];
+
+		if (IS_ENABLED(CONFIG_REGEX)) {
+			if (c == '\\' && name[i + 1] && !isalnum(name[i + 1])) {
+				c = name[++i];
+			} else if (strchr("\\.^$[]()*+?{", c)) {
+				/* These may match the character before 0 times */
+				if (n && strchr("*?{", c))
+					n--;
+				pattern = true;
+				break;
+			}
+		}
+		key[n++] = c;
+	}
+	if (name[i])
+		pattern = true;
+	key[n] = '\0';
+
+	if (pattern) {
+		hmatch_r(key, 0, &ep, &env_htab);
+	} else {
+		e.key = key;
+		e.data = NULL;
+		hsearch_r(e, ENV_FIND, &ep, &env_htab, 0);
+	}
+
+	return 0;
+}
+
+/*
+ * The variables of an indexed environment are entered as they are looked up,
+ * so look up those bound to a callback, for it to be called on import as
+ * usual.
+ */
+void env_callback_load(void)
+{
+	env_attr_walk(ENV_CALLBACK_LIST_STATIC, load_callback_var, NULL);
+	env_attr_walk(env_get(ENV_CALLBACK_VAR), load_callback_var, NULL);
+}
+#endif
+
 /*
  * Called on each existing env var prior to the blanket update since removing
  * a callback association should remove its callback.
@@ -124,6 +124,13 @@ int env_import(const char *buf, int check)
 		}
 	}
 
+	if (CONFIG_IS_ENABLED(ENV_INDEX) &&
+	    himport_index_r(&env_htab, (char *)ep->data, ENV_SIZE, 0)) {
+		gd->flags |= GD_FLG_ENV_READY;
+		env_callback_load();
+		return 0;
+	}
+
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
@@ -216,6 +223,10 @@ int env_export(env_t *env_out)
 		return 1;
 	}
 
+	if (CONFIG_IS_ENABLED(ENV_INDEX) &&
+	    hexport_index((char *)env_out->data, ENV_SIZE))
+		debug("No room to index the environment\n");
+
 	env_out->crc = crc32(0, env_out->data, ENV_SIZE);
 
 #ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
@@ -1525,14 +1525,21 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
+/*
+ * Walk down the extent tree to the leaf covering 'fileblock'. Index and leaf
+ * blocks are read through 'cache', which has one entry for each of the first
+ * 'levels' levels of the tree; deeper levels share the last entry.
+ */
 static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, struct ext_block_cache *cache,
+	(struct ext2_data *data, struct ext_block_cache *cache, int levels,
 		struct ext4_extent_header *ext_block,
 		uint32_t fileblock, int log2_blksz)
 {
 	struct ext4_extent_idx *index;
+	struct ext_block_cache *c;
 	unsigned long long block;
 	int blksz = EXT2_BLOCK_SIZE(data);
+	int level = 0;
 	int i;
 
 	while (1) {
@@ -1560,9 +1567,11 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 		block <<= log2_blksz;
-		if (!ext_cache_read(cache, (lbaint_t)block, blksz))
+		c = &cache[min(level, levels - 1)];
+		level++;
+		if (!ext_cache_read(c, (lbaint_t)block, blksz))
 			return NULL;
-		ext_block = (struct ext4_extent_header *)cache->buf;
+		ext_block = (struct ext4_extent_header *)c->buf;
 	}
 }
 
@@ -1672,7 +1681,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			ext_cache_init(c);
 		}
 		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
+			ext4fs_get_extent_block(ext4fs_root, c, 1,
 						(struct ext4_extent_header *)
 						inode->b.blocks.dir_blocks,
 						fileblock, log2_blksz);
@@ -1995,6 +2004,87 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	return blknr;
 }
 
+long int ext4fs_map_blocks(struct ext2_inode *inode, int fileblock,
+			   int maxblocks, struct ext_block_cache *cache,
+			   int *count)
+{
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+		get_fs()->dev_desc->log2blksz;
+	long int blknr, next;
+	int n;
+
+	*count = 1;
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
+		struct ext4_extent_header *ext_block;
+		struct ext4_extent *extent;
+		long int startblock, endblock;
+		unsigned long long start;
+		int i, entries;
+
+		ext_block =
+			ext4fs_get_extent_block(ext4fs_root, cache,
+						EXT_CACHE_LEVELS,
+						(struct ext4_extent_header *)
+						inode->b.blocks.dir_blocks,
+						fileblock, log2_blksz);
+		if (!ext_block) {
+			printf("invalid extent block\n");
+			return -EINVAL;
+		}
+
+		extent = (struct ext4_extent *)(ext_block + 1);
+		entries = le16_to_cpu(ext_block->eh_entries);
+
+		for (i = 0; i < entries; i++) {
+			startblock = le32_to_cpu(extent[i].ee_block);
+			endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+			if (startblock > fileblock) {
+				/* Sparse file, up to the start of the extent */
+				*count = min((long int)maxblocks,
+					     startblock - fileblock);
+				return 0;
+			} else if (fileblock < endblock) {
+				break;
+			}
+		}
+		if (i == entries)
+			return 0;
+
+		start = le16_to_cpu(extent[i].ee_start_hi);
+		start = (start << 32) + le32_to_cpu(extent[i].ee_start_lo);
+		blknr = (fileblock - startblock) + start;
+		n = endblock - fileblock;
+
+		/* Take in the following extents while they are contiguous */
+		while (n < maxblocks && ++i < entries) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			if (le32_to_cpu(extent[i].ee_block) != fileblock + n ||
+			    start != blknr + n)
+				break;
+			n += le16_to_cpu(extent[i].ee_len);
+		}
+		*count = min(n, maxblocks);
+
+		return blknr;
+	}
+
+	/* Block mapped files: look up blocks until the run is broken */
+	blknr = read_allocated_block(inode, fileblock, NULL);
+	if (blknr < 0)
+		return blknr;
+	for (n = 1; n < maxblocks; n++) {
+		next = read_allocated_block(inode, fileblock + n, NULL);
+		if (next < 0 || next != (blknr ? blknr + n : 0))
+			break;
+	}
+	*count = n;
+
+	return blknr;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -20,6 +20,7 @@
 #include <malloc.h>
 #include <memalign.h>
 #include <asm/cache.h>
+#include <asm/unaligned.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 
@@ -58,6 +59,116 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/*
+ * FAT sector cache
+ *
+ * Every file system operation sets up its own fsdata, so the FAT buffer in
+ * it starts out empty each time. The FAT windows read most recently are
+ * kept here, per volume, so that consecutive reads from the same volume do
+ * not have to go back to the disk for the same FAT sectors. Writes to the
+ * FAT go through flush_dirty_fat_buffer(), which updates the cache. Any other
+ * write to the device, e.g. with 'mmc write', drops the cache.
+ */
+#define FAT_CACHE_WINDOWS	CONFIG_FS_FAT_CACHE_WINDOWS
+
+#if FAT_CACHE_WINDOWS > 0
+static struct {
+	struct blk_desc *dev;
+	lbaint_t part_start;
+	u32 volume_id;
+	__u16 sect_size;
+	ulong write_count;
+	ulong tick;
+	struct {
+		int bufnum;
+		ulong used;
+		__u8 *buf;
+	} win[FAT_CACHE_WINDOWS];
+} fat_cache;
+
+/* Drop the cached windows unless they belong to the volume being used */
+static void fat_cache_attach(fsdata *mydata, u32 volume_id)
+{
+	int i;
+
+	if (fat_cache.dev == cur_dev &&
+	    fat_cache.write_count == cur_dev->write_count &&
+	    fat_cache.part_start == cur_part_info.start &&
+	    fat_cache.volume_id == volume_id &&
+	    fat_cache.sect_size == mydata->sect_size)
+		return;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		fat_cache.win[i].bufnum = -1;
+		if (fat_cache.sect_size != mydata->sect_size) {
+			free(fat_cache.win[i].buf);
+			fat_cache.win[i].buf = NULL;
+		}
+	}
+	fat_cache.dev = cur_dev;
+	fat_cache.write_count = cur_dev->write_count;
+	fat_cache.part_start = cur_part_info.start;
+	fat_cache.volume_id = volume_id;
+	fat_cache.sect_size = mydata->sect_size;
+}
+
+/* Copy FAT window 'bufnum' into fatbuf if it is cached; return 0 if so */
+static int fat_cache_get(fsdata *mydata, __u32 bufnum)
+{
+	int i;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		if (fat_cache.win[i].bufnum == bufnum) {
+			memcpy(mydata->fatbuf, fat_cache.win[i].buf,
+			       FATBUFSIZE);
+			fat_cache.win[i].used = ++fat_cache.tick;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/* Store the current contents of fatbuf in the cache */
+static void fat_cache_put(fsdata *mydata)
+{
+	int i, slot = 0;
+
+	for (i = 0; i < FAT_CACHE_WINDOWS; i++) {
+		if (fat_cache.win[i].bufnum == mydata->fatbufnum) {
+			slot = i;
+			break;
+		}
+		if (fat_cache.win[i].used < fat_cache.win[slot].used)
+			slot = i;
+	}
+
+	if (!fat_cache.win[slot].buf) {
+		fat_cache.win[slot].buf = malloc(FATBUFSIZE);
+		if (!fat_cache.win[slot].buf)
+			return;
+	}
+	memcpy(fat_cache.win[slot].buf, mydata->fatbuf, FATBUFSIZE);
+	fat_cache.win[slot].bufnum = mydata->fatbufnum;
+	fat_cache.win[slot].used = ++fat_cache.tick;
+}
+
+/* Writes made by this driver keep the cache up to date */
+static __maybe_unused void fat_cache_written(void)
+{
+	if (fat_cache.dev == cur_dev)
+		fat_cache.write_count = cur_dev->write_count;
+}
+#else
+static inline void fat_cache_attach(fsdata *mydata, u32 volume_id) {}
+static inline int fat_cache_get(fsdata *mydata, __u32 bufnum)
+{
+	return -ENOENT;
+}
+static inline void fat_cache_put(fsdata *mydata) {}
+static inline void fat_cache_written(void) {}
+#endif
+
 int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
@@ -211,11 +322,15 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 		if (flush_dirty_fat_buffer(mydata) < 0)
 			return -1;
 
-		if (disk_read(startblock, getsize, bufptr) < 0) {
+		if (!fat_cache_get(mydata, bufnum)) {
+			mydata->fatbufnum = bufnum;
+		} else if (disk_read(startblock, getsize, bufptr) < 0) {
 			debug("Error reading FAT blocks\n");
 			return ret;
+		} else {
+			mydata->fatbufnum = bufnum;
+			fat_cache_put(mydata);
 		}
-		mydata->fatbufnum = bufnum;
 	}
 
 	/* Get the actual entry from the table */
@@ -303,6 +418,22 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Move 'clust' on to the next cluster in its chain. Return 0, or -1 if the
+ * FAT entry is not valid.
+ */
+static int follow_chain(fsdata *mydata, __u32 *clust)
+{
+	*clust = get_fatent(mydata, *clust);
+	if (CHECK_CLUST(*clust, mydata->fatsize)) {
+		debug("curclust: 0x%x\n", *clust);
+		printf("Invalid FAT entry\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -310,6 +441,9 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
  * into 'buffer'. Update the number of bytes read in *gotsize or return -1 on
  * fatal errors.
  *
+ * The cluster chain is walked once. Each run of consecutive clusters is read
+ * with a single disk access as soon as its end has been found.
+ *
  * @mydata:	file system description
  * @dentprt:	directory entry pointer
  * @pos:	position from where to read
@@ -323,8 +457,8 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	__u32 clust = START(dentptr);
+	__u32 start, count;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -340,24 +474,20 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
+	if (CHECK_CLUST(clust, mydata->fatsize)) {
+		debug("curclust: 0x%x\n", clust);
+		printf("Invalid FAT entry\n");
+		return -1;
+	}
 
 	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
+	while (pos >= bytesperclust) {
+		if (follow_chain(mydata, &clust))
 			return -1;
-		}
-		actsize += bytesperclust;
+		filesize -= bytesperclust;
+		pos -= bytesperclust;
 	}
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
 	/* align to beginning of next cluster if any */
 	if (pos) {
 		__u8 *tmp_buffer;
@@ -369,7 +499,7 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 			return -1;
 		}
 
-		if (get_cluster(mydata, curclust, tmp_buffer, actsize) != 0) {
+		if (get_cluster(mydata, clust, tmp_buffer, actsize)) {
 			printf("Error reading cluster\n");
 			free(tmp_buffer);
 			return -1;
@@ -383,58 +513,33 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 			return 0;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
+		if (follow_chain(mydata, &clust))
 			return -1;
-		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
+	while (filesize) {
 		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				printf("Invalid FAT entry\n");
+		start = clust;
+		count = 1;
+		while ((loff_t)count * bytesperclust < filesize) {
+			if (follow_chain(mydata, &clust))
 				return -1;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
+			if (clust != start + count)
+				break;
+			count++;
 		}
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		actsize = min(filesize, (loff_t)count * bytesperclust);
+		if (get_cluster(mydata, start, buffer, actsize)) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
+	}
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	return 0;
 }
 
 /*
@@ -631,6 +736,8 @@ static int get_fs_info(fsdata *mydata)
 		return -1;
 	}
 
+	fat_cache_attach(mydata, get_unaligned_le32(volinfo.volume_id));
+
 	debug("FAT%d, fat_sect: %d, fatlength: %d\n",
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
 	debug("Rootdir begins at cluster: %d, sector: %d, offset: %x\n"
@@ -44,6 +44,7 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 	}
 
 	ret = blk_dwrite(cur_dev, cur_part_info.start + block, nr_blocks, buf);
+	fat_cache_written();
 	if (nr_blocks && ret == 0)
 		return -1;
 
@@ -139,6 +140,7 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 		}
 	}
 	mydata->fat_dirty = 0;
+	fat_cache_put(mydata);
 
 	return 0;
 }
@@ -303,11 +305,15 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 
 		startblock += mydata->fat_sect;
 
-		if (disk_read(startblock, getsize, bufptr) < 0) {
+		if (!fat_cache_get(mydata, bufnum)) {
+			mydata->fatbufnum = bufnum;
+		} else if (disk_read(startblock, getsize, bufptr) < 0) {
 			debug("Error reading FAT blocks\n");
 			return -1;
+		} else {
+			mydata->fatbufnum = bufnum;
+			fat_cache_put(mydata);
 		}
-		mydata->fatbufnum = bufnum;
 	}
 
 	/* Mark as dirty */
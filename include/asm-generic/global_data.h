@@ -78,6 +78,9 @@ typedef struct global_data {
 #ifdef CONFIG_OF_LIVE
 	struct device_node *of_root;
 #endif
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	struct fdtdec_index *fdt_index;	/* Index of fdt_blob, if built */
+#endif
 
 #if CONFIG_IS_ENABLED(MULTI_DTB_FIT)
 	const void *multi_dtb_fit;	/* uncompressed multi-dtb FIT image */
@@ -8,6 +8,7 @@
 #define BLK_H
 
 #include <efi.h>
+#include <linux/list.h>
 
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
@@ -85,6 +86,11 @@ struct blk_desc {
 		uint32_t mbr_sig;	/* MBR integer signature */
 		efi_guid_t guid_sig;	/* GPT GUID Signature */
 	};
+	/*
+	 * Count of write and erase operations, so that data cached above the
+	 * block layer, e.g. by a filesystem, can be dropped when it changes
+	 */
+	unsigned long	write_count;
 #if CONFIG_IS_ENABLED(BLK)
 	/*
 	 * For now we have a few functions which take struct blk_desc as a
@@ -151,6 +157,24 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_read_ahead() - read ahead of a sequential read that missed
+ *
+ * If a read continues the previous one on the same device and is smaller
+ * than the read-ahead window, a whole window is read from the device into
+ * the cache and the requested blocks are copied out of it.
+ *
+ * @param block_dev - block device to read from
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to read
+ * @param buf - buffer to contain the data
+ *
+ * @return - 1 if the data was read into the buffer, 0 if the caller should
+ * read it from the device itself.
+ */
+int blkcache_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer);
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
@@ -160,13 +184,29 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_invalidate_range() - discard cached data overlapping a range of
+ * blocks because it is about to be written or erased
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - first block being changed
+ * @param blkcnt - number of blocks being changed
+ */
+void blkcache_invalidate_range(int iftype, int dev, lbaint_t start,
+			       lbaint_t blkcnt);
+
 /**
  * blkcache_configure() - configure block cache
  *
+ * Values larger than 256 blocks are clamped to 256.
+ *
  * @param blocks - maximum blocks per entry
  * @param entries - maximum entries in cache
+ * @param readahead - blocks to read ahead for sequential reads, 0 to disable
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned entries,
+			unsigned readahead);
 
 /*
  * statistics of the block cache
@@ -174,9 +214,11 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned readaheads; /* misses satisfied by reading ahead */
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned max_readahead;
 };
 
 /**
@@ -199,13 +241,50 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline int blkcache_read_ahead(struct blk_desc *block_dev,
+				      lbaint_t start, lbaint_t blkcnt,
+				      void *buffer)
+{
+	return 0;
+}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
+static inline void blkcache_invalidate_range(int iftype, int dev,
+					     lbaint_t start, lbaint_t blkcnt) {}
+
 #endif
 
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/**
+ * struct blk_req - an asynchronous block transfer
+ *
+ * The caller fills in @start, @blkcnt, @buffer and @write and passes the
+ * request to blk_submit(). After that it must leave the request and the
+ * buffer alone until blk_poll() or blk_wait() reports that it has finished.
+ *
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks
+ * @buffer:	Buffer to read into or write from
+ * @write:	true to write, false to read
+ * @result:	Number of blocks transferred, or -ve error number, once done
+ * @done:	true once the request has finished
+ * @node:	Entry in the device's list of requests in progress
+ * @priv:	Driver data, while the request is in progress
+ */
+struct blk_req {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	bool write;
+	long result;
+	bool done;
+	struct list_head node;
+	void *priv;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -264,6 +343,32 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit() - start an asynchronous transfer
+	 *
+	 * This starts the transfer and returns without waiting for it. The
+	 * uclass calls poll() to find out when it has finished.
+	 *
+	 * @dev:	Device to use
+	 * @req:	Request to start
+	 * @return 0 if started, -EBUSY if the device cannot start another
+	 * transfer until an earlier one finishes, -ENOSYS if this request
+	 * must be done with read() or write() instead, other -ve on error
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - check whether an asynchronous transfer has finished
+	 *
+	 * @dev:	Device to use
+	 * @req:	Request started by submit()
+	 * @return 0 if finished, with req->result set, -EBUSY if it is
+	 * still in progress
+	 */
+	int (*poll)(struct udevice *dev, struct blk_req *req);
+#endif
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -281,6 +386,67 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * blk_submit() - start an asynchronous transfer
+ *
+ * Up to CONFIG_BLK_ASYNC_DEPTH requests can be in progress on a device. If
+ * there are that many already, this waits for the oldest one first. If the
+ * driver cannot transfer the data asynchronously, this does it before
+ * returning, so the request is already finished.
+ *
+ * If a request in progress overlaps this one and either of them is a write,
+ * this waits for that request first. So requests for the same blocks finish
+ * in the order in which they were submitted.
+ *
+ * @block_dev:	Block device to use
+ * @req:	Request to start, see struct blk_req
+ * @return 0 if OK (the request is in progress or finished), -ve on error
+ */
+int blk_submit(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_poll() - check whether an asynchronous transfer has finished
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request passed to blk_submit()
+ * @return 0 if finished, with req->result set, -EBUSY if still in progress
+ */
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_wait() - wait for an asynchronous transfer to finish
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request passed to blk_submit()
+ * @return number of blocks transferred, or -ve error number
+ */
+long blk_wait(struct blk_desc *block_dev, struct blk_req *req);
+#else
+static inline int blk_submit(struct blk_desc *block_dev, struct blk_req *req)
+{
+	if (req->write)
+		req->result = blk_dwrite(block_dev, req->start, req->blkcnt,
+					 req->buffer);
+	else
+		req->result = blk_dread(block_dev, req->start, req->blkcnt,
+					req->buffer);
+	req->done = true;
+
+	return 0;
+}
+
+static inline int blk_poll(struct blk_desc *block_dev, struct blk_req *req)
+{
+	return 0;
+}
+
+static inline long blk_wait(struct blk_desc *block_dev, struct blk_req *req)
+{
+	return req->result;
+}
+#endif
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -438,6 +604,8 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+	if (blkcache_read_ahead(block_dev, start, blkcnt, buffer))
+		return blkcnt;
 
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
@@ -455,14 +623,18 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	block_dev->write_count++;
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
 static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	block_dev->write_count++;
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  start, blkcnt);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
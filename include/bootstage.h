@@ -234,6 +234,63 @@ void show_boot_progress(int val);
 #if CONFIG_IS_ENABLED(BOOTSTAGE)
 #define ENABLE_BOOTSTAGE
 #endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+#define ENABLE_BOOTSTAGE_TIMELINE
+#endif
+#endif
+
+/* Kinds of activity in the bootstage timeline */
+enum bootstage_span_cat {
+	BOOTSTAGE_SPAN_PROBE,		/* Probing a device */
+	BOOTSTAGE_SPAN_BLK_READ,	/* Reading from a block device */
+	BOOTSTAGE_SPAN_BLK_WRITE,	/* Writing to a block device */
+	BOOTSTAGE_SPAN_NET,		/* Network operation, e.g. TFTP */
+
+	BOOTSTAGE_SPAN_COUNT,
+};
+
+#ifdef ENABLE_BOOTSTAGE_TIMELINE
+/**
+ * bootstage_span_start() - Get the start time of a timeline event
+ *
+ * @return time in microseconds, to pass to bootstage_span()
+ */
+ulong bootstage_span_start(void);
+
+/**
+ * bootstage_span() - Add an event to the timeline
+ *
+ * Events are dropped before relocation and once the timeline is full.
+ *
+ * @cat:	Kind of event
+ * @name:	Name of the event, e.g. the device, which is copied
+ * @start_us:	Start time of the event, from bootstage_span_start()
+ * @bytes:	Number of bytes transferred, or 0 if none
+ */
+void bootstage_span(enum bootstage_span_cat cat, const char *name,
+		    ulong start_us, ulong bytes);
+
+/**
+ * bootstage_export() - Write the boot timeline in Chrome trace-event format
+ *
+ * This covers the boot stages, accumulated times and the events of the
+ * timeline, as JSON.
+ *
+ * @buf:	Buffer to write to
+ * @size:	Size of buffer
+ * @return number of bytes written, or -ENOSPC if @buf is too small
+ */
+int bootstage_export(char *buf, int size);
+#else
+static inline ulong bootstage_span_start(void)
+{
+	return 0;
+}
+
+static inline void bootstage_span(enum bootstage_span_cat cat,
+				  const char *name, ulong start_us, ulong bytes)
+{
+}
 #endif
 
 #ifdef ENABLE_BOOTSTAGE
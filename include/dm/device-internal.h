@@ -110,6 +110,42 @@ int device_ofdata_to_platdata(struct udevice *dev);
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_start() - Start probing a device
+ *
+ * This is like device_probe(), except that it does not wait for a probe
+ * which the driver finishes in the background, see dev_probe_defer().
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK, -EINPROGRESS if the probe is going on in the background
+ *	(call device_probe_poll() to finish it), other -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
+/**
+ * device_probe_poll() - Check on a probe going on in the background
+ *
+ * @dev: Pointer to device being probed
+ * @return 0 if the device is ready, -EINPROGRESS if it is still being probed,
+ *	-ENODEV if it is not being probed, other -ve if the probe failed
+ */
+int device_probe_poll(struct udevice *dev);
+
+/**
+ * device_probe_all() - Probe several devices, interleaving slow probes
+ *
+ * Devices which defer the end of their probe are polled while the others are
+ * probed, so that their waits overlap. A device is only started once all
+ * its parents are ready. Suppliers found by a probe() method, e.g. through a
+ * phandle, are waited for, as device_probe() does.
+ *
+ * @devs: Devices to probe
+ * @count: Number of devices in @devs
+ * @return 0 if all devices were probed, else the error of the first device
+ *	which failed
+ */
+int device_probe_all(struct udevice *const devs[], int count);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -73,6 +73,12 @@ struct driver_info;
  */
 #define DM_FLAG_REMOVE_WITH_PD_ON	(1 << 13)
 
+/*
+ * Device is still being probed in the background, by the probe_poll() method
+ * of its driver. DM_FLAG_ACTIVATED is only set once that has finished.
+ */
+#define DM_FLAG_PROBE_PENDING		(1 << 14)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -228,6 +234,9 @@ struct udevice_id {
  * @child_post_bind: Called after a new child has been bound
  * @child_pre_probe: Called before a child device is probed. The device has
  * memory allocated but it has not yet been probed.
+ * @probe_poll: Called to finish probing a device after the probe() method
+ * returned -EINPROGRESS, see dev_probe_defer(). Returns -EINPROGRESS until
+ * the device is ready, then 0 or another -ve error like probe() would.
  * @child_post_remove: Called after a child device is removed. The device
  * has memory allocated but its device_remove() method has been called.
  * @priv_auto_alloc_size: If non-zero this is the size of the private data
@@ -272,8 +281,48 @@ struct driver {
 #if CONFIG_IS_ENABLED(ACPIGEN)
 	struct acpi_ops *acpi_ops;
 #endif
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	int (*probe_poll)(struct udevice *dev);
+#endif
 };
 
+/* Allow the probe_poll() method to be optional */
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+#define DM_PROBE_POLL_PTR(_fn)	.probe_poll	= _fn,
+#else
+#define DM_PROBE_POLL_PTR(_fn)
+#endif
+
+/**
+ * dev_probe_defer() - Leave the rest of a probe to the probe_poll() method
+ *
+ * This is for probe() methods which have started something slow, such as
+ * powering up a card or waiting for a link, so that other devices can be
+ * probed meanwhile. The probe() method returns the value of this function,
+ * and the driver sets up its probe_poll() method with DM_PROBE_POLL_PTR().
+ *
+ * Without CONFIG_DM_PROBE_ASYNC, @poll is called here until the device is
+ * ready.
+ *
+ * @dev:	Device being probed
+ * @poll:	probe_poll() method of the driver
+ * @return -EINPROGRESS if the probe goes on in the background, else the value
+ *	returned by @poll
+ */
+static inline int dev_probe_defer(struct udevice *dev,
+				  int (*poll)(struct udevice *dev))
+{
+	int ret;
+
+	if (CONFIG_IS_ENABLED(DM_PROBE_ASYNC))
+		return -EINPROGRESS;
+	do {
+		ret = poll(dev);
+	} while (ret == -EINPROGRESS);
+
+	return ret;
+}
+
 /* Declare a new U-Boot driver */
 #define U_BOOT_DRIVER(__name)						\
 	ll_entry_declare(struct driver, __name, driver)
@@ -90,7 +90,7 @@ DECLARE_GLOBAL_DATA_PTR;
  *
  * @returns true if livetree is active, false it not
  */
-#ifdef CONFIG_OF_LIVE
+#if CONFIG_IS_ENABLED(OF_LIVE)
 static inline bool of_live_active(void)
 {
 	return gd->of_root != NULL;
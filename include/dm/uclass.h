@@ -350,6 +350,18 @@ int uclass_first_device_check(enum uclass_id id, struct udevice **devp);
  */
 int uclass_next_device_check(struct udevice **devp);
 
+/**
+ * uclass_probe_all() - Probe all devices in a uclass
+ *
+ * With CONFIG_DM_PROBE_ASYNC, devices which wait for a while in their probe()
+ * method are probed together, see device_probe_all().
+ *
+ * @id: Uclass ID to probe
+ * @return 0 if all devices were probed, else the error of the first device
+ * which failed. All devices are tried regardless.
+ */
+int uclass_probe_all(enum uclass_id id);
+
 /**
  * uclass_first_device_drvdata() - Find the first device with given driver data
  *
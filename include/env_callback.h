@@ -74,10 +74,15 @@
 
 #ifndef CONFIG_SPL_BUILD
 void env_callback_init(struct env_entry *var_entry);
+void env_callback_load(void);
 #else
 static inline void env_callback_init(struct env_entry *var_entry)
 {
 }
+
+static inline void env_callback_load(void)
+{
+}
 #endif
 
 #endif /* __ENV_CALLBACK_H__ */
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Index of the variables of an environment
+ *
+ * The "name=value" list of an environment may be followed by an index of its
+ * entries, sorted by name, so that variables can be looked up in place rather
+ * than importing the whole list when U-Boot starts. The index is at the very
+ * end of the environment data, after any padding:
+ *
+ *	name=value\0 ... name=value\0\0 ... offset[0] ... offset[count - 1] tail
+ *
+ * Each offset gives the start of an entry, i.e. of its name, from the start
+ * of the data. Only the last entry of a variable is indexed, and variables
+ * deleted by a later empty entry not at all. All fields are in the byte order
+ * of the target.
+ *
+ * Readers not aware of the index see an environment like any other, as the
+ * list is terminated before the index.
+ */
+
+#ifndef _ENV_INDEX_H
+#define _ENV_INDEX_H
+
+#define ENV_INDEX_MAGIC		0x78646e49	/* "Indx" */
+
+/**
+ * struct env_index_tail - Last bytes of an environment with an index
+ *
+ * @list_size:	Size of the "name=value" list, including both '\0' at its end
+ * @list_crc:	CRC32 of the list, so that an index which was not updated
+ *		together with the list is not used
+ * @count:	Number of offsets in the index, which comes just before this
+ * @magic:	ENV_INDEX_MAGIC
+ */
+struct env_index_tail {
+	uint32_t list_size;
+	uint32_t list_crc;
+	uint32_t count;
+	uint32_t magic;
+};
+
+#endif /* _ENV_INDEX_H */
@@ -125,6 +125,9 @@ struct ext_block_cache {
 	int size;
 };
 
+/* Extent trees are at most this deep, so cache one block per level */
+#define EXT_CACHE_LEVELS	5
+
 extern struct ext2_data *ext4fs_root;
 extern struct ext2fs_node *ext4fs_file;
 
@@ -157,6 +160,24 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache);
+/**
+ * ext4fs_map_blocks() - map a run of file blocks to disk blocks
+ *
+ * Find where 'fileblock' is stored, and how many of the file blocks after it
+ * follow it contiguously on the disk (or are all holes), so that the whole
+ * run can be read at once.
+ *
+ * @inode:	inode of the file
+ * @fileblock:	first file block of the run
+ * @maxblocks:	maximum length of the run
+ * @cache:	array of EXT_CACHE_LEVELS caches for the extent tree blocks
+ * @count:	returns the number of blocks in the run, at least 1
+ * @return file system block of 'fileblock', 0 for a hole, or
+ *	a negative value on error
+ */
+long int ext4fs_map_blocks(struct ext2_inode *inode, int fileblock,
+			   int maxblocks, struct ext_block_cache *cache,
+			   int *count);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 struct disk_partition *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
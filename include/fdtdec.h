@@ -1150,6 +1150,77 @@ int fdtdec_set_carveout(void *blob, const char *node, const char *prop_name,
 			unsigned int index, const char *name,
 			const struct fdt_memory *carveout);
 
+#if CONFIG_IS_ENABLED(OF_INDEX)
+/**
+ * fdtdec_node_offset_by_phandle() - Find a node by phandle
+ *
+ * This gives the same result as fdt_node_offset_by_phandle(), but uses the
+ * index of the control tree (see CONFIG_OF_INDEX) if @blob is that tree.
+ *
+ * @blob:	FDT blob
+ * @phandle:	Phandle to find
+ * @return offset of the node, or -ve FDT_ERR_... error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_node_offset_by_compatible() - Find the next node with a compatible
+ *
+ * This gives the same result as fdt_node_offset_by_compatible(), but uses
+ * the index of the control tree if @blob is that tree.
+ *
+ * @blob:	FDT blob
+ * @startoffset: Only find nodes after this offset, -1 to find the first
+ * @compat:	Compatible string to find
+ * @return offset of the node, or -ve FDT_ERR_... error
+ */
+int fdtdec_node_offset_by_compatible(const void *blob, int startoffset,
+				     const char *compat);
+
+/**
+ * fdtdec_path_offset() - Find a node by path
+ *
+ * This gives the same result as fdt_path_offset(), but uses the index of the
+ * control tree if @blob is that tree and @path is a full path.
+ *
+ * @blob:	FDT blob
+ * @path:	Path of node, or alias
+ * @return offset of the node, or -ve FDT_ERR_... error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_index_invalidate() - Drop the index of the control tree
+ *
+ * The index is built again when next used. This is only needed if the
+ * control tree is changed without changing its size, as the index notices
+ * other changes itself.
+ */
+void fdtdec_index_invalidate(void);
+#else
+static inline int fdtdec_node_offset_by_phandle(const void *blob,
+						uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int fdtdec_node_offset_by_compatible(const void *blob,
+						   int startoffset,
+						   const char *compat)
+{
+	return fdt_node_offset_by_compatible(blob, startoffset, compat);
+}
+
+static inline int fdtdec_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline void fdtdec_index_invalidate(void)
+{
+}
+#endif
+
 /**
  * Set up the device tree ready for use
  */
@@ -31,6 +31,30 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * gunzip_chunked() - Decompress gzipped data, one chunk of input at a time
+ *
+ * The input is passed to @func in chunks of @chunk bytes before it is
+ * decompressed, so that the caller can process it (e.g. hash it) in the same
+ * pass as the decompression.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @src: Source data to decompress
+ * @srclen: Length of the source data
+ * @chunk: Number of bytes of input to handle at a time
+ * @func: Function to call for each chunk of input, or NULL. It returns 0 to
+ *	continue, or non-zero to stop with an error.
+ * @priv: Private data for @func
+ * @lenp: Returns length of uncompressed data
+ * @return 0 if OK, -1 on error, including when the uncompressed data does not
+ *	fit in @dstlen bytes
+ */
+int gunzip_chunked(void *dst, int dstlen, unsigned char *src,
+		   unsigned long srclen, unsigned long chunk,
+		   int (*func)(void *priv, const void *buf, unsigned long len),
+		   void *priv, unsigned long *lenp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
@@ -43,6 +43,7 @@ struct fdt_region;
 #include <lmb.h>
 #include <asm/u-boot.h>
 #include <command.h>
+#include <linux/errno.h>
 
 /* Take notice of the 'ignore' property for hashes */
 #define IMAGE_ENABLE_IGNORE	1
@@ -308,6 +309,7 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -1105,6 +1107,133 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *data, size_t size);
 int fit_image_verify(const void *fit, int noffset);
+
+/* Maximum number of hash nodes of an image which are hashed on load */
+#define FIT_IMAGE_HASH_MAX	4
+
+/**
+ * struct fit_image_hash - progressive hashes of an image's data
+ *
+ * This is used to hash image data in pieces as it is loaded or decompressed,
+ * while it is still in the cache. Once finished, the results must be passed
+ * straight to fit_image_verify_hashed(), before anything else can change
+ * the data. They are never kept for later.
+ *
+ * @fit:	FIT containing the image
+ * @count:	Number of hashes in use
+ * @hash:	One entry for each hash node of the image
+ * @hash.node:	Offset of the hash node
+ * @hash.algo:	Hash algorithm, NULL once the hash is finished
+ * @hash.ctx:	Hash context
+ * @hash.len:	Length of @hash.value, 0 if there is no value
+ * @hash.value:	Hash value once finished, in the format of the hash node's
+ *		value property
+ */
+struct fit_image_hash {
+	const void *fit;
+	int count;
+	struct {
+		int node;
+		struct hash_algo *algo;
+		void *ctx;
+		int len;
+		uint8_t value[FIT_MAX_HASH_LEN];
+	} hash[FIT_IMAGE_HASH_MAX];
+};
+
+/**
+ * fit_image_verify_hashed() - verify an image using hashes computed already
+ *
+ * This is fit_image_verify_with_data(), except that the values in @ih are
+ * used for the hash nodes which it covers, instead of hashing @data again.
+ * @ih must have been computed over @data by the caller, just before this
+ * call. Signatures are checked as usual.
+ *
+ * @fit:		FIT containing the image
+ * @image_noffset:	Offset of the image node
+ * @data:		Image data
+ * @size:		Size of the image data
+ * @ih:			Hashes finished by fit_image_hash_end(), or NULL
+ * @return 1 if the image is valid, 0 if not (or on error)
+ */
+int fit_image_verify_hashed(const void *fit, int image_noffset,
+			    const void *data, size_t size,
+			    const struct fit_image_hash *ih);
+
+/* Images are only hashed progressively on the device */
+#if defined(USE_HOSTCC)
+# define FIT_IMAGE_ENABLE_LOAD_HASH	0
+# define FIT_IMAGE_ENABLE_STREAM_DECOMP	0
+#else
+# define FIT_IMAGE_ENABLE_LOAD_HASH	CONFIG_IS_ENABLED(FIT_LOAD_HASH)
+# define FIT_IMAGE_ENABLE_STREAM_DECOMP	CONFIG_IS_ENABLED(FIT_STREAM_DECOMP)
+#endif
+
+#if FIT_IMAGE_ENABLE_LOAD_HASH
+/**
+ * fit_image_hash_start() - start hashing the data of an image
+ *
+ * @fit:	FIT containing the image
+ * @noffset:	Offset of the image node
+ * @ih:	Returns the hash state
+ * @return 0 if OK, -EPROTONOSUPPORT if a hash algorithm cannot be used
+ *	progressively, other -ve on error
+ */
+int fit_image_hash_start(const void *fit, int noffset,
+			 struct fit_image_hash *ih);
+
+/**
+ * fit_image_hash_update() - hash the next part of an image's data
+ *
+ * On error all hashes are dropped, and the image will be hashed again when
+ * it is verified.
+ *
+ * @ih:		Hash state
+ * @buf:	Next part of the data
+ * @len:	Length of @buf
+ * @return 0 if OK, -EIO on error
+ */
+int fit_image_hash_update(struct fit_image_hash *ih, const void *buf,
+			  ulong len);
+
+/**
+ * fit_image_hash_end() - finish hashing
+ *
+ * The hash values are stored in @ih, for fit_image_verify_hashed()
+ *
+ * @ih:		Hash state
+ */
+void fit_image_hash_end(struct fit_image_hash *ih);
+
+/**
+ * fit_image_hash_abort() - drop the hashes without using them
+ *
+ * @ih:		Hash state
+ */
+void fit_image_hash_abort(struct fit_image_hash *ih);
+#else
+static inline int fit_image_hash_start(const void *fit, int noffset,
+				       struct fit_image_hash *ih)
+{
+	ih->count = 0;
+
+	return -ENOSYS;
+}
+
+static inline int fit_image_hash_update(struct fit_image_hash *ih,
+					const void *buf, ulong len)
+{
+	return -ENOSYS;
+}
+
+static inline void fit_image_hash_end(struct fit_image_hash *ih)
+{
+}
+
+static inline void fit_image_hash_abort(struct fit_image_hash *ih)
+{
+}
+#endif
 int fit_config_verify(const void *fit, int conf_noffset);
 int fit_all_image_verify(const void *fit);
 int fit_config_decrypt(const void *fit, int conf_noffset);
@@ -247,6 +247,7 @@ enum spi_nor_option_flags {
 	SNOR_F_READY_XSR_RDY	= BIT(4),
 	SNOR_F_USE_CLSR		= BIT(5),
 	SNOR_F_BROKEN_RESET	= BIT(6),
+	SNOR_F_4B_OPCODES	= BIT(7),
 };
 
 /**
@@ -255,6 +256,8 @@ enum spi_nor_option_flags {
  */
 struct flash_info;
 
+struct spi_mem_dirmap_desc;
+
 /*
  * TODO: Remove, once all users of spi_flash interface are moved to MTD
  *
@@ -302,6 +305,7 @@ struct flash_info;
  * @flash_is_locked:	[FLASH-SPECIFIC] check if a region of the SPI NOR is
  * @quad_enable:	[FLASH-SPECIFIC] enables SPI NOR quad mode
  *			completely locked
+ * @dirmap.rdesc:	direct mapping used for large reads, or NULL
  * @priv:		the private data
  */
 struct spi_nor {
@@ -344,6 +348,10 @@ struct spi_nor {
 	int (*flash_is_locked)(struct spi_nor *nor, loff_t ofs, uint64_t len);
 	int (*quad_enable)(struct spi_nor *nor);
 
+	struct {
+		struct spi_mem_dirmap_desc *rdesc;
+	} dirmap;
+
 	void *priv;
 /* Compatibility for spi_flash, remove once sf layer is merged with mtd */
 	const char *name;
@@ -437,4 +445,10 @@ struct spi_nor_hwcaps {
  */
 int spi_nor_scan(struct spi_nor *nor);
 
+/**
+ * spi_nor_remove() - release what spi_nor_scan() set up
+ * @nor:	the spi_nor structure
+ */
+void spi_nor_remove(struct spi_nor *nor);
+
 #endif
@@ -74,6 +74,10 @@ struct bd_info;
 #define MMC_CAP_NONREMOVABLE	BIT(14)
 #define MMC_CAP_NEEDS_POLL	BIT(15)
 #define MMC_CAP_CD_ACTIVE_HIGH  BIT(16)
+/* Host stops multiple-block transfers itself, so CMD12 is not needed */
+#define MMC_CAP_AUTO_STOP	BIT(17)
+/* Host can send SET_BLOCK_COUNT ahead of a multiple-block transfer */
+#define MMC_CAP_CMD23		BIT(18)
 
 #define MMC_MODE_8BIT		BIT(30)
 #define MMC_MODE_4BIT		BIT(29)
@@ -82,6 +86,7 @@ struct bd_info;
 
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23_SUPPORT	BIT(1)
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -432,6 +437,37 @@ struct dm_mmc_ops {
 	int (*send_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * send_cmd_start() - Start a data command without waiting for it
+	 *
+	 * This sends the command and starts the data transfer, which goes on
+	 * in the background. send_cmd_poll() is then called until the
+	 * command has finished. No other command is sent in the meantime.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to send/receive
+	 * @return 0 if started, -ENOSYS if the command must be sent with
+	 * send_cmd() instead, other -ve on error
+	 */
+	int (*send_cmd_start)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * send_cmd_poll() - Check whether a command started by
+	 *		     send_cmd_start() has finished
+	 *
+	 * @dev:	Device the command was sent to
+	 * @cmd:	Command passed to send_cmd_start()
+	 * @data:	Data passed to send_cmd_start()
+	 * @return 0 if finished OK, -EBUSY if still in progress, other -ve
+	 * if the command failed
+	 */
+	int (*send_cmd_poll)(struct udevice *dev, struct mmc_cmd *cmd,
+			     struct mmc_data *data);
+#endif
+
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
@@ -511,6 +547,10 @@ struct dm_mmc_ops {
 
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data);
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data);
 int dm_mmc_set_ios(struct udevice *dev);
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
@@ -697,6 +737,12 @@ struct mmc {
 				  * accessing the boot partitions
 				  */
 	u32 quirks;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_req *async_req;	/* asynchronous read in progress */
+	struct mmc_cmd async_cmd;	/* its command and data */
+	struct mmc_data async_data;
+	bool async_stop;		/* it must be stopped with CMD12 */
+#endif
 };
 
 struct mmc_hwpart_conf {
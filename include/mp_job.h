@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running compute jobs on secondary CPUs
+ */
+
+#ifndef __MP_JOB_H
+#define __MP_JOB_H
+
+/**
+ * struct mp_job - a job which can run on any CPU
+ *
+ * Jobs run on secondary CPUs must only compute: they must not allocate or
+ * free memory, print, use drivers or change global state other than their
+ * own data. The CPU they run on is not known in advance.
+ *
+ * @func:	Function to call
+ * @arg:	Argument to pass to @func
+ * @ret:	Value returned by @func, set once the job has run
+ */
+struct mp_job {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+};
+
+#if CONFIG_IS_ENABLED(MP_JOBS)
+/**
+ * mp_job_cpus() - Get the number of CPUs which can run jobs
+ *
+ * @return number of CPUs, including the boot CPU
+ */
+int mp_job_cpus(void);
+
+/**
+ * mp_run_jobs() - Run jobs in parallel
+ *
+ * This starts as many secondary CPUs as useful, runs the jobs on them and on
+ * the boot CPU, and waits for all of the jobs to finish. The secondary CPUs
+ * are stopped again before this returns, so nothing is left running when an
+ * OS is booted. If no secondary CPU can be started, the jobs all run on the
+ * boot CPU.
+ *
+ * @jobs:	Jobs to run, each ret member is set when this returns
+ * @count:	Number of jobs
+ * @return 0 if all jobs returned 0, -ETIMEDOUT if the jobs did not finish
+ *	in time, -ve if a secondary CPU could not be stopped, else the first
+ *	error returned by a job
+ */
+int mp_run_jobs(struct mp_job *jobs, int count);
+#else
+static inline int mp_job_cpus(void)
+{
+	return 1;
+}
+
+static inline int mp_run_jobs(struct mp_job *jobs, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		jobs[i].ret = jobs[i].func(jobs[i].arg);
+		if (jobs[i].ret && !ret)
+			ret = jobs[i].ret;
+	}
+
+	return ret;
+}
+#endif
+
+/*
+ * Provided by the architecture. The weak default has no secondary CPUs.
+ */
+
+/**
+ * arch_mp_job_cpus() - Get the number of CPUs which can run jobs
+ *
+ * @return number of CPUs, including the boot CPU (at least 1)
+ */
+int arch_mp_job_cpus(void);
+
+/**
+ * arch_mp_job_start() - Start a secondary CPU
+ *
+ * The CPU calls @entry once started, with caches and the MMU set up as on the
+ * boot CPU. Once @entry returns, the CPU stops.
+ *
+ * @cpu:	CPU number, from 1 to arch_mp_job_cpus() - 1
+ * @entry:	Function for the CPU to run
+ * @return 0 if OK, -ve on error
+ */
+int arch_mp_job_start(int cpu, void (*entry)(void));
+
+/**
+ * arch_mp_job_stop() - Wait for a secondary CPU to stop
+ *
+ * This is called once @entry passed to arch_mp_job_start() has returned, or
+ * is about to return.
+ *
+ * @cpu:	CPU number, from 1 to arch_mp_job_cpus() - 1
+ * @return 0 if OK, -ve on error
+ */
+int arch_mp_job_stop(int cpu);
+
+#endif
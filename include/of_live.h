@@ -14,6 +14,9 @@ struct device_node;
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
  *
+ * With SPL_OF_LIVE_PREBUILT the tree generated at build time is used instead,
+ * so @fdt_blob must be the tree it was generated from.
+ *
  * @fdt_blob: Input tree to convert
  * @rootp: Returns live tree that was created
  * @return 0 if OK, -ve on error
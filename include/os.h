@@ -36,6 +36,31 @@ ssize_t os_read(int fd, void *buf, size_t count);
  */
 ssize_t os_write(int fd, const void *buf, size_t count);
 
+/**
+ * Access to the OS pread() system call
+ *
+ * This does not change the file offset, so it can be used by several host
+ * threads at once.
+ *
+ * \param fd	File descriptor as returned by os_open()
+ * \param buf	Buffer to place data
+ * \param count	Number of bytes to read
+ * \param offset	File offset to read from
+ * \return number of bytes read, or -1 on error
+ */
+ssize_t os_pread(int fd, void *buf, size_t count, off_t offset);
+
+/**
+ * Access to the OS pwrite() system call
+ *
+ * \param fd	File descriptor as returned by os_open()
+ * \param buf	Buffer containing data to write
+ * \param count	Number of bytes to write
+ * \param offset	File offset to write to
+ * \return number of bytes written, or -1 on error
+ */
+ssize_t os_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
 /**
  * Access to the OS lseek() system call
  *
@@ -355,4 +380,24 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 void *os_find_text_base(void);
 
+/**
+ * os_thread_start() - Start a host thread
+ *
+ * The thread calls @func with @arg and ends when it returns.
+ *
+ * @func:	Function to run in the thread
+ * @arg:	Argument to pass to @func
+ * @threadp:	Returns the thread, to pass to os_thread_join()
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_start(void (*func)(void *arg), void *arg, void **threadp);
+
+/**
+ * os_thread_join() - Wait for a host thread to end
+ *
+ * @thread:	Thread returned by os_thread_start()
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_join(void *thread);
+
 #endif
@@ -47,6 +47,28 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int deleted;		/* deleted slots in table */
+	/* Table whose entries are being moved into table, NULL if none */
+	struct env_entry_node *old_table;
+	unsigned int old_size;
+	unsigned int old_pos;		/* next slot of old_table to move */
+	/* All entries, sorted by key for export up to nsorted */
+	struct env_entry **entries;
+	unsigned int nentries;
+	unsigned int nsorted;
+	unsigned int ndead;		/* deleted entries still in entries */
+	unsigned int max_entries;	/* allocated length of entries */
+	/*
+	 * Indexed environment, see env_index.h, whose variables are entered
+	 * into the table as they are looked up. The list follows the index.
+	 */
+	uint32_t *index;
+	char *index_list;
+	unsigned int index_count;
+	unsigned char *index_used;	/* bitmap of entries looked up */
+	int index_flag;			/* flag to enter the entries with */
+	unsigned int index_depth;	/* entries being entered, see below */
+	bool index_done;		/* drop the index once depth is 0 */
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -58,7 +80,10 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/*
+ * Create a new hash table with room for "nel" elements. It grows when it
+ * fills up.
+ */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
@@ -94,6 +119,22 @@ int himport_r(struct hsearch_data *htab, const char *env, size_t size,
 	      const char sep, int flag, int crlf_is_lf, int nvars,
 	      char * const vars[]);
 
+/*
+ * Import an environment with an index, see env_index.h, replacing the
+ * current table. The variables are not entered into the table until they are
+ * looked up, with "flag" as if they were imported then. Returns 0 with errno
+ * set to EINVAL if there is no valid index.
+ */
+int himport_index_r(struct hsearch_data *htab, const char *env, size_t size,
+		    int flag);
+
+/*
+ * Add an index to the end of a buffer of "size" bytes holding a sorted list
+ * as exported by hexport_r() with '\0' as the separator. Returns 0 if OK or
+ * -ENOSPC if there is no room for the index.
+ */
+int hexport_index(char *res, size_t size);
+
 /* Walk the whole table calling the callback on each element */
 int hwalk_r(struct hsearch_data *htab,
 	    int (*callback)(struct env_entry *entry));
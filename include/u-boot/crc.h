@@ -93,6 +93,39 @@ uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len);
 void crc32_wd_buf(const uint8_t *input, uint ilen, uint8_t *output,
 		  uint chunk_sz);
 
+#ifdef CONFIG_ARMV8_CRC32
+/* arch/arm/cpu/armv8/crc32.S */
+
+/**
+ * crc32_armv8_supported() - Check for the ARMv8 CRC32 instructions
+ *
+ * @return 1 if the CPU implements them, 0 if not
+ */
+int crc32_armv8_supported(void);
+
+/**
+ * crc32_armv8_le() - Update a CRC32 using the ARMv8 CRC32 instructions
+ *
+ * This is the same as crc32_no_comp(), so no ones complement is done.
+ *
+ * @crc:	Previous crc
+ * @p:		Data bytes to checksum
+ * @len:	Number of bytes to process
+ * @return updated crc
+ */
+uint32_t crc32_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+
+/**
+ * crc32c_armv8_le() - Update a CRC32C using the ARMv8 CRC32 instructions
+ *
+ * @crc:	Previous crc
+ * @p:		Data bytes to checksum
+ * @len:	Number of bytes to process
+ * @return updated crc
+ */
+uint32_t crc32c_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+#endif
+
 /* lib/crc32c.c */
 
 /**
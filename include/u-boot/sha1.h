@@ -94,6 +94,26 @@ void sha1_hmac(const unsigned char *key, int keylen,
 		const unsigned char *input, unsigned int ilen,
 		unsigned char *output);
 
+/* Host tools have these when tools/Makefile sets HOST_SHA_CE */
+#if !defined(USE_HOSTCC) || defined(HOST_SHA_CE)
+/**
+ * sha1_ce_supported() - Check for the ARMv8 SHA1 instructions
+ *
+ * @return 1 if the CPU implements them, 0 if not
+ */
+int sha1_ce_supported(void);
+
+/**
+ * sha1_ce_transform() - Hash blocks using the ARMv8 Crypto Extensions
+ *
+ * @state:	Hash state, updated in place
+ * @src:	Input data
+ * @blocks:	Number of 64-byte blocks to process, must not be 0
+ */
+void sha1_ce_transform(uint32_t state[5], const uint8_t *src,
+		       unsigned int blocks);
+#endif
+
 /**
  * \brief	   Checkup routine
  *
@@ -22,4 +22,24 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/* Host tools have these when tools/Makefile sets HOST_SHA_CE */
+#if !defined(USE_HOSTCC) || defined(HOST_SHA_CE)
+/**
+ * sha256_ce_supported() - Check for the ARMv8 SHA256 instructions
+ *
+ * @return 1 if the CPU implements them, 0 if not
+ */
+int sha256_ce_supported(void);
+
+/**
+ * sha256_ce_transform() - Hash blocks using the ARMv8 Crypto Extensions
+ *
+ * @state:	Hash state, updated in place
+ * @src:	Input data
+ * @blocks:	Number of 64-byte blocks to process, must not be 0
+ */
+void sha256_ce_transform(uint32_t state[8], const uint8_t *src,
+			 unsigned int blocks);
+#endif
+
 #endif /* _SHA256_H */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompression of Zstandard data
+ */
+
+#ifndef __U_BOOT_ZSTD_H
+#define __U_BOOT_ZSTD_H
+
+#include <linux/zstd.h>
+
+/**
+ * zstd_decompress() - Decompress Zstandard data into a buffer
+ *
+ * All frames in @src are decompressed, one after the other. The work space
+ * has a fixed size (about 160KB), whatever the size of the data.
+ *
+ * @src: Source data to decompress
+ * @srcn: Length of source data
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of @dst on entry, length of uncompressed data on exit
+ * @return 0 if OK, -ENOMEM if the work space cannot be allocated, -ENOBUFS
+ *	if the destination buffer is overrun, -EINVAL if the data is not valid
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif
@@ -231,6 +231,38 @@ int board_usb_cleanup(int index, enum usb_init_type init);
 int usb_stor_scan(int mode);
 int usb_stor_info(void);
 
+/**
+ * struct usb_stor_stats - Transfer statistics of a USB mass storage device
+ *
+ * These cover all logical units of the device, since it was probed.
+ *
+ * @read_bytes:		Number of bytes read
+ * @write_bytes:	Number of bytes written
+ * @read_us:		Time spent reading, in microseconds
+ * @write_us:		Time spent writing, in microseconds
+ * @xfers:		Number of read and write commands which succeeded
+ * @errors:		Number of read and write commands which failed
+ * @max_xfer_blk:	Current maximum number of blocks in one command
+ */
+struct usb_stor_stats {
+	u64 read_bytes;
+	u64 write_bytes;
+	u64 read_us;
+	u64 write_us;
+	unsigned int xfers;
+	unsigned int errors;
+	unsigned int max_xfer_blk;
+};
+
+/**
+ * usb_stor_get_stats() - Get the transfer statistics of a storage device
+ *
+ * @desc:	Block device of the USB mass storage device
+ * @stats:	Returns the statistics
+ * @return 0 if OK, -ENODEV if @desc is not a USB mass storage device
+ */
+int usb_stor_get_stats(struct blk_desc *desc, struct usb_stor_stats *stats);
+
 #endif
 
 #ifdef CONFIG_USB_HOST_ETHER
@@ -30,7 +30,15 @@
 
 #define tole(x) cpu_to_le32(x)
 
-#ifdef CONFIG_DYNAMIC_CRC_TABLE
+#ifdef USE_HOSTCC
+#define CRC32_SLICE_BY_8	1
+#else
+#define CRC32_SLICE_BY_8	CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+#endif
+
+#if CRC32_SLICE_BY_8
+#include "crc32table.h"
+#elif defined(CONFIG_DYNAMIC_CRC_TABLE)
 
 static int __efi_runtime_data crc_table_empty = 1;
 static uint32_t __efi_runtime_data crc_table[256];
@@ -169,6 +177,47 @@ const uint32_t * ZEXPORT get_crc_table()
 }
 #endif
 
+#if CRC32_SLICE_BY_8
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+	const uint32_t (*tab)[256] = crc32_table;
+	const uint32_t *b;
+	uint32_t one, two;
+
+#ifdef CONFIG_ARMV8_CRC32
+	if (crc32_armv8_supported())
+		return crc32_armv8_le(crc, buf, len);
+#endif
+	/* Align it */
+	while (len && ((ulong)buf & 3)) {
+		crc = tab[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+		len--;
+	}
+
+	/* Then go through eight bytes at a time */
+	for (b = (const uint32_t *)buf; len >= 8; len -= 8) {
+		one = le32_to_cpu(*b++) ^ crc;
+		two = le32_to_cpu(*b++);
+		crc = tab[7][one & 0xff] ^
+		      tab[6][(one >> 8) & 0xff] ^
+		      tab[5][(one >> 16) & 0xff] ^
+		      tab[4][one >> 24] ^
+		      tab[3][two & 0xff] ^
+		      tab[2][(two >> 8) & 0xff] ^
+		      tab[1][(two >> 16) & 0xff] ^
+		      tab[0][two >> 24];
+	}
+
+	/* And the last few bytes */
+	for (buf = (const Bytef *)b; len; len--)
+		crc = tab[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+#else
 /* ========================================================================= */
 # if __BYTE_ORDER == __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = tab[(crc ^ (x)) & 255] ^ (crc >> 8)
@@ -186,6 +235,10 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
+#ifdef CONFIG_ARMV8_CRC32
+    if (crc32_armv8_supported())
+      return crc32_armv8_le(crc, buf, len);
+#endif
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
     if (crc_table_empty)
       make_crc_table();
@@ -222,6 +275,7 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     return le32_to_cpu(crc);
 }
 #undef DO_CRC
+#endif
 
 uint32_t __efi_runtime crc32(uint32_t crc, const Bytef *p, uInt len)
 {
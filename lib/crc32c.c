@@ -12,10 +12,19 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <u-boot/crc.h>
+
+/* Bit-reflected CRC32C (Castagnoli) polynomial */
+#define CRC32C_POLY	0x82f63b78
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+#ifdef CONFIG_ARMV8_CRC32
+	/* The entry for 0x80 is the polynomial itself */
+	if (crc32c_table[0x80] == CRC32C_POLY && crc32_armv8_supported())
+		return crc32c_armv8_le(crc, (const u8 *)data, length);
+#endif
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
@@ -0,0 +1,378 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Index of the control device tree
+ *
+ * Finding a node of a flat tree by phandle, compatible string or path means
+ * scanning the tree from its start. Once U-Boot has relocated, an index of
+ * the control tree (gd->fdt_blob) is built on first use so that these lookups
+ * only take a binary search.
+ *
+ * The index holds offsets into the tree, so it is dropped and built again
+ * when a different tree is used, or when the size of the tree changes, as it
+ * does when nodes or properties are added or removed. A node found through
+ * the index is also checked, in case the tree was changed in place.
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <sort.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	/* Nodes deeper than this are not in the path index */
+	INDEX_MAX_DEPTH		= 32,
+
+	FNV_OFFSET_BASIS	= 0x811c9dc5,
+	FNV_PRIME		= 0x01000193,
+};
+
+struct index_phandle {
+	u32 phandle;
+	int offset;
+};
+
+struct index_compat {
+	const char *compat;	/* Points into the tree */
+	int offset;
+};
+
+struct index_path {
+	u32 hash;		/* Hash of the full path of the node */
+	int offset;
+	int parent;		/* Offset of the parent node, -1 for the root */
+};
+
+/**
+ * struct fdtdec_index - Index of a flat tree
+ *
+ * @blob:		Tree which is indexed
+ * @size_dt_struct:	Size of its structure block when indexed
+ * @size_dt_strings:	Size of its strings block when indexed
+ * @phandle:		Nodes with a phandle, by phandle
+ * @phandle_count:	Number of entries in @phandle
+ * @compat:		Each compatible string of each node, by string and
+ *			then by offset
+ * @compat_count:	Number of entries in @compat
+ * @path:		Nodes by hash of their path
+ * @path_count:		Number of entries in @path
+ */
+struct fdtdec_index {
+	const void *blob;
+	u32 size_dt_struct;
+	u32 size_dt_strings;
+	struct index_phandle *phandle;
+	int phandle_count;
+	struct index_compat *compat;
+	int compat_count;
+	struct index_path *path;
+	int path_count;
+};
+
+static u32 hash_add(u32 hash, const char *str, int len)
+{
+	for (; len; len--, str++)
+		hash = (hash ^ (u8)*str) * FNV_PRIME;
+
+	return hash;
+}
+
+static u32 hash_path(const char *path)
+{
+	return hash_add(FNV_OFFSET_BASIS, path, strlen(path));
+}
+
+static int h_cmp_phandle(const void *v1, const void *v2)
+{
+	const struct index_phandle *p1 = v1, *p2 = v2;
+
+	return p1->phandle < p2->phandle ? -1 : p1->phandle > p2->phandle;
+}
+
+static int h_cmp_compat(const void *v1, const void *v2)
+{
+	const struct index_compat *c1 = v1, *c2 = v2;
+	int ret;
+
+	ret = strcmp(c1->compat, c2->compat);
+	if (ret)
+		return ret;
+
+	return c1->offset - c2->offset;
+}
+
+static int h_cmp_path(const void *v1, const void *v2)
+{
+	const struct index_path *p1 = v1, *p2 = v2;
+
+	if (p1->hash != p2->hash)
+		return p1->hash < p2->hash ? -1 : 1;
+
+	return p1->offset - p2->offset;
+}
+
+/*
+ * Walk the tree, filling in the index if @idx has space for its entries or
+ * just counting them if not
+ */
+static int index_scan(const void *blob, struct fdtdec_index *idx)
+{
+	u32 hash[INDEX_MAX_DEPTH];
+	int node[INDEX_MAX_DEPTH];
+	int offset, depth, len;
+	const char *compat, *end, *name;
+	u32 phandle;
+
+	idx->phandle_count = 0;
+	idx->compat_count = 0;
+	idx->path_count = 0;
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle) {
+			if (idx->phandle) {
+				idx->phandle[idx->phandle_count].phandle =
+					phandle;
+				idx->phandle[idx->phandle_count].offset =
+					offset;
+			}
+			idx->phandle_count++;
+		}
+
+		compat = fdt_getprop(blob, offset, "compatible", &len);
+		if (!compat)
+			len = 0;
+		for (end = compat + len; compat < end;
+		     compat += strlen(compat) + 1) {
+			if (idx->compat) {
+				idx->compat[idx->compat_count].compat = compat;
+				idx->compat[idx->compat_count].offset = offset;
+			}
+			idx->compat_count++;
+		}
+
+		if (depth >= INDEX_MAX_DEPTH)
+			continue;
+		if (!depth) {
+			hash[0] = hash_path("/");
+		} else {
+			name = fdt_get_name(blob, offset, &len);
+			if (!name)
+				return len;
+			hash[depth] = hash[depth - 1];
+			if (depth > 1)
+				hash[depth] = hash_add(hash[depth], "/", 1);
+			hash[depth] = hash_add(hash[depth], name, len);
+		}
+		node[depth] = offset;
+		if (idx->path) {
+			idx->path[idx->path_count].hash = hash[depth];
+			idx->path[idx->path_count].offset = offset;
+			idx->path[idx->path_count].parent =
+				depth ? node[depth - 1] : -1;
+		}
+		idx->path_count++;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	return 0;
+}
+
+static struct fdtdec_index *index_build(const void *blob)
+{
+	struct fdtdec_index count, *idx;
+	int ret;
+
+	memset(&count, '\0', sizeof(count));
+	ret = index_scan(blob, &count);
+	if (ret) {
+		log_debug("Cannot index device tree (err=%d)\n", ret);
+		return NULL;
+	}
+
+	idx = malloc(sizeof(*idx) +
+		     count.phandle_count * sizeof(*idx->phandle) +
+		     count.compat_count * sizeof(*idx->compat) +
+		     count.path_count * sizeof(*idx->path));
+	if (!idx)
+		return NULL;
+	idx->blob = blob;
+	idx->size_dt_struct = fdt_size_dt_struct(blob);
+	idx->size_dt_strings = fdt_size_dt_strings(blob);
+	idx->compat = (struct index_compat *)(idx + 1);
+	idx->path = (struct index_path *)(idx->compat + count.compat_count);
+	idx->phandle = (struct index_phandle *)(idx->path + count.path_count);
+	index_scan(blob, idx);
+
+	qsort(idx->phandle, idx->phandle_count, sizeof(*idx->phandle),
+	      h_cmp_phandle);
+	qsort(idx->compat, idx->compat_count, sizeof(*idx->compat),
+	      h_cmp_compat);
+	qsort(idx->path, idx->path_count, sizeof(*idx->path), h_cmp_path);
+	log_debug("Indexed %d phandles, %d compatible strings, %d paths\n",
+		  idx->phandle_count, idx->compat_count, idx->path_count);
+
+	return idx;
+}
+
+void fdtdec_index_invalidate(void)
+{
+	free(gd->fdt_index);
+	gd->fdt_index = NULL;
+}
+
+/**
+ * index_get() - Get the index of a tree
+ *
+ * @blob:	Tree to look up
+ * @return index of the tree, or NULL if it should be scanned instead
+ */
+static struct fdtdec_index *index_get(const void *blob)
+{
+	struct fdtdec_index *idx = gd->fdt_index;
+
+	/* The index is allocated for good, so wait for the full malloc() */
+	if (blob != gd->fdt_blob || !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return NULL;
+	if (idx && (idx->blob != blob ||
+		    idx->size_dt_struct != fdt_size_dt_struct(blob) ||
+		    idx->size_dt_strings != fdt_size_dt_strings(blob))) {
+		fdtdec_index_invalidate();
+		idx = NULL;
+	}
+	if (!idx) {
+		idx = index_build(blob);
+		gd->fdt_index = idx;
+	}
+
+	return idx;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	struct fdtdec_index *idx = index_get(blob);
+	int lo, hi, mid;
+
+	if (!idx || !phandle || phandle == -1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	for (lo = 0, hi = idx->phandle_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (idx->phandle[mid].phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == idx->phandle_count || idx->phandle[lo].phandle != phandle)
+		return -FDT_ERR_NOTFOUND;
+	if (fdt_get_phandle(blob, idx->phandle[lo].offset) != phandle) {
+		fdtdec_index_invalidate();
+		return fdt_node_offset_by_phandle(blob, phandle);
+	}
+
+	return idx->phandle[lo].offset;
+}
+
+int fdtdec_node_offset_by_compatible(const void *blob, int startoffset,
+				     const char *compat)
+{
+	struct fdtdec_index *idx = index_get(blob);
+	struct index_compat key;
+	int lo, hi, mid;
+
+	if (!idx)
+		return fdt_node_offset_by_compatible(blob, startoffset, compat);
+
+	/* Find the first node after @startoffset with this string */
+	key.compat = compat;
+	key.offset = startoffset + 1;
+	for (lo = 0, hi = idx->compat_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (h_cmp_compat(&idx->compat[mid], &key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == idx->compat_count || strcmp(idx->compat[lo].compat, compat))
+		return -FDT_ERR_NOTFOUND;
+	if (fdt_node_check_compatible(blob, idx->compat[lo].offset, compat)) {
+		fdtdec_index_invalidate();
+		return fdt_node_offset_by_compatible(blob, startoffset, compat);
+	}
+
+	return idx->compat[lo].offset;
+}
+
+/* Find the first path entry at or after (@hash, @offset) */
+static int index_find_path(struct fdtdec_index *idx, u32 hash, int offset)
+{
+	struct index_path key;
+	int lo, hi, mid;
+
+	key.hash = hash;
+	key.offset = offset;
+	for (lo = 0, hi = idx->path_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (h_cmp_path(&idx->path[mid], &key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Check that the node of a path entry has the path @path, by comparing the
+ * name of each node from it up to the root with the components of @path.
+ * The parents are found through the index, so this does not scan the tree.
+ */
+static bool index_check_path(const void *blob, struct fdtdec_index *idx,
+			     const struct index_path *entry, const char *path)
+{
+	const char *comp, *end, *name;
+	u32 hash;
+	int i, len;
+
+	for (end = path + strlen(path);; end = comp - 1) {
+		for (comp = end; comp[-1] != '/'; comp--)
+			;
+		name = fdt_get_name(blob, entry->offset, &len);
+		if (!name || len != end - comp || memcmp(name, comp, len))
+			return false;
+		if (comp - 1 == path)
+			return entry->parent == 0;
+
+		hash = hash_add(FNV_OFFSET_BASIS, path, comp - 1 - path);
+		i = index_find_path(idx, hash, entry->parent);
+		if (i == idx->path_count || idx->path[i].hash != hash ||
+		    idx->path[i].offset != entry->parent)
+			return false;
+		entry = &idx->path[i];
+	}
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	struct fdtdec_index *idx = index_get(blob);
+	u32 hash;
+	int i;
+
+	/* Aliases, paths without unit addresses and the root go to libfdt */
+	if (!idx || *path != '/' || !path[1])
+		return fdt_path_offset(blob, path);
+
+	/* Different paths can have the same hash, so check each */
+	hash = hash_path(path);
+	for (i = index_find_path(idx, hash, -1);
+	     i < idx->path_count && idx->path[i].hash == hash; i++) {
+		if (index_check_path(blob, idx, &idx->path[i], path))
+			return idx->path[i].offset;
+	}
+
+	return fdt_path_offset(blob, path);
+}
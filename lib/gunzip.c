@@ -82,6 +82,72 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+int gunzip_chunked(void *dst, int dstlen, unsigned char *src,
+		   unsigned long srclen, unsigned long chunk,
+		   int (*func)(void *priv, const void *buf, unsigned long len),
+		   void *priv, unsigned long *lenp)
+{
+	unsigned long pos, end, start;
+	int offset, done = 0;
+	z_stream s;
+	int err = 0;
+	int r;
+
+	offset = gzip_parse_header(src, srclen);
+	if (offset < 0)
+		return offset;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	s.next_out = dst;
+	s.avail_out = dstlen;
+
+	for (pos = 0; pos < srclen; pos = end) {
+		end = min(pos + chunk, srclen);
+
+		/* Let the caller see the whole input, header and trailer too */
+		if (func && func(priv, src + pos, end - pos)) {
+			err = -1;
+			break;
+		}
+		WATCHDOG_RESET();
+
+		start = max(pos, (unsigned long)offset);
+		if (done || start >= end)
+			continue;
+
+		s.next_in = src + start;
+		s.avail_in = end - start;
+		r = inflate(&s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			done = 1;
+		} else if (r != Z_OK) {
+			printf("Error: inflate() returned %d\n", r);
+			err = -1;
+			break;
+		} else if (s.avail_in) {
+			/* Input is only left over once the output is full */
+			puts("Error: gunzip output buffer too small\n");
+			err = -1;
+			break;
+		}
+	}
+	if (!err && !done) {
+		puts("Error: gunzip out of data\n");
+		err = -1;
+	}
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+
+	return err;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
@@ -47,8 +47,10 @@
 
 #include <env_callback.h>
 #include <env_flags.h>
+#include <env_index.h>
 #include <search.h>
 #include <slre.h>
+#include <u-boot/crc.h>
 
 /*
  * [Aho,Sethi,Ullman] Compilers: Principles, Techniques and Tools, 1986
@@ -61,14 +63,24 @@
  * which describes the current status.
  */
 
+/*
+ * The entries themselves are allocated separately, so that they stay where
+ * they are when the table grows.
+ */
 struct env_entry_node {
 	int used;
-	struct env_entry entry;
+	struct env_entry *entry;
 };
 
+/* Number of slots of the old table moved by each call while growing */
+#define HTAB_REHASH_STEP	16
 
 static void _hdelete(const char *key, struct hsearch_data *htab,
 		     struct env_entry *ep, int idx);
+static unsigned int htab_lookup(struct env_entry_node *table,
+				unsigned int size, const char *key, int hval,
+				unsigned int *freep);
+static void htab_index_free(struct hsearch_data *htab);
 
 /*
  * hcreate()
@@ -92,6 +104,16 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Change nel to the first prime number not smaller as nel. */
+static unsigned int next_prime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -113,13 +135,21 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table != NULL)
 		return 0;
 
-	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = next_prime(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
+	htab->old_table = NULL;
+	htab->entries = NULL;
+	htab->nentries = 0;
+	htab->nsorted = 0;
+	htab->ndead = 0;
+	htab->max_entries = 0;
+	htab->index = NULL;
+	htab->index_list = NULL;
+	htab->index_count = 0;
+	htab->index_used = NULL;
+	htab->index_depth = 0;
+	htab->index_done = false;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
@@ -151,21 +181,309 @@ void hdestroy_r(struct hsearch_data *htab)
 		return;
 	}
 
-	/* free used memory */
-	for (i = 1; i <= htab->size; ++i) {
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
+	/* free used memory; the list holds deleted entries too */
+	for (i = 0; i < htab->nentries; ++i) {
+		struct env_entry *ep = htab->entries[i];
 
-			free((void *)ep->key);
-			free(ep->data);
-		}
+		free((void *)ep->key);
+		free(ep->data);
+		free(ep);
 	}
+	free(htab->entries);
+	free(htab->old_table);
 	free(htab->table);
+	htab_index_free(htab);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->old_table = NULL;
+	htab->entries = NULL;
+	htab->nentries = 0;
+	htab->max_entries = 0;
+}
+
+/*
+ * Besides the table, all entries are kept in a list which owns them and
+ * which hexport_r() keeps sorted by key. New entries are added at the end,
+ * so that only these need to be sorted on the next export. Deleted entries
+ * stay in the list, with their key set to NULL, until it is next cleaned
+ * up.
+ */
+static int htab_list_add(struct hsearch_data *htab, struct env_entry *ep)
+{
+	struct env_entry *last;
+
+	if (htab->nentries == htab->max_entries) {
+		unsigned int max = htab->max_entries ? htab->max_entries * 2 :
+			htab->size;
+		struct env_entry **entries;
+
+		entries = realloc(htab->entries, max * sizeof(*entries));
+		if (!entries)
+			return -ENOMEM;
+		htab->entries = entries;
+		htab->max_entries = max;
+	}
+
+	/* Entries added in order, e.g. by an import, need no sorting */
+	if (htab->nsorted == htab->nentries) {
+		last = htab->nentries ? htab->entries[htab->nentries - 1] :
+			NULL;
+		if (!last || (last->key && strcmp(last->key, ep->key) < 0))
+			htab->nsorted++;
+	}
+	htab->entries[htab->nentries++] = ep;
+
+	return 0;
+}
+
+/* Free the deleted entries in the list, keeping the others in order */
+static void htab_list_compact(struct hsearch_data *htab)
+{
+	unsigned int i, n, nsorted;
+
+	for (i = 0, n = 0, nsorted = 0; i < htab->nentries; ++i) {
+		struct env_entry *ep = htab->entries[i];
+
+		if (!ep->key) {
+			free(ep);
+			continue;
+		}
+		if (i < htab->nsorted)
+			nsorted++;
+		htab->entries[n++] = ep;
+	}
+	htab->nentries = n;
+	htab->nsorted = nsorted;
+	htab->ndead = 0;
+}
+
+/* Move an entry from the old table into the current one */
+static unsigned int htab_move(struct hsearch_data *htab,
+			      struct env_entry_node *node)
+{
+	unsigned int idx;
+
+	/* The key is not in the current table, so this finds a free slot */
+	htab_lookup(htab->table, htab->size, node->entry->key, node->used,
+		    &idx);
+	if (htab->table[idx].used == USED_DELETED)
+		--htab->deleted;
+	htab->table[idx] = *node;
+
+	/* Keep the chains of the other entries in the old table intact */
+	node->used = USED_DELETED;
+	node->entry = NULL;
+
+	return idx;
+}
+
+/*
+ * Move up to @count slots of the old table into the current one, freeing
+ * the old table once it is empty
+ */
+static void htab_rehash(struct hsearch_data *htab, unsigned int count)
+{
+	while (htab->old_table && count--) {
+		struct env_entry_node *node = &htab->old_table[htab->old_pos];
+
+		if (node->used > 0)
+			htab_move(htab, node);
+		if (++htab->old_pos > htab->old_size) {
+			free(htab->old_table);
+			htab->old_table = NULL;
+		}
+	}
+}
+
+/*
+ * Switch to a larger table once the current one is three quarters full,
+ * or a clean one of the same size if the slots are mostly taken up by
+ * deleted entries. The entries are moved over a few at a time by later
+ * calls, so that no single call has to rehash the whole table.
+ */
+static int htab_grow(struct hsearch_data *htab)
+{
+	struct env_entry_node *table;
+	unsigned int size;
+
+	/* Finish with the previous table first */
+	htab_rehash(htab, htab->old_size);
+
+	size = htab->size;
+	if (htab->filled * 2 >= size)
+		size = next_prime(size * 2);
+	table = calloc(size + 1, sizeof(*table));
+	if (!table)
+		return -ENOMEM;
+	debug("hsearch: growing table from %d to %d\n", htab->size, size);
+
+	htab->old_table = htab->table;
+	htab->old_size = htab->size;
+	htab->old_pos = 1;
+	htab->table = table;
+	htab->size = size;
+	htab->deleted = 0;
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+/*
+ * The variables of an indexed environment are only entered into the table
+ * when they are first looked up, as if they had been imported then. From
+ * that point on the table has the say, so that a variable which is changed
+ * or deleted is not looked up in the index again.
+ *
+ * Entering a variable can run callbacks which enter the whole index, such as
+ * on_flags() when ".flags" is entered. The entry being entered points into
+ * the index list, so the index is only dropped once no entry is in progress.
+ */
+
+/* Compare a key with the name of entry @i of the index, like strcmp() */
+static int htab_index_cmp(struct hsearch_data *htab, const char *key,
+			  unsigned int i)
+{
+	const char *name = htab->index_list + htab->index[i];
+	unsigned char c1, c2;
+
+	do {
+		c1 = *key++;
+		c2 = *name++;
+		if (c2 == '=')
+			c2 = '\0';
+	} while (c1 && c1 == c2);
+
+	return c1 - c2;
+}
+
+/* Return the first entry of the index whose name is not below @key */
+static unsigned int htab_index_search(struct hsearch_data *htab,
+				      const char *key)
+{
+	unsigned int lo = 0, hi = htab->index_count;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (htab_index_cmp(htab, key, mid) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Enter entry @i of the index into the table, unless it has been looked up
+ * before. Return 1 if it has been looked up now, whether or not it could be
+ * entered, else 0.
+ */
+static int htab_index_enter(struct hsearch_data *htab, unsigned int i)
+{
+	char *name = htab->index_list + htab->index[i];
+	char *value = strchr(name, '=');
+	struct env_entry e, *rv;
+	char *s, *d;
+
+	if (htab->index_used[i / 8] & (1 << (i % 8)))
+		return 0;
+	htab->index_used[i / 8] |= 1 << (i % 8);
+
+	if (!value || !value[1])
+		return 1;
+
+	/*
+	 * The entry is not looked at again, so split it in place, removing
+	 * the escapes from the value as himport_r() does
+	 */
+	*value++ = '\0';
+	for (s = value, d = value; *s; ++s) {
+		if (*s == '\\' && s[1])
+			++s;
+		*d++ = *s;
+	}
+	*d = '\0';
+
+	memset(&e, 0, sizeof(e));
+	e.key = name;
+	e.data = value;
+	htab->index_depth++;
+	hsearch_r(e, ENV_ENTER, &rv, htab, htab->index_flag);
+	if (!rv)
+		printf("himport_index_r: can't insert \"%s=%s\" into hash table\n",
+		       name, value);
+	if (!--htab->index_depth && htab->index_done)
+		htab_index_free(htab);
+
+	return 1;
+}
+
+/* Enter variable @key from the index, returning 1 if it was looked up */
+static int htab_index_load(struct hsearch_data *htab, const char *key)
+{
+	unsigned int i;
+
+	if (!htab->index_count)
+		return 0;
+
+	i = htab_index_search(htab, key);
+	if (i == htab->index_count || htab_index_cmp(htab, key, i))
+		return 0;
+
+	return htab_index_enter(htab, i);
+}
+
+/* Enter all variables of the index whose name starts with @prefix */
+static void htab_index_load_prefix(struct hsearch_data *htab,
+				   const char *prefix)
+{
+	size_t len = strlen(prefix);
+	unsigned int i;
+
+	/* The index goes away if a callback loads all of it meanwhile */
+	for (i = htab_index_search(htab, prefix); i < htab->index_count; ++i) {
+		if (strncmp(htab->index_list + htab->index[i], prefix, len))
+			break;
+		htab_index_enter(htab, i);
+	}
+
+	/* Once all variables have been entered, the index is not needed */
+	if (!len) {
+		if (htab->index_depth)
+			htab->index_done = true;
+		else
+			htab_index_free(htab);
+	}
 }
 
+static void htab_index_free(struct hsearch_data *htab)
+{
+	free(htab->index);
+	free(htab->index_used);
+	htab->index = NULL;
+	htab->index_list = NULL;
+	htab->index_count = 0;
+	htab->index_used = NULL;
+	htab->index_done = false;
+}
+#else
+static inline int htab_index_load(struct hsearch_data *htab, const char *key)
+{
+	return 0;
+}
+
+static inline void htab_index_load_prefix(struct hsearch_data *htab,
+					  const char *prefix)
+{
+}
+
+static void htab_index_free(struct hsearch_data *htab)
+{
+}
+#endif
+
 /*
  * hsearch()
  */
@@ -173,18 +491,22 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. The strings are hashed with FNV-1a, which is
+ * fast and spreads similar names (e.g. "var1", "var2", ...) well over the
+ * table.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
+ * special. This index will never be used because we store the hash value
+ * in the field used where zero means not used. Every other value
  * means used. The used field can be used as a first fast comparison for
  * equality of the stored and the parameter value. This helps to prevent
  * unnecessary expensive calls of strcmp.
  *
+ * When the table fills up, a larger one is allocated. Until all entries
+ * have been moved over, a few on each call, entries are looked up in both
+ * tables; an entry found in the old one is moved over straight away.
+ *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
  *
@@ -209,11 +531,17 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
+	if (!last_idx)
+		htab_index_load_prefix(htab, match);
+
+	/* Indexes must stay valid from one call to the next */
+	htab_rehash(htab, htab->old_size);
+
 	for (idx = last_idx + 1; idx < htab->size; ++idx) {
 		if (htab->table[idx].used <= 0)
 			continue;
-		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
-			*retval = &htab->table[idx].entry;
+		if (!strncmp(match, htab->table[idx].entry->key, key_len)) {
+			*retval = htab->table[idx].entry;
 			return idx;
 		}
 	}
@@ -234,144 +562,183 @@ do_callback(const struct env_entry *e, const char *name, const char *value,
 	return 0;
 }
 
-/*
- * Compare an existing entry with the desired key, and overwrite if the action
- * is ENV_ENTER.  This is simply a helper function for hsearch_r().
- */
-static inline int _compare_and_overwrite_entry(struct env_entry item,
-		enum env_action action, struct env_entry **retval,
-		struct hsearch_data *htab, int flag, unsigned int hval,
-		unsigned int idx)
-{
-	if (htab->table[idx].used == hval
-	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
-		/* Overwrite existing value? */
-		if (action == ENV_ENTER && item.data) {
-			/* check for permission */
-			if (htab->change_ok != NULL && htab->change_ok(
-			    &htab->table[idx].entry, item.data,
-			    env_op_overwrite, flag)) {
-				debug("change_ok() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EPERM);
-				*retval = NULL;
-				return 0;
-			}
-
-			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
-					item.data, env_op_overwrite, flag)) {
-				debug("callback() rejected setting variable "
-					"%s, skipping it!\n", item.key);
-				__set_errno(EINVAL);
-				*retval = NULL;
-				return 0;
-			}
+/* Compute the value stored in the field used for a key; never <= 0 */
+static int hash_key(const char *key)
+{
+	unsigned int hval = 2166136261U;
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
-				__set_errno(ENOMEM);
-				*retval = NULL;
-				return 0;
-			}
-		}
-		/* return found entry */
-		*retval = &htab->table[idx].entry;
-		return idx;
+	while (*key) {
+		hval ^= (unsigned char)*key++;
+		hval *= 16777619;
 	}
-	/* keep searching */
-	return -1;
+
+	return (hval >> 1) | 1;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+/*
+ * Look up a key in one table. If it is not there, also return the slot a
+ * new entry would go into, i.e. the first deleted one on the way or else
+ * the free one where the search ended, or 0 if the table is full.
+ */
+static unsigned int htab_lookup(struct env_entry_node *table,
+				unsigned int size, const char *key, int hval,
+				unsigned int *freep)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
-
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
+	unsigned int first, hval2, idx;
+	unsigned int free_idx = 0;
 
 	/*
 	 * First hash function:
 	 * simply take the modul but prevent zero.
 	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	first = (unsigned int)hval % size;
+	if (first == 0)
+		++first;
 
-	/* The first index tried. */
-	idx = hval;
+	/*
+	 * Second hash function:
+	 * as suggested in [Knuth]
+	 */
+	hval2 = 1 + first % (size - 2);
 
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
+	idx = first;
+	do {
+		struct env_entry_node *node = &table[idx];
 
-		if (htab->table[idx].used == USED_DELETED
-		    && !first_deleted)
-			first_deleted = idx;
+		if (node->used == USED_FREE) {
+			if (!free_idx)
+				free_idx = idx;
+			break;
+		}
+		if (node->used == USED_DELETED) {
+			if (!free_idx)
+				free_idx = idx;
+		} else if (node->used == hval &&
+			   strcmp(key, node->entry->key) == 0) {
+			return idx;
+		}
 
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
-		if (ret != -1)
-			return ret;
+		/*
+		 * Because SIZE is prime this guarantees to
+		 * step through all available indices.
+		 */
+		if (idx <= hval2)
+			idx = size + idx - hval2;
+		else
+			idx -= hval2;
 
 		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
+		 * If we visited all entries leave the loop
+		 * unsuccessfully.
 		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			if (htab->table[idx].used == USED_DELETED
-			    && !first_deleted)
-				first_deleted = idx;
-
-			/* If entry is found use it. */
-			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
-			if (ret != -1)
-				return ret;
+	} while (idx != first);
+
+	if (freep)
+		*freep = free_idx;
+
+	return 0;
+}
+
+/*
+ * Look up a key in the current table and then in the old one, if any.
+ * An entry found in the old table is moved into the current one.
+ */
+static unsigned int htab_find(struct hsearch_data *htab, const char *key,
+			      int hval, unsigned int *freep)
+{
+	unsigned int idx;
+
+	idx = htab_lookup(htab->table, htab->size, key, hval, freep);
+	if (idx || !htab->old_table)
+		return idx;
+
+	idx = htab_lookup(htab->old_table, htab->old_size, key, hval, NULL);
+	if (!idx)
+		return 0;
+
+	return htab_move(htab, &htab->old_table[idx]);
+}
+
+/*
+ * Overwrite an existing entry if the action is ENV_ENTER.  This is simply a
+ * helper function for hsearch_r().
+ */
+static int _overwrite_entry(struct env_entry item, enum env_action action,
+			    struct env_entry **retval,
+			    struct hsearch_data *htab, int flag,
+			    unsigned int idx)
+{
+	struct env_entry *ep = htab->table[idx].entry;
+
+	/* Overwrite existing value? */
+	if (action == ENV_ENTER && item.data) {
+		/* check for permission */
+		if (htab->change_ok != NULL && htab->change_ok(
+		    ep, item.data, env_op_overwrite, flag)) {
+			debug("change_ok() rejected setting variable "
+				"%s, skipping it!\n", item.key);
+			__set_errno(EPERM);
+			*retval = NULL;
+			return 0;
+		}
+
+		/* If there is a callback, call it */
+		if (do_callback(ep, item.key, item.data, env_op_overwrite,
+				flag)) {
+			debug("callback() rejected setting variable "
+				"%s, skipping it!\n", item.key);
+			__set_errno(EINVAL);
+			*retval = NULL;
+			return 0;
+		}
+
+		free(ep->data);
+		ep->data = strdup(item.data);
+		if (!ep->data) {
+			__set_errno(ENOMEM);
+			*retval = NULL;
+			return 0;
 		}
-		while (htab->table[idx].used != USED_FREE);
 	}
+	/* return found entry */
+	*retval = ep;
+	return idx;
+}
+
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	struct env_entry_node *node;
+	struct env_entry *ep;
+	unsigned int idx, free_idx;
+	int hval;
+
+	hval = hash_key(item.key);
+
+	/* Move some more entries over if the table is growing */
+	htab_rehash(htab, HTAB_REHASH_STEP);
+
+	idx = htab_find(htab, item.key, hval, &free_idx);
+	if (idx)
+		return _overwrite_entry(item, action, retval, htab, flag, idx);
+
+	/* The variable may not have been entered from the index yet */
+	if (htab_index_load(htab, item.key))
+		return hsearch_r(item, action, retval, htab, flag);
 
 	/* An empty bucket has been found. */
 	if (action == ENV_ENTER) {
+		/* Keep the table at most three quarters full */
+		if ((htab->filled + htab->deleted + 1) * 4 > htab->size * 3 &&
+		    !htab_grow(htab))
+			htab_lookup(htab->table, htab->size, item.key, hval,
+				    &free_idx);
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
 		 */
-		if (htab->filled == htab->size) {
+		if (!free_idx) {
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
@@ -381,56 +748,68 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
-			idx = first_deleted;
-
-		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
-		if (!htab->table[idx].entry.key ||
-		    !htab->table[idx].entry.data) {
+		ep = calloc(1, sizeof(*ep));
+		if (ep) {
+			ep->key = strdup(item.key);
+			ep->data = strdup(item.data);
+		}
+		if (!ep || !ep->key || !ep->data || htab_list_add(htab, ep)) {
+			if (ep) {
+				free((void *)ep->key);
+				free(ep->data);
+			}
+			free(ep);
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
 		}
 
+		node = &htab->table[free_idx];
+		if (node->used == USED_DELETED)
+			--htab->deleted;
+		node->used = hval;
+		node->entry = ep;
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
-		env_callback_init(&htab->table[idx].entry);
+		env_callback_init(ep);
 		/* Also look for flags */
-		env_flags_init(&htab->table[idx].entry);
+		env_flags_init(ep);
 
 		/* check for permission */
 		if (htab->change_ok != NULL && htab->change_ok(
-		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
+		    ep, item.data, env_op_create, flag)) {
 			debug("change_ok() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
 			__set_errno(EPERM);
-			*retval = NULL;
-			return 0;
+			goto err_delete;
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(ep, item.key, item.data, env_op_create,
+				flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
-			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
 			__set_errno(EINVAL);
-			*retval = NULL;
-			return 0;
+			goto err_delete;
 		}
 
 		/* return new entry */
-		*retval = &htab->table[idx].entry;
+		*retval = ep;
 		return 1;
 	}
 
 	__set_errno(ESRCH);
 	*retval = NULL;
 	return 0;
+
+err_delete:
+	/* The callbacks may have changed the table, so look the entry up */
+	idx = htab_find(htab, item.key, hval, NULL);
+	if (idx)
+		_hdelete(item.key, htab, ep, idx);
+	*retval = NULL;
+	return 0;
 }
 
 
@@ -451,10 +830,18 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 	debug("hdelete: DELETING key \"%s\"\n", key);
 	free((void *)ep->key);
 	free(ep->data);
+	ep->key = NULL;
+	ep->data = NULL;
 	ep->flags = 0;
 	htab->table[idx].used = USED_DELETED;
+	htab->table[idx].entry = NULL;
+	++htab->deleted;
 
 	--htab->filled;
+
+	/* Clean up the list once it is mostly deleted entries */
+	if (++htab->ndead * 2 > htab->nentries)
+		htab_list_compact(htab);
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -482,15 +869,17 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
-			env_op_delete, flag)) {
+	if (do_callback(ep, key, NULL, env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EINVAL);
 		return 0;
 	}
 
-	_hdelete(key, htab, ep, idx);
+	/* The callbacks may have changed the table, so look the entry up */
+	idx = htab_find(htab, key, hash_key(key), NULL);
+	if (idx)
+		_hdelete(key, htab, ep, idx);
 
 	return 1;
 }
@@ -546,6 +935,48 @@ static int cmpkey(const void *p1, const void *p2)
 	return (strcmp(e1->key, e2->key));
 }
 
+/*
+ * Sort the list of entries by key. Only the entries added since the last
+ * export need sorting, after which they are merged with the others in a
+ * single pass. As the environment is imported in sorted order, there is
+ * usually little or nothing to do.
+ */
+static int htab_list_sort(struct hsearch_data *htab)
+{
+	struct env_entry **list, **tail, **merged;
+	unsigned int nsorted, ntail, i, j, k;
+
+	if (htab->ndead)
+		htab_list_compact(htab);
+	list = htab->entries;
+	nsorted = htab->nsorted;
+	tail = list + nsorted;
+	ntail = htab->nentries - nsorted;
+	if (!ntail)
+		return 0;
+
+	qsort(tail, ntail, sizeof(*tail), cmpkey);
+
+	/* Merge, unless the new entries all go after the others */
+	if (nsorted && cmpkey(&list[nsorted - 1], &tail[0]) > 0) {
+		merged = malloc(htab->max_entries * sizeof(*merged));
+		if (!merged)
+			return -ENOMEM;
+		for (i = 0, j = 0, k = 0; k < htab->nentries; ++k) {
+			if (j == ntail ||
+			    (i < nsorted && cmpkey(&list[i], &tail[j]) < 0))
+				merged[k] = list[i++];
+			else
+				merged[k] = tail[j++];
+		}
+		free(list);
+		htab->entries = merged;
+	}
+	htab->nsorted = htab->nentries;
+
+	return 0;
+}
+
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -608,7 +1039,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char *const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -619,63 +1050,63 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		return (-1);
 	}
 
+	htab_index_load_prefix(htab, "");
+
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
+
+	/* Sort list by keys */
+	if (htab_list_sort(htab)) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+	list = malloc((htab->nentries + 1) * sizeof(*list));
+	if (list == NULL) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+
 	/*
 	 * Pass 1:
 	 * search used entries,
 	 * save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	for (i = 0, n = 0, totlen = 0; i < htab->nentries; ++i) {
+		struct env_entry *ep = htab->entries[i];
+		int found = match_entry(ep, flag, argc, argv);
 
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
+		if ((argc > 0) && (found == 0))
+			continue;
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+		if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			continue;
 
-			list[n++] = ep;
+		list[n++] = ep;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %lu, but need %lu\n",
 			       (ulong)size, (ulong)totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -692,6 +1123,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -718,9 +1150,46 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
+
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+/*
+ * As the list is sorted already, the entries only need to be found. The
+ * index goes at the end of the buffer, see env_index.h, so the list must
+ * be followed by enough padding.
+ */
+int hexport_index(char *res, size_t size)
+{
+	struct env_index_tail tail;
+	size_t count;
+	char *index, *p;
+	uint32_t off;
+
+	for (p = res, count = 0; *p; p += strlen(p) + 1)
+		++count;
+	tail.list_size = p - res + 1;
+
+	if (tail.list_size + count * sizeof(off) + sizeof(tail) > size)
+		return -ENOSPC;
+
+	tail.list_crc = crc32(0, (unsigned char *)res, tail.list_size);
+	tail.count = count;
+	tail.magic = ENV_INDEX_MAGIC;
+
+	index = res + size - sizeof(tail) - count * sizeof(off);
+	for (p = res; *p; p += strlen(p) + 1) {
+		off = p - res;
+		memcpy(index, &off, sizeof(off));
+		index += sizeof(off);
+	}
+	memcpy(index, &tail, sizeof(tail));
+
+	return 0;
+}
+#endif
 #endif
 
 
@@ -845,7 +1314,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. As the table
+	 * grows when it fills up, this is only its initial size.
 	 */
 
 	if (!htab->table) {
@@ -980,6 +1450,86 @@ end:
 	return 1;		/* everything OK */
 }
 
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+/*
+ * Import an environment with an index (see env_index.h).
+ *
+ * Unlike himport_r(), this only takes a copy of the list and its index:
+ * the variables are entered into the hash table as they are looked up, so
+ * that the cost does not grow with the size of the environment. Anything
+ * that lists the variables, like hexport_r(), enters all of them first.
+ */
+int himport_index_r(struct hsearch_data *htab, const char *env, size_t size,
+		    int flag)
+{
+	struct env_index_tail tail;
+	unsigned char *used;
+	uint32_t *index;
+	size_t index_size;
+	char *list;
+	unsigned int i;
+
+	/* Test for correct arguments.  */
+	if (htab == NULL || size < sizeof(tail))
+		goto err_inval;
+
+	memcpy(&tail, env + size - sizeof(tail), sizeof(tail));
+	if (tail.magic != ENV_INDEX_MAGIC || !tail.list_size ||
+	    tail.list_size > size - sizeof(tail) ||
+	    tail.count > (size - sizeof(tail) - tail.list_size) /
+			 sizeof(*index))
+		goto err_inval;
+
+	/* Keep the index first, as it may not be aligned in the data */
+	index_size = tail.count * sizeof(*index);
+	index = malloc(index_size + tail.list_size);
+	used = calloc(tail.count / 8 + 1, 1);
+	if (!index || !used) {
+		free(index);
+		free(used);
+		__set_errno(ENOMEM);
+		return 0;
+	}
+	memcpy(index, env + size - sizeof(tail) - index_size, index_size);
+	list = (char *)index + index_size;
+	memcpy(list, env, tail.list_size);
+
+	/* The index must belong to this list and point into it */
+	if (crc32(0, (unsigned char *)list, tail.list_size) != tail.list_crc ||
+	    list[tail.list_size - 1])
+		goto err_free;
+	for (i = 0; i < tail.count; i++) {
+		if (index[i] >= tail.list_size - 1)
+			goto err_free;
+	}
+
+	if (htab->table)
+		hdestroy_r(htab);
+	if (hcreate_r(CONFIG_ENV_MIN_ENTRIES, htab) == 0) {
+		free(index);
+		free(used);
+		return 0;
+	}
+
+	htab->index = index;
+	htab->index_list = list;
+	htab->index_count = tail.count;
+	htab->index_used = used;
+	htab->index_flag = flag;
+	debug("INDEX: %u variables\n", tail.count);
+
+	return 1;
+
+err_free:
+	debug("INDEX: does not match the environment\n");
+	free(index);
+	free(used);
+err_inval:
+	__set_errno(EINVAL);
+	return 0;
+}
+#endif
+
 /*
  * hwalk_r()
  */
@@ -993,9 +1543,12 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 	int i;
 	int retval;
 
+	htab_index_load_prefix(htab, "");
+	htab_rehash(htab, htab->old_size);
+
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
-			retval = callback(&htab->table[i].entry);
+			retval = callback(htab->table[i].entry);
 			if (retval)
 				return retval;
 		}
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running compute jobs on secondary CPUs
+ *
+ * The jobs of a batch are handed out one at a time: each CPU, the boot CPU
+ * included, takes the next job which nobody has taken yet until there are
+ * none left. Secondary CPUs are only started for the batch and are stopped
+ * again once it is done.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <log.h>
+#include <mp_job.h>
+#include <time.h>
+#include <linux/kernel.h>
+
+/* How long to wait for the secondary CPUs to finish their last jobs */
+#define MP_JOB_TIMEOUT_MS	30000
+
+static struct mp_job_batch {
+	struct mp_job *jobs;
+	int count;
+	int next;		/* next job to hand out */
+	int done;		/* number of jobs which have finished */
+} mp_batch;
+
+__weak int arch_mp_job_cpus(void)
+{
+	return 1;
+}
+
+__weak int arch_mp_job_start(int cpu, void (*entry)(void))
+{
+	return -ENOSYS;
+}
+
+__weak int arch_mp_job_stop(int cpu)
+{
+	return 0;
+}
+
+int mp_job_cpus(void)
+{
+	return min(arch_mp_job_cpus(), CONFIG_MP_JOBS_CPUS);
+}
+
+/* Run jobs from the current batch until there are none left */
+static void mp_job_worker(void)
+{
+	struct mp_job *job;
+	int i;
+
+	while (1) {
+		i = __atomic_fetch_add(&mp_batch.next, 1, __ATOMIC_ACQ_REL);
+		if (i >= mp_batch.count)
+			break;
+		job = &mp_batch.jobs[i];
+		job->ret = job->func(job->arg);
+		__atomic_fetch_add(&mp_batch.done, 1, __ATOMIC_RELEASE);
+	}
+}
+
+int mp_run_jobs(struct mp_job *jobs, int count)
+{
+	int cpus, cpu, started;
+	int ret = 0;
+	int done, i;
+	ulong start;
+
+	mp_batch.jobs = jobs;
+	mp_batch.count = count;
+	mp_batch.next = 0;
+	mp_batch.done = 0;
+
+	/* Starting a CPU is a barrier, so it sees the batch set up above */
+	cpus = min(mp_job_cpus(), count);
+	for (started = 0, cpu = 1; cpu < cpus; cpu++, started++) {
+		ret = arch_mp_job_start(cpu, mp_job_worker);
+		if (ret) {
+			log_debug("Cannot start CPU %d (err=%d)\n", cpu, ret);
+			break;
+		}
+	}
+	log_debug("Running %d jobs on %d CPUs\n", count, started + 1);
+
+	mp_job_worker();
+
+	/*
+	 * There are no jobs left to hand out, but the secondary CPUs may still
+	 * be running the last ones they took. Only stop them once all are done.
+	 */
+	ret = 0;
+	start = get_timer(0);
+	while ((done = __atomic_load_n(&mp_batch.done, __ATOMIC_ACQUIRE)) !=
+	       count) {
+		if (get_timer(start) > MP_JOB_TIMEOUT_MS) {
+			log_err("Only %d of %d jobs finished\n", done, count);
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	for (cpu = 1; cpu <= started; cpu++) {
+		i = arch_mp_job_stop(cpu);
+		if (!i)
+			continue;
+		log_err("CPU %d did not stop (err=%d)\n", cpu, i);
+		/* It may still be using the jobs, which belong to the caller */
+		if (ret)
+			panic("Secondary CPU %d is stuck in a job\n", cpu);
+		ret = i;
+	}
+	if (ret)
+		return ret;
+
+	for (i = 0; i < count; i++) {
+		if (jobs[i].ret)
+			return jobs[i].ret;
+	}
+
+	return 0;
+}
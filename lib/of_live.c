@@ -16,6 +16,9 @@
 #include <dm/of_access.h>
 #include <linux/err.h>
 
+/* Live tree generated by dtoc, with the root node first */
+extern struct device_node dt_live_nodes[];
+
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
 {
@@ -295,6 +298,10 @@ static int unflatten_device_tree(const void *blob,
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem) {
+		debug("Cannot allocate %lx bytes for live tree\n", size);
+		return -ENOMEM;
+	}
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
@@ -320,10 +327,14 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 	int ret;
 
 	debug("%s: start\n", __func__);
-	ret = unflatten_device_tree(fdt_blob, rootp);
-	if (ret) {
-		debug("Failed to create live tree: err=%d\n", ret);
-		return ret;
+	if (CONFIG_IS_ENABLED(OF_LIVE_PREBUILT)) {
+		*rootp = dt_live_nodes;
+	} else {
+		ret = unflatten_device_tree(fdt_blob, rootp);
+		if (ret) {
+			debug("Failed to create live tree: err=%d\n", ret);
+			return ret;
+		}
 	}
 	ret = of_alias_scan();
 	if (ret) {
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompression of Zstandard data
+ */
+
+#include <common.h>
+#include <log.h>
+#include <malloc.h>
+#include <u-boot/zstd.h>
+#include <linux/errno.h>
+
+static int zstd_errno(size_t ret)
+{
+	switch (ZSTD_getErrorCode(ret)) {
+	case ZSTD_error_memory_allocation:
+		return -ENOMEM;
+	case ZSTD_error_dstSize_tooSmall:
+		return -ENOBUFS;
+	default:
+		return -EINVAL;
+	}
+}
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	size_t wsize = ZSTD_DCtxWorkspaceBound();
+	ZSTD_DCtx *dctx;
+	void *workspace;
+	size_t ret;
+
+	workspace = malloc(wsize);
+	if (!workspace)
+		return -ENOMEM;
+
+	dctx = ZSTD_initDCtx(workspace, wsize);
+	if (!dctx) {
+		free(workspace);
+		return -EINVAL;
+	}
+
+	ret = ZSTD_decompressDCtx(dctx, dst, *dstn, src, srcn);
+	free(workspace);
+	if (ZSTD_isError(ret)) {
+		debug("%s: Error %d\n", __func__, ZSTD_getErrorCode(ret));
+		return zstd_errno(ret);
+	}
+	*dstn = ret;
+
+	return 0;
+}
@@ -399,6 +399,15 @@ void net_init(void)
 	net_init_loop();
 }
 
+/* Names of the protocols, for the bootstage timeline */
+static const char *const net_proto_name[] = {
+	[BOOTP] = "bootp", [RARP] = "rarp", [ARP] = "arp",
+	[TFTPGET] = "tftp", [DHCP] = "dhcp", [PING] = "ping",
+	[DNS] = "dns", [NFS] = "nfs", [CDP] = "cdp", [NETCONS] = "netcons",
+	[SNTP] = "sntp", [TFTPSRV] = "tftpsrv", [TFTPPUT] = "tftpput",
+	[LINKLOCAL] = "linklocal", [FASTBOOT] = "fastboot", [WOL] = "wol",
+};
+
 /**********************************************************************/
 /*
  *	Main network processing loop.
@@ -408,6 +417,7 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	ulong start_us = bootstage_span_start();
 
 	net_restarted = 0;
 	net_dev_exists = 0;
@@ -675,6 +685,8 @@ done:
 	net_set_icmp_handler(NULL);
 #endif
 	net_set_state(prev_net_state);
+	bootstage_span(BOOTSTAGE_SPAN_NET, net_proto_name[protocol], start_us,
+		       ret > 0 ? ret : 0);
 
 #if defined(CONFIG_CMD_PCAP)
 	if (pcap_active())
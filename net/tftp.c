@@ -80,8 +80,16 @@ static int	tftp_our_port;
 static int	timeout_count;
 /* packet sequence number */
 static ulong	tftp_cur_block;
-/* last packet sequence number received */
+/* last packet sequence number received in order */
 static ulong	tftp_prev_block;
+/* last packet sequence number acknowledged */
+static ulong	tftp_last_ack;
+/* last sequence number we asked to be retransmitted after */
+static long	tftp_last_nack;
+/* bit n set: block tftp_prev_block + 1 + n was received out of order */
+static u32	tftp_window_map;
+/* sequence number of the final (short) block, if received */
+static long	tftp_final_block;
 /* count of sequence number wraparounds */
 static ulong	tftp_block_wrap;
 /* memory offset due to wrapping */
@@ -119,6 +127,9 @@ static int	tftp_put_final_block_sent;
 /* sequence number is 16 bit */
 #define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
 
+/* largest window we can track out-of-order blocks for */
+#define TFTP_MAX_WINDOW_SIZE	32
+
 #define DEFAULT_NAME_LEN	(8 + 4 + 1)
 static char default_filename[DEFAULT_NAME_LEN];
 
@@ -138,6 +149,8 @@ static char tftp_filename[MAX_LEN];
 
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = CONFIG_TFTP_WINDOWSIZE;
 
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
@@ -196,6 +209,10 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 static void new_transfer(void)
 {
 	tftp_prev_block = 0;
+	tftp_last_ack = 0;
+	tftp_last_nack = -1;
+	tftp_window_map = 0;
+	tftp_final_block = -1;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
 #ifdef CONFIG_CMD_TFTPPUT
@@ -350,6 +367,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for a window of blocks per ack, only when reading */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -361,6 +382,7 @@ static void tftp_send(void)
 		s = (ushort *)pkt;
 		s[0] = htons(TFTP_ACK);
 		s[1] = htons(tftp_cur_block);
+		tftp_last_ack = tftp_cur_block;
 		pkt = (uchar *)(s + 2);
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
@@ -403,6 +425,75 @@ static void tftp_send(void)
 			    tftp_remote_port, tftp_our_port, len);
 }
 
+/**
+ * Handle a data block which may arrive out of order when a window is in use
+ *
+ * Blocks are stored straight away at their place in memory. The ones which
+ * arrive ahead of a missing block are remembered in tftp_window_map so that
+ * they can be skipped once the gap is filled. An ack is sent once a whole
+ * window has been received in sequence, for the final block, and once when
+ * the end of a window has been seen with a block still missing, so that the
+ * server starts sending again after the last block received in sequence.
+ *
+ * @param block	Sequence number of the block
+ * @param pkt	Block data
+ * @param len	Length of the block data
+ */
+static void tftp_data_block(ushort block, uchar *pkt, unsigned len)
+{
+	ushort ahead = block - (ushort)tftp_prev_block;
+	u32 bit;
+
+	if (!ahead || ahead > tftp_window_size) {
+		/* Same block again, or not one of ours; ignore it. */
+		return;
+	}
+	bit = 1U << (ahead - 1);
+	if (tftp_window_map & bit) {
+		/* Already received out of order */
+		return;
+	}
+
+	timeout_count_max = tftp_timeout_count_max;
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+
+	if (store_block(tftp_prev_block + ahead - 1, pkt, len)) {
+		eth_halt();
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	if (len < tftp_block_size)
+		tftp_final_block = block;
+
+	/* Move past all the blocks we now have in sequence */
+	tftp_window_map |= bit;
+	while (tftp_window_map & 1) {
+		tftp_window_map >>= 1;
+		tftp_cur_block = (ushort)(tftp_prev_block + 1);
+		update_block_number();
+		tftp_prev_block = tftp_cur_block;
+	}
+
+	if (tftp_final_block == tftp_prev_block) {
+		tftp_send();
+		tftp_complete();
+	} else if ((ushort)(tftp_prev_block - tftp_last_ack) >=
+		   tftp_window_size) {
+		/*
+		 *	Acknowledge the window just received, which will
+		 *	prompt the remote for the next one.
+		 */
+		tftp_send();
+	} else if (tftp_window_map && tftp_last_nack != tftp_prev_block &&
+		   ((ushort)(block - tftp_last_ack) >= tftp_window_size ||
+		    tftp_final_block != -1)) {
+		/* The end of the window is here but a block is missing */
+		debug("TFTP: block %lu missing\n", tftp_prev_block + 1);
+		tftp_last_nack = tftp_prev_block;
+		tftp_send();
+	}
+}
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 struct in_addr sip, unsigned src, uchar *pkt,
@@ -420,6 +511,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 {
 	__be16 proto;
 	__be16 *s;
+	ushort block;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -494,6 +586,17 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+				if (!tftp_window_size ||
+				    tftp_window_size > tftp_window_size_option)
+					tftp_window_size =
+						tftp_window_size_option;
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -516,12 +619,13 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
-		if (tftp_state == STATE_SEND_RRQ)
+		if (tftp_state == STATE_SEND_RRQ) {
 			debug("Server did not acknowledge timeout option!\n");
+			/* nor any window size, so blocks come one by one */
+			tftp_window_size = 1;
+		}
 
 		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
 		    tftp_state == STATE_RECV_WRQ) {
@@ -530,39 +634,18 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			tftp_remote_port = src;
 			new_transfer();
 
-			if (tftp_cur_block != 1) {	/* Assertion */
+			/* Assertion, block 1 may be lost within a window */
+			if (!block || block > tftp_window_size) {
 				puts("\nTFTP error: ");
-				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				printf("First block is not block 1 (%d)\n",
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
-			/* Same block again; ignore it. */
-			break;
-		}
-
-		tftp_prev_block = tftp_cur_block;
-		timeout_count_max = tftp_timeout_count_max;
-		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-
-		if (store_block(tftp_cur_block - 1, pkt + 2, len)) {
-			eth_halt();
-			net_set_state(NETLOOP_FAIL);
-			break;
-		}
-
-		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
-		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
-			tftp_complete();
+		tftp_data_block(block, pkt + 2, len);
 		break;
 
 	case TFTP_ERROR:
@@ -636,6 +719,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -657,8 +744,16 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	if (tftp_window_size_option < 1)
+		tftp_window_size_option = 1;
+	if (tftp_window_size_option > TFTP_MAX_WINDOW_SIZE) {
+		printf("TFTP window size (%d) too large, set max = %d\n",
+		       tftp_window_size_option, TFTP_MAX_WINDOW_SIZE);
+		tftp_window_size_option = TFTP_MAX_WINDOW_SIZE;
+	}
+
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -757,8 +852,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -789,8 +885,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
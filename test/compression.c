@@ -12,6 +12,7 @@
 #include <lz4.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
 
 #include <u-boot/zlib.h>
@@ -22,6 +23,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <u-boot/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -121,6 +123,23 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -19 /tmp/plain.txt -o /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -296,6 +315,40 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq_mem(plain, in, in_size);
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -440,6 +493,13 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -530,12 +590,78 @@ static int compression_test_bootm_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_lz4, 0);
 
+static int compression_test_bootm_zstd(struct unit_test_state *uts)
+{
+	return run_bootm_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_bootm_zstd, 0);
+
 static int compression_test_bootm_none(struct unit_test_state *uts)
 {
 	return run_bootm_test(uts, IH_COMP_NONE, compress_using_none);
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+#define BENCH_LOOPS	1000
+
+/**
+ * run_bench() - Time the decompression of the test text
+ *
+ * This prints the compression ratio and decompression speed, so that the
+ * algorithms can be compared on the same data. As the text is short, the
+ * speed includes the cost of setting up each decompression.
+ *
+ * @name:	Name of the algorithm
+ * @compress:	Our function to compress data
+ * @uncompress:	Our function to uncompress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_bench(struct unit_test_state *uts, const char *name,
+		     mutate_func compress, mutate_func uncompress)
+{
+	char comp_buf[TEST_BUFFER_SIZE], unc_buf[TEST_BUFFER_SIZE];
+	ulong comp_size = sizeof(comp_buf), unc_size, plain_size;
+	ulong start, us;
+	u64 rate;
+	int i;
+
+	plain_size = strlen(plain);
+	ut_assertok(compress(uts, (void *)plain, plain_size, comp_buf,
+			     comp_size, &comp_size));
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		ut_assertok(uncompress(uts, comp_buf, comp_size, unc_buf,
+				       sizeof(unc_buf), &unc_size));
+	}
+	us = max(timer_get_us() - start, 1UL);
+	ut_asserteq(plain_size, unc_size);
+	ut_asserteq_mem(plain, unc_buf, unc_size);
+
+	rate = (u64)plain_size * BENCH_LOOPS * 1000 / us;
+	printf("%8s %6lu %5lu%% %10llu KB/s\n", name, comp_size,
+	       comp_size * 100 / plain_size, rate);
+
+	return 0;
+}
+
+/* Compare the algorithms used for boot images on the same text */
+static int compression_test_bench(struct unit_test_state *uts)
+{
+	printf("%8s %6s %6s %15s\n", "", "size", "ratio", "decompress");
+	ut_assertok(run_bench(uts, "gzip", compress_using_gzip,
+			      uncompress_using_gzip));
+	ut_assertok(run_bench(uts, "lz4", compress_using_lz4,
+			      uncompress_using_lz4));
+	ut_assertok(run_bench(uts, "lzma", compress_using_lzma,
+			      uncompress_using_lzma));
+	ut_assertok(run_bench(uts, "zstd", compress_using_zstd,
+			      uncompress_using_zstd));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_bench, 0);
+
 int do_ut_compression(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -5,7 +5,10 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
+#include <os.h>
 #include <part.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -163,3 +166,141 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test the block cache lookup, read-ahead and invalidation */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	struct blk_desc *dev_desc;
+	char buf[1024], fill[1024];
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	blkcache_configure(8, 32, 16);
+
+	/* An isolated read is cached but does not trigger read-ahead */
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_asserteq(0, stats.readaheads);
+	ut_asserteq(1, stats.entries);
+
+	/* A sequential read that misses reads a whole window ahead */
+	ut_asserteq(1, blk_dread(dev_desc, 1, 1, buf));
+	ut_asserteq(2, blk_dread(dev_desc, 2, 2, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 16, 1, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 20, 1, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(2, stats.misses);
+	ut_asserteq(1, stats.readaheads);
+	ut_asserteq(3, stats.entries);
+
+	/* Entries are also found from the next hash granule */
+	memset(fill, '\0', sizeof(fill));
+	blkcache_fill(IF_TYPE_HOST, 7, 250, 8, 128, fill);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 7, 256, 2, 128, buf));
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 7, 256, 3, 128, buf));
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 8, 256, 2, 128, buf));
+
+	/* A write only drops the entries it overlaps */
+	blkcache_invalidate_range(IF_TYPE_HOST, 7, 240, 10);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 7, 250, 1, 128, buf));
+	blkcache_invalidate_range(IF_TYPE_HOST, 7, 257, 1);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 7, 250, 1, 128, buf));
+
+	blkcache_configure(8, 32, 32);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Test asynchronous transfers on a block device backed by a host file */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	const int blocks = 64, per_req = 8;
+	struct blk_req req[blocks / per_req];
+	struct blk_desc *desc;
+	int size = blocks * 512;
+	u8 *src, *buf;
+	int i;
+
+	src = malloc(size);
+	buf = malloc(size);
+	ut_assertnonnull(src);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		src[i] = (i * 7) ^ (i >> 9);
+	ut_assertok(os_write_file("blk_async.img", src, size));
+	ut_assertok(host_dev_bind(0, (char *)"blk_async.img"));
+	ut_assertok(blk_get_device_by_str("host", "0", &desc));
+
+	/* Start more reads than fit in the queue, then wait for them all */
+	memset(buf, '\0', size);
+	for (i = 0; i < ARRAY_SIZE(req); i++) {
+		req[i].start = i * per_req;
+		req[i].blkcnt = per_req;
+		req[i].buffer = buf + i * per_req * 512;
+		req[i].write = false;
+		ut_assertok(blk_submit(desc, &req[i]));
+	}
+	for (i = 0; i < ARRAY_SIZE(req); i++)
+		ut_asserteq(per_req, blk_wait(desc, &req[i]));
+	ut_asserteq_mem(src, buf, size);
+
+	/* A synchronous read waits for the write started before it */
+	memset(buf, 0xaa, 1024);
+	req[0].start = 10;
+	req[0].blkcnt = 2;
+	req[0].buffer = buf;
+	req[0].write = true;
+	ut_assertok(blk_submit(desc, &req[0]));
+	ut_asserteq(2, blk_dread(desc, 10, 2, buf + 1024));
+	ut_assert(req[0].done);
+	ut_asserteq(2, req[0].result);
+	ut_asserteq(0, blk_poll(desc, &req[0]));
+	ut_asserteq_mem(buf, buf + 1024, 1024);
+
+	/*
+	 * A write waits for an overlapping read in progress, which must not
+	 * leave the old data in the block cache
+	 */
+	req[0].start = 20;
+	req[0].blkcnt = per_req;
+	req[0].buffer = buf + 1024;
+	req[0].write = false;
+	ut_assertok(blk_submit(desc, &req[0]));
+	memset(buf, 0x55, 1024);
+	req[1].start = 22;
+	req[1].blkcnt = 2;
+	req[1].buffer = buf;
+	req[1].write = true;
+	ut_assertok(blk_submit(desc, &req[1]));
+	ut_assert(req[0].done);
+	ut_asserteq(per_req, req[0].result);
+	ut_asserteq_mem(src + 20 * 512, buf + 1024, per_req * 512);
+	ut_asserteq(2, blk_wait(desc, &req[1]));
+	ut_asserteq(2, blk_dread(desc, 22, 2, buf + 1024));
+	ut_asserteq_mem(buf, buf + 1024, 1024);
+
+	/* A read which runs off the end of the device is short */
+	req[0].start = blocks - 1;
+	req[0].blkcnt = 2;
+	req[0].buffer = buf;
+	req[0].write = false;
+	ut_assertok(blk_submit(desc, &req[0]));
+	ut_asserteq(1, blk_wait(desc, &req[0]));
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink("blk_async.img");
+	free(buf);
+	free(src);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
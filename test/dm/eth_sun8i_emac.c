@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the sun8i EMAC DMA descriptor rings
+ *
+ * The DMA engine is played by the test, which fills in the descriptors the
+ * way the hardware does.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include "../../drivers/net/sun8i_emac.h"
+
+#define RING_NUM	4
+
+static struct emac_dma_desc test_desc[RING_NUM];
+static char test_buf[RING_NUM * SUN8I_EMAC_BUFSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
+static void setup_ring(struct emac_ring *ring)
+{
+	ring->desc = test_desc;
+	ring->buf = test_buf;
+	ring->num = RING_NUM;
+}
+
+/* Receive a frame of @len bytes into descriptor @idx, as the DMA would */
+static void dma_receive(int idx, int len)
+{
+	memset(&test_buf[idx * SUN8I_EMAC_BUFSIZE], idx + 1, len);
+	test_desc[idx].status = len << EMAC_DESC_RX_LEN_SHIFT;
+}
+
+/* Test that the receive ring is set up as a loop owned by the DMA */
+static int dm_test_eth_sun8i_emac_rx_init(struct unit_test_state *uts)
+{
+	struct emac_ring ring;
+	int i;
+
+	setup_ring(&ring);
+	emac_rx_ring_init(&ring);
+	ut_asserteq(0, ring.cur);
+	for (i = 0; i < RING_NUM; i++) {
+		ut_asserteq(EMAC_DESC_OWN_DMA, test_desc[i].status);
+		ut_asserteq(SUN8I_EMAC_RXSIZE, test_desc[i].st);
+		ut_asserteq((u32)(ulong)&test_buf[i * SUN8I_EMAC_BUFSIZE],
+			    test_desc[i].buf_addr);
+		ut_asserteq((u32)(ulong)&test_desc[(i + 1) % RING_NUM],
+			    test_desc[i].next);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_eth_sun8i_emac_rx_init, 0);
+
+/* Test receiving frames in place, around the ring more than once */
+static int dm_test_eth_sun8i_emac_rx_wrap(struct unit_test_state *uts)
+{
+	struct emac_ring ring;
+	uchar *packet;
+	int i, idx;
+
+	setup_ring(&ring);
+	emac_rx_ring_init(&ring);
+	ut_asserteq(-EAGAIN, emac_rx_ring_recv(&ring, &packet));
+
+	for (i = 0; i < RING_NUM * 3; i++) {
+		idx = i % RING_NUM;
+		dma_receive(idx, 100 + i);
+		ut_asserteq(100 + i, emac_rx_ring_recv(&ring, &packet));
+
+		/* The frame is passed up in the DMA buffer itself */
+		ut_asserteq_ptr(&test_buf[idx * SUN8I_EMAC_BUFSIZE], packet);
+		ut_asserteq(idx + 1, packet[99 + i]);
+
+		/* Nothing else comes in until the buffer is freed */
+		ut_asserteq(0, test_desc[idx].status & EMAC_DESC_OWN_DMA);
+		ut_assertok(emac_rx_ring_free(&ring, packet, 100 + i));
+		ut_asserteq(EMAC_DESC_OWN_DMA, test_desc[idx].status);
+		ut_asserteq((idx + 1) % RING_NUM, ring.cur);
+	}
+	ut_asserteq(-EAGAIN, emac_rx_ring_recv(&ring, &packet));
+
+	return 0;
+}
+DM_TEST(dm_test_eth_sun8i_emac_rx_wrap, 0);
+
+/* Test a full ring, and frames which are dropped */
+static int dm_test_eth_sun8i_emac_rx_full(struct unit_test_state *uts)
+{
+	struct emac_ring ring;
+	uchar *packet;
+	int i;
+
+	setup_ring(&ring);
+	emac_rx_ring_init(&ring);
+	for (i = 0; i < RING_NUM; i++)
+		dma_receive(i, 200);
+
+	/* A runt is returned for freeing but not processing */
+	test_desc[1].status = 0x20 << EMAC_DESC_RX_LEN_SHIFT;
+
+	/* A frame too large is given back to the DMA straight away */
+	test_desc[2].status = (SUN8I_EMAC_RXSIZE + 1) <<
+			      EMAC_DESC_RX_LEN_SHIFT;
+
+	ut_asserteq(200, emac_rx_ring_recv(&ring, &packet));
+
+	/* Only the frame at the head of the ring can be freed */
+	ut_asserteq(-EINVAL, emac_rx_ring_free(&ring, packet + 1, 200));
+	ut_asserteq(-EINVAL, emac_rx_ring_free(&ring, (uchar *)&test_buf[
+				SUN8I_EMAC_BUFSIZE], 200));
+	ut_assertok(emac_rx_ring_free(&ring, packet, 200));
+
+	ut_asserteq(0, emac_rx_ring_recv(&ring, &packet));
+	ut_asserteq_ptr(&test_buf[SUN8I_EMAC_BUFSIZE], packet);
+	ut_assertok(emac_rx_ring_free(&ring, packet, 0));
+
+	ut_asserteq(-EMSGSIZE, emac_rx_ring_recv(&ring, &packet));
+	ut_asserteq(EMAC_DESC_OWN_DMA, test_desc[2].status);
+	ut_asserteq(3, ring.cur);
+
+	ut_asserteq(200, emac_rx_ring_recv(&ring, &packet));
+	ut_asserteq_ptr(&test_buf[3 * SUN8I_EMAC_BUFSIZE], packet);
+	ut_assertok(emac_rx_ring_free(&ring, packet, 200));
+	ut_asserteq(0, ring.cur);
+	ut_asserteq(-EAGAIN, emac_rx_ring_recv(&ring, &packet));
+
+	return 0;
+}
+DM_TEST(dm_test_eth_sun8i_emac_rx_full, 0);
+
+/* Test queueing frames for transmission around the ring */
+static int dm_test_eth_sun8i_emac_tx(struct unit_test_state *uts)
+{
+	struct emac_ring ring;
+	char frame[300];
+	int i, idx;
+
+	setup_ring(&ring);
+	emac_tx_ring_init(&ring);
+	for (i = 0; i < RING_NUM; i++) {
+		ut_asserteq(0, test_desc[i].st);
+		ut_asserteq((u32)(ulong)&test_desc[(i + 1) % RING_NUM],
+			    test_desc[i].next);
+	}
+
+	for (i = 0; i < RING_NUM + 2; i++) {
+		idx = i % RING_NUM;
+		memset(frame, i, sizeof(frame));
+		ut_assertok(emac_tx_ring_send(&ring, frame, 60 + i));
+		ut_asserteq(EMAC_DESC_OWN_DMA, test_desc[idx].status);
+		ut_asserteq((60 + i) | EMAC_DESC_TX_CHAIN | EMAC_DESC_TX_INT |
+			    EMAC_DESC_TX_LAST | EMAC_DESC_TX_FIRST,
+			    test_desc[idx].st);
+		ut_asserteq_mem(frame, &test_buf[idx * SUN8I_EMAC_BUFSIZE],
+				60 + i);
+	}
+	ut_asserteq(2, ring.cur);
+
+	ut_asserteq(-EMSGSIZE, emac_tx_ring_send(&ring, test_buf,
+						 SUN8I_EMAC_BUFSIZE + 1));
+	ut_asserteq(2, ring.cur);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_sun8i_emac_tx, 0);
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the sunxi SD/MMC IDMAC descriptor chain builder
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include "../../drivers/mmc/sunxi_mmc.h"
+
+#define DES0_COMMON	(SUNXI_MMC_IDMA_DES0_CH | SUNXI_MMC_IDMA_DES0_OWN)
+
+/* A transfer that fits into one descriptor */
+static int dm_test_mmc_sunxi_idma_single(struct unit_test_state *uts)
+{
+	struct sunxi_mmc_des des[4];
+
+	memset(des, '\xff', sizeof(des));
+	ut_asserteq(1, sunxi_mmc_idma_build(des, ARRAY_SIZE(des), 0x40000000,
+					    512, 13));
+	ut_asserteq(DES0_COMMON | SUNXI_MMC_IDMA_DES0_FD |
+		    SUNXI_MMC_IDMA_DES0_LD | SUNXI_MMC_IDMA_DES0_ER,
+		    des[0].config);
+	ut_asserteq(512, des[0].buf_size);
+	ut_asserteq(0x40000000, des[0].buf_addr);
+	ut_asserteq(0, des[0].next_addr);
+
+	/* The next entry must not have been touched */
+	ut_asserteq(0xffffffff, des[1].config);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_sunxi_idma_single, 0);
+
+/* A transfer split over several descriptors, with a partial last one */
+static int dm_test_mmc_sunxi_idma_chain(struct unit_test_state *uts)
+{
+	struct sunxi_mmc_des des[4];
+	int i;
+
+	ut_asserteq(3, sunxi_mmc_idma_build(des, ARRAY_SIZE(des), 0x40000000,
+					    2 * 8192 + 1024, 13));
+	for (i = 0; i < 3; i++) {
+		ut_asserteq(0x40000000 + i * 8192, des[i].buf_addr);
+		ut_assert(des[i].config & SUNXI_MMC_IDMA_DES0_OWN);
+		ut_assert(des[i].config & SUNXI_MMC_IDMA_DES0_CH);
+	}
+
+	/* Full descriptors use a size of 0, meaning 'maximum' */
+	ut_asserteq(0, des[0].buf_size);
+	ut_asserteq(0, des[1].buf_size);
+	ut_asserteq(1024, des[2].buf_size);
+
+	ut_asserteq(DES0_COMMON | SUNXI_MMC_IDMA_DES0_DIC |
+		    SUNXI_MMC_IDMA_DES0_FD, des[0].config);
+	ut_asserteq(DES0_COMMON | SUNXI_MMC_IDMA_DES0_DIC, des[1].config);
+	ut_asserteq(DES0_COMMON | SUNXI_MMC_IDMA_DES0_LD |
+		    SUNXI_MMC_IDMA_DES0_ER, des[2].config);
+
+	ut_asserteq((u32)(ulong)&des[1], des[0].next_addr);
+	ut_asserteq((u32)(ulong)&des[2], des[1].next_addr);
+	ut_asserteq(0, des[2].next_addr);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_sunxi_idma_chain, 0);
+
+/* Larger descriptors (e.g. A80 / H6) and the error cases */
+static int dm_test_mmc_sunxi_idma_limits(struct unit_test_state *uts)
+{
+	struct sunxi_mmc_des des[2];
+
+	ut_asserteq(2, sunxi_mmc_idma_build(des, ARRAY_SIZE(des), 0x40000000,
+					    2 * 65536, 16));
+	ut_asserteq(0, des[1].buf_size);
+	ut_asserteq(0x40010000, des[1].buf_addr);
+
+	ut_asserteq(-E2BIG, sunxi_mmc_idma_build(des, ARRAY_SIZE(des),
+						 0x40000000, 2 * 8192 + 512,
+						 13));
+	ut_asserteq(-EINVAL, sunxi_mmc_idma_build(des, ARRAY_SIZE(des),
+						  0x40000000, 0, 13));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_sunxi_idma_limits, 0);
@@ -2,11 +2,15 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
 #include <log.h>
+#include <malloc.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -135,3 +139,83 @@ static int dm_test_ofnode_get_child_count(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_get_child_count,
 	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that the index of the control tree finds the same nodes as libfdt */
+static int dm_test_ofnode_index(struct unit_test_state *uts)
+{
+	const char *compat = "denx,u-boot-fdt-test";
+	const void *blob = gd->fdt_blob;
+	int offset, depth, node;
+	char path[256];
+	u32 phandle;
+
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle)
+			ut_asserteq(offset,
+				    fdtdec_node_offset_by_phandle(blob,
+								  phandle));
+		ut_assertok(fdt_get_path(blob, offset, path, sizeof(path)));
+		ut_asserteq(offset, fdtdec_path_offset(blob, path));
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(blob, 0x7fffffff));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(blob, "/missing"));
+
+	/* Paths which libfdt resolves, but which are not in the index */
+	ut_asserteq(fdt_path_offset(blob, "/i2c@0"),
+		    fdtdec_path_offset(blob, "i2c0"));
+	ut_asserteq(fdt_path_offset(blob, "/i2c@0"),
+		    fdtdec_path_offset(blob, "/i2c"));
+
+	node = -1;
+	do {
+		offset = fdt_node_offset_by_compatible(blob, node, compat);
+		node = fdtdec_node_offset_by_compatible(blob, node, compat);
+		ut_asserteq(offset, node);
+	} while (node >= 0);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_index, DM_TESTF_SCAN_FDT);
+
+/* Test that the index is built again when the control tree changes */
+static int dm_test_ofnode_index_change(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int size = fdt_totalsize(blob) + 1024;
+	int node, ret;
+	void *copy;
+
+	copy = malloc(size);
+	ut_assertnonnull(copy);
+	ut_assertok(fdt_open_into(blob, copy, size));
+
+	gd->fdt_blob = copy;
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_compatible(copy, -1, "test,index"));
+	node = fdt_add_subnode(copy, 0, "index-test");
+	ret = node < 0 ? node :
+		fdt_setprop_string(copy, node, "compatible", "test,index");
+	if (!ret)
+		ret = fdt_setprop_u32(copy, node, "phandle", 0x7fffffff);
+	if (!ret) {
+		/* Offsets after the new node have moved */
+		node = fdt_path_offset(copy, "/index-test");
+		ret = fdtdec_node_offset_by_compatible(copy, -1, "test,index");
+		if (ret == node)
+			ret = fdtdec_node_offset_by_phandle(copy, 0x7fffffff);
+		if (ret == node)
+			ret = fdtdec_path_offset(copy, "/index-test");
+		if (ret == node)
+			ret = 0;
+	}
+	gd->fdt_blob = blob;
+	fdtdec_index_invalidate();
+	free(copy);
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_index_change, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for probing devices in the background
+ *
+ * The test driver counts its probe() and probe_poll() calls as steps, so that
+ * the order in which devices are probed can be checked without any delays.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/**
+ * struct probe_async_plat - Set-up of a test device
+ *
+ * @polls:	Number of times probe_poll() returns -EINPROGRESS, 0 to finish
+ *		in probe()
+ * @ret:	Result of the probe
+ * @supplier:	Device probed by the probe() method, or NULL
+ */
+struct probe_async_plat {
+	int polls;
+	int ret;
+	struct udevice *supplier;
+};
+
+/**
+ * struct probe_async_priv - State of a test device
+ *
+ * @polls:	Number of calls to probe_poll() so far
+ * @started:	Step at which probe() started waiting
+ * @done:	Step at which the probe finished
+ */
+struct probe_async_priv {
+	int polls;
+	int started;
+	int done;
+};
+
+static int probe_async_step;
+static int probe_async_pending;
+static int probe_async_max_pending;
+
+static int probe_async_poll(struct udevice *dev)
+{
+	struct probe_async_plat *plat = dev_get_platdata(dev);
+	struct probe_async_priv *priv = dev_get_priv(dev);
+
+	probe_async_step++;
+	if (priv->polls++ < plat->polls)
+		return -EINPROGRESS;
+	priv->done = probe_async_step;
+	probe_async_pending--;
+
+	return plat->ret;
+}
+
+static int probe_async_probe(struct udevice *dev)
+{
+	struct probe_async_plat *plat = dev_get_platdata(dev);
+	struct probe_async_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	if (plat->supplier) {
+		ret = device_probe(plat->supplier);
+		if (ret)
+			return ret;
+	}
+	priv->started = ++probe_async_step;
+	if (!plat->polls) {
+		priv->done = priv->started;
+		return plat->ret;
+	}
+	probe_async_pending++;
+	probe_async_max_pending = max(probe_async_max_pending,
+				      probe_async_pending);
+
+	return dev_probe_defer(dev, probe_async_poll);
+}
+
+U_BOOT_DRIVER(probe_async_test) = {
+	.name	= "probe_async_test",
+	.id	= UCLASS_TEST_DUMMY,
+	.probe	= probe_async_probe,
+	DM_PROBE_POLL_PTR(probe_async_poll)
+	.priv_auto_alloc_size	= sizeof(struct probe_async_priv),
+};
+
+static struct probe_async_plat test_plat[5];
+
+static int bind_test_dev(struct unit_test_state *uts, struct udevice *parent,
+			 int idx, int polls, struct udevice **devp)
+{
+	static const char *const names[] = { "a", "b", "c", "d", "e" };
+
+	test_plat[idx].polls = polls;
+	test_plat[idx].ret = 0;
+	test_plat[idx].supplier = NULL;
+	ut_assertok(device_bind_ofnode(parent, DM_GET_DRIVER(probe_async_test),
+				       names[idx], &test_plat[idx],
+				       ofnode_null(), devp));
+
+	return 0;
+}
+
+static void reset_counts(void)
+{
+	probe_async_step = 0;
+	probe_async_pending = 0;
+	probe_async_max_pending = 0;
+}
+
+/* Check that a device is probed and not waiting any more */
+static int check_ready(struct unit_test_state *uts, struct udevice *dev)
+{
+	ut_assert(device_active(dev));
+	ut_asserteq(0, dev->flags & DM_FLAG_PROBE_PENDING);
+
+	return 0;
+}
+
+static struct probe_async_priv *test_priv(struct udevice *dev)
+{
+	return dev_get_priv(dev);
+}
+
+/* Test that independent devices wait at the same time */
+static int dm_test_probe_async(struct unit_test_state *uts)
+{
+	struct udevice *dev[4];
+	int i;
+
+	reset_counts();
+	ut_assertok(bind_test_dev(uts, dm_root(), 0, 3, &dev[0]));
+	ut_assertok(bind_test_dev(uts, dm_root(), 1, 5, &dev[1]));
+	ut_assertok(bind_test_dev(uts, dm_root(), 2, 0, &dev[2]));
+	ut_assertok(bind_test_dev(uts, dm_root(), 3, 4, &dev[3]));
+
+	ut_assertok(uclass_probe_all(UCLASS_TEST_DUMMY));
+	for (i = 0; i < 4; i++)
+		ut_assertok(check_ready(uts, dev[i]));
+	ut_asserteq(3, probe_async_max_pending);
+	ut_asserteq(0, probe_async_pending);
+
+	/* All were started before the first one was done */
+	ut_asserteq(4, test_priv(dev[3])->started);
+	ut_assert(test_priv(dev[3])->started < test_priv(dev[0])->done);
+	ut_assert(test_priv(dev[0])->done < test_priv(dev[3])->done);
+	ut_assert(test_priv(dev[3])->done < test_priv(dev[1])->done);
+
+	/* Each device is started once and polled once more than it waits */
+	ut_asserteq(4 + 4 + 6 + 5, probe_async_step);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async, 0);
+
+/* Test that children wait for their parent, but others do not */
+static int dm_test_probe_async_parent(struct unit_test_state *uts)
+{
+	struct udevice *parent, *child[2], *other;
+	struct udevice *devs[3];
+
+	reset_counts();
+	ut_assertok(bind_test_dev(uts, dm_root(), 0, 3, &parent));
+	ut_assertok(bind_test_dev(uts, parent, 1, 2, &child[0]));
+	ut_assertok(bind_test_dev(uts, parent, 2, 0, &child[1]));
+	ut_assertok(bind_test_dev(uts, dm_root(), 3, 3, &other));
+
+	devs[0] = child[0];
+	devs[1] = child[1];
+	devs[2] = other;
+	ut_assertok(device_probe_all(devs, ARRAY_SIZE(devs)));
+	ut_assertok(check_ready(uts, parent));
+	ut_assertok(check_ready(uts, child[0]));
+	ut_assertok(check_ready(uts, child[1]));
+	ut_assertok(check_ready(uts, other));
+
+	ut_assert(test_priv(other)->started < test_priv(parent)->done);
+	ut_assert(test_priv(parent)->done < test_priv(child[0])->started);
+	ut_assert(test_priv(parent)->done < test_priv(child[1])->started);
+	ut_asserteq(2, probe_async_max_pending);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_parent, 0);
+
+/* Test that a supplier looked up by probe() is waited for */
+static int dm_test_probe_async_supplier(struct unit_test_state *uts)
+{
+	struct udevice *supplier, *dev;
+	struct udevice *devs[2];
+
+	reset_counts();
+	ut_assertok(bind_test_dev(uts, dm_root(), 0, 4, &supplier));
+	ut_assertok(bind_test_dev(uts, dm_root(), 1, 1, &dev));
+	test_plat[1].supplier = supplier;
+
+	devs[0] = supplier;
+	devs[1] = dev;
+	ut_assertok(device_probe_all(devs, ARRAY_SIZE(devs)));
+	ut_assertok(check_ready(uts, supplier));
+	ut_assertok(check_ready(uts, dev));
+	ut_assert(test_priv(supplier)->done < test_priv(dev)->started);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_supplier, 0);
+
+/* Test failures, and waiting for a probe outside device_probe_all() */
+static int dm_test_probe_async_wait(struct unit_test_state *uts)
+{
+	struct udevice *bad, *good, *dev;
+	struct udevice *devs[2];
+
+	reset_counts();
+	ut_assertok(bind_test_dev(uts, dm_root(), 0, 2, &bad));
+	test_plat[0].ret = -EIO;
+	ut_assertok(bind_test_dev(uts, dm_root(), 1, 3, &good));
+
+	devs[0] = bad;
+	devs[1] = good;
+	ut_asserteq(-EIO, device_probe_all(devs, ARRAY_SIZE(devs)));
+	ut_assert(!device_active(bad));
+	ut_asserteq(0, bad->flags & DM_FLAG_PROBE_PENDING);
+	ut_assertok(check_ready(uts, good));
+
+	/* device_probe() returns once the device is ready */
+	ut_assertok(bind_test_dev(uts, dm_root(), 2, 3, &dev));
+	ut_asserteq(-EINPROGRESS, device_probe_start(dev));
+	ut_asserteq(-EINPROGRESS, device_probe_start(dev));
+	ut_assert(!device_active(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_assertok(device_probe(dev));
+	ut_assertok(check_ready(uts, dev));
+	ut_asserteq(4, test_priv(dev)->polls);
+
+	/* Removing a device lets its probe finish first */
+	ut_assertok(bind_test_dev(uts, dm_root(), 3, 3, &dev));
+	ut_asserteq(-EINPROGRESS, device_probe_start(dev));
+	ut_asserteq(-EINPROGRESS, device_probe_poll(dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assert(!device_active(dev));
+	ut_asserteq(0, dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_asserteq(0, probe_async_pending);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_wait, 0);
@@ -10,6 +10,7 @@
 #include <mapmem.h>
 #include <os.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <asm/state.h>
 #include <asm/test.h>
@@ -101,3 +102,56 @@ static int dm_test_spi_flash_func(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash_func, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test reading SPI flash through the direct mapping */
+static int dm_test_spi_flash_dirmap(struct unit_test_state *uts)
+{
+	struct spi_mem_dirmap_desc *rdesc;
+	int full_size = 0x200000;
+	struct spi_flash *flash;
+	struct udevice *dev;
+	u8 *src, *dst;
+	int i;
+
+	/* Calibration needs data which is not all the same */
+	src = map_sysmem(0x20000, full_size);
+	for (i = 0; i < full_size; i++)
+		src[i] = i * 7 + (i >> 8);
+	ut_assertok(os_write_file("spi.bin", src, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+
+	/* The sandbox flash supports Fast Read at the full clock */
+	ut_asserteq(SPINOR_OP_READ_FAST, flash->read_opcode);
+	ut_asserteq(40000000, flash->spi->max_hz);
+
+	/* The sandbox controller maps the flash itself */
+	rdesc = flash->dirmap.rdesc;
+	ut_assertnonnull(rdesc);
+	ut_asserteq(0, rdesc->nodirmap);
+
+	/* Reads stop at the end of its 64KiB window... */
+	dst = map_sysmem(0x20000 + full_size, full_size);
+	ut_asserteq(0x100, spi_mem_dirmap_read(rdesc, 0xff00, 0x1000, dst));
+	ut_asserteq_mem(src + 0xff00, dst, 0x100);
+
+	/* ...which the SPI flash layer copes with */
+	memset(dst, '\0', 0x30000);
+	ut_assertok(spi_flash_read_dm(dev, 0xff00, 0x30000, dst));
+	ut_asserteq_mem(src + 0xff00, dst, 0x30000);
+
+	/* Small reads do not use the mapping but give the same data */
+	ut_assertok(spi_flash_read_dm(dev, 0x1fff0, 0x20, dst));
+	ut_asserteq_mem(src + 0x1fff0, dst, 0x20);
+
+	ut_assertok(run_command("sf probe; sf bench 20000 0 40000", 0));
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_dirmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for TFTP transfers, using a fake server on the sandbox Ethernet
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <env.h>
+#include <image.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define TFTP_TEST_PORT		1069
+#define TFTP_TEST_BLKSIZE	512
+#define TFTP_TEST_BLOCKS	11
+#define TFTP_TEST_SIZE		((TFTP_TEST_BLOCKS - 1) * TFTP_TEST_BLKSIZE + 100)
+#define TFTP_TEST_ADDR		0x1000000
+
+/* Opcodes, from net/tftp.c */
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_OACK	6
+
+/**
+ * struct tftp_test_server - state of the fake TFTP server
+ *
+ * @window:	Window size to grant, 0 to ignore the option
+ * @lossy:	Drop block 5 and swap blocks 8 and 9 the first time they are sent
+ * @req_window:	Window size requested by the client
+ * @client_port: UDP port of the client
+ * @sent:	Bit n set if block n has been sent
+ * @acks:	Number of acks received, including the one for the OACK
+ */
+static struct tftp_test_server {
+	int window;
+	bool lossy;
+	int req_window;
+	int client_port;
+	ulong sent;
+	int acks;
+} tftp_srv;
+
+static u8 tftp_test_byte(ulong offset)
+{
+	return (offset * 7 + (offset >> 9)) & 0xff;
+}
+
+static uchar *tftp_test_reply(struct udevice *dev, void *packet, uint len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return NULL;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	net_set_ip_header((uchar *)ipr, net_read_ip(&ip->ip_src),
+			  priv->fake_host_ipaddr, IP_UDP_HDR_SIZE + len,
+			  IPPROTO_UDP);
+	ipr->udp_src = htons(TFTP_TEST_PORT);
+	ipr->udp_dst = htons(tftp_srv.client_port);
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+
+	return (uchar *)ipr + IP_UDP_HDR_SIZE;
+}
+
+static void tftp_test_send_block(struct udevice *dev, void *packet, int block)
+{
+	ulong offset = (block - 1) * TFTP_TEST_BLKSIZE;
+	uint len = min(TFTP_TEST_SIZE - offset, (ulong)TFTP_TEST_BLKSIZE);
+	uchar *data;
+	uint i;
+
+	tftp_srv.sent |= 1UL << block;
+	data = tftp_test_reply(dev, packet, 4 + len);
+	if (!data)
+		return;
+	put_unaligned_be16(TFTP_DATA, data);
+	put_unaligned_be16(block, data + 2);
+	for (i = 0; i < len; i++)
+		data[4 + i] = tftp_test_byte(offset + i);
+}
+
+/* Send the window following an ack, as an RFC 7440 server does */
+static void tftp_test_send_window(struct udevice *dev, void *packet, int ack)
+{
+	int window = tftp_srv.window ? tftp_srv.window : 1;
+	int last = min(ack + window, TFTP_TEST_BLOCKS);
+	int block;
+
+	for (block = ack + 1; block <= last; block++) {
+		bool first = !(tftp_srv.sent & (1UL << block));
+
+		if (tftp_srv.lossy && first && block == 5) {
+			tftp_srv.sent |= 1UL << block;
+			continue;
+		}
+		if (tftp_srv.lossy && first && block == 8 && block < last) {
+			tftp_test_send_block(dev, packet, 9);
+			tftp_test_send_block(dev, packet, 8);
+			block++;
+			continue;
+		}
+		tftp_test_send_block(dev, packet, block);
+	}
+}
+
+static void tftp_test_rrq(struct udevice *dev, void *packet, char *opt,
+			  char *end)
+{
+	char oack[64];
+	uchar *data;
+	int len;
+
+	/* Skip the file name and the mode */
+	opt += strlen(opt) + 1;
+	opt += strlen(opt) + 1;
+	while (opt < end) {
+		char *val = opt + strlen(opt) + 1;
+
+		if (!strcmp(opt, "windowsize"))
+			tftp_srv.req_window = simple_strtoul(val, NULL, 10);
+		opt = val + strlen(val) + 1;
+	}
+
+	put_unaligned_be16(TFTP_OACK, oack);
+	len = 2;
+	len += sprintf(oack + len, "blksize%c%d%c", 0, TFTP_TEST_BLKSIZE, 0);
+	if (tftp_srv.window)
+		len += sprintf(oack + len, "windowsize%c%d%c", 0,
+			       tftp_srv.window, 0);
+
+	data = tftp_test_reply(dev, packet, len);
+	if (data)
+		memcpy(data, oack, len);
+}
+
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	uchar *data = (uchar *)ip + IP_UDP_HDR_SIZE;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	tftp_srv.client_port = ntohs(ip->udp_src);
+	switch (get_unaligned_be16(data)) {
+	case TFTP_RRQ:
+		tftp_test_rrq(dev, packet, (char *)data + 2,
+			      (char *)packet + len);
+		break;
+	case TFTP_ACK:
+		tftp_srv.acks++;
+		tftp_test_send_window(dev, packet,
+				      get_unaligned_be16(data + 2));
+		break;
+	}
+
+	return 0;
+}
+
+static int tftp_test_get(struct unit_test_state *uts, int window, bool lossy)
+{
+	u8 *buf;
+	ulong i;
+
+	memset(&tftp_srv, '\0', sizeof(tftp_srv));
+	tftp_srv.window = window;
+	tftp_srv.lossy = lossy;
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+
+	buf = map_sysmem(TFTP_TEST_ADDR, TFTP_TEST_SIZE + 1);
+	memset(buf, '\0', TFTP_TEST_SIZE + 1);
+
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.2.3.5");
+	env_set("bootfile", "test.bin");
+	image_load_addr = TFTP_TEST_ADDR;
+	ut_asserteq(TFTP_TEST_SIZE, net_loop(TFTPGET));
+
+	for (i = 0; i < TFTP_TEST_SIZE; i++)
+		ut_asserteq(tftp_test_byte(i), buf[i]);
+	ut_asserteq(0, buf[TFTP_TEST_SIZE]);
+	unmap_sysmem(buf);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	env_set("bootfile", NULL);
+	env_set("serverip", NULL);
+	env_set("tftpwindowsize", NULL);
+
+	return 0;
+}
+
+/* Test that a server which does not know about windows still works */
+static int dm_test_tftp_lockstep(struct unit_test_state *uts)
+{
+	env_set("tftpwindowsize", "3");
+	ut_assertok(tftp_test_get(uts, 0, false));
+	ut_asserteq(3, tftp_srv.req_window);
+	/* One ack for the OACK and one per block */
+	ut_asserteq(1 + TFTP_TEST_BLOCKS, tftp_srv.acks);
+
+	return 0;
+}
+DM_TEST(dm_test_tftp_lockstep, DM_TESTF_SCAN_FDT);
+
+/* Test that only one ack is sent per window */
+static int dm_test_tftp_window(struct unit_test_state *uts)
+{
+	env_set("tftpwindowsize", "3");
+	ut_assertok(tftp_test_get(uts, 3, false));
+	/* OACK, then blocks 3, 6, 9 and 11 */
+	ut_asserteq(5, tftp_srv.acks);
+
+	return 0;
+}
+DM_TEST(dm_test_tftp_window, DM_TESTF_SCAN_FDT);
+
+/* Test recovery from a lost block, and blocks arriving out of order */
+static int dm_test_tftp_window_loss(struct unit_test_state *uts)
+{
+	env_set("tftpwindowsize", "3");
+	ut_assertok(tftp_test_get(uts, 3, true));
+	/* OACK, 3, 4 (block 5 missing), 7, 10 and 11 */
+	ut_asserteq(6, tftp_srv.acks);
+
+	return 0;
+}
+DM_TEST(dm_test_tftp_window_loss, DM_TESTF_SCAN_FDT);
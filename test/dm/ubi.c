@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for attaching UBI to the sandbox SPI flash
+ */
+
+#include <common.h>
+#include <console.h>
+#include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <spi_flash.h>
+#include <ubi_uboot.h>
+#include <asm/state.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/*
+ * The emulated flash has 512 eraseblocks of 4KiB. The m25p16 used by the
+ * other SPI flash tests has only 32, which is too few for a fastmap.
+ */
+#define UBI_FLASH_SIZE	0x200000
+
+/* Attach UBI to the MTD device of the SPI flash */
+static int ubi_test_attach(struct unit_test_state *uts,
+			   struct ubi_device **ubip)
+{
+	ut_assertok(ubi_mtd_param_parse("nor0", NULL));
+	ut_assertok(ubi_init());
+	*ubip = ubi_devices[0];
+	ut_assertnonnull(*ubip);
+
+	return 0;
+}
+
+/* Check whether the last attach said that it used the fastmap */
+static bool ubi_test_attached_by_fastmap(struct unit_test_state *uts)
+{
+	bool found = false;
+
+	while (console_record_readline(uts->actual_str,
+				       sizeof(uts->actual_str)) > 0) {
+		if (strstr(uts->actual_str, "attached by fastmap"))
+			found = true;
+	}
+
+	return found;
+}
+
+/* Test that headers read ahead are dropped on a write or erase of the PEB */
+static int ubi_test_read_ahead(struct unit_test_state *uts,
+			       struct ubi_device *ubi)
+{
+	int len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	struct ubi_wl_entry *e;
+	struct ubi_ec_hdr *ech;
+	int pnum;
+	int ec;
+
+	/* Use a free PEB, so that the volumes are not touched */
+	ut_assertnonnull(rb_first(&ubi->free));
+	e = rb_entry(rb_first(&ubi->free), struct ubi_wl_entry, u.rb);
+	pnum = e->pnum;
+	ec = e->ec;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	ut_assertnonnull(ech);
+	ubi->hdrs_buf = kmalloc(len, GFP_KERNEL);
+	ut_assertnonnull(ubi->hdrs_buf);
+
+	ubi_io_read_ahead_hdrs(ubi, pnum);
+	ut_asserteq(pnum, ubi->hdrs_pnum);
+	ut_asserteq(len, ubi->hdrs_len);
+
+	/* After an erase the headers must be read back as empty */
+	ut_asserteq(1, ubi_io_sync_erase(ubi, pnum, 0));
+	ut_asserteq(0, ubi->hdrs_len);
+	ut_asserteq(UBI_IO_FF, ubi_io_read_ec_hdr(ubi, pnum, ech, 0));
+
+	/* After a write the new EC header must be read back */
+	ubi_io_read_ahead_hdrs(ubi, pnum);
+	ut_asserteq(len, ubi->hdrs_len);
+	ech->ec = cpu_to_be64(ec);
+	ut_assertok(ubi_io_write_ec_hdr(ubi, pnum, ech));
+	ut_asserteq(0, ubi->hdrs_len);
+	memset(ech, '\0', ubi->ec_hdr_alsize);
+	ut_assertok(ubi_io_read_ec_hdr(ubi, pnum, ech, 0));
+	ut_asserteq(ec, be64_to_cpu(ech->ec));
+
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
+	kfree(ech);
+
+	return 0;
+}
+
+/* Test attaching UBI by scanning, and then by the fastmap written then */
+static int dm_test_ubi_sf(struct unit_test_state *uts)
+{
+	struct sandbox_state *state = state_get_current();
+	struct udevice *bus, *dev;
+	struct ubi_device *ubi;
+	u8 *image;
+
+	image = malloc(UBI_FLASH_SIZE);
+	ut_assertnonnull(image);
+	memset(image, '\xff', UBI_FLASH_SIZE);
+	ut_assertok(os_write_file("ubi.bin", image, UBI_FLASH_SIZE));
+
+	/* Emulate a flash with small eraseblocks for the SPI flash device */
+	ut_assertok(uclass_get_device_by_seq(UCLASS_SPI, 0, &bus));
+	ut_assertok(sandbox_sf_bind_emul(state, 0, 0, bus,
+					 ofnode_path("/ubi-flash"), "ubi"));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+
+	/* The empty flash is attached by scanning, which writes a fastmap */
+	console_record_reset_enable();
+	ut_assertok(ubi_test_attach(uts, &ubi));
+	ut_assert(!ubi_test_attached_by_fastmap(uts));
+	ut_assertnonnull(ubi->fm);
+
+	/*
+	 * UBI writes a fastmap when it is detached too. Put the flash back as
+	 * it was before, as if the board had booted without detaching.
+	 */
+	ut_assertok(spi_flash_read_dm(dev, 0, UBI_FLASH_SIZE, image));
+	ubi_exit();
+	ut_assertok(spi_flash_erase_dm(dev, 0, UBI_FLASH_SIZE));
+	ut_assertok(spi_flash_write_dm(dev, 0, UBI_FLASH_SIZE, image));
+
+	console_record_reset_enable();
+	ut_assertok(ubi_test_attach(uts, &ubi));
+	ut_assert(ubi_test_attached_by_fastmap(uts));
+
+	ut_assertok(ubi_test_read_ahead(uts, ubi));
+
+	ubi_exit();
+	free(image);
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state, 0, 0);
+	os_unlink("ubi.bin");
+
+	return 0;
+}
+DM_TEST(dm_test_ubi_sf, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
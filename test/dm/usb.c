@@ -62,6 +62,58 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* test large transfers, and falling back when the device cannot cope */
+static int dm_test_usb_flash_xfer(struct unit_test_state *uts)
+{
+	struct usb_stor_stats before, stats;
+	struct blk_desc *dev_desc;
+	struct udevice *dev, *emul;
+	char *buf;
+	int i;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(usb_emul_find_for_dev(dev, &emul));
+	ut_assertok(blk_get_device_by_str("usb", "0", &dev_desc));
+	buf = malloc(4096 * 512);
+	ut_assertnonnull(buf);
+
+	/* 2MB goes in two transfers */
+	ut_assertok(usb_stor_get_stats(dev_desc, &before));
+	ut_asserteq(CONFIG_USB_STORAGE_MAX_XFER_BLK, before.max_xfer_blk);
+	ut_asserteq(4096, blk_dread(dev_desc, 0, 4096, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	ut_assertok(usb_stor_get_stats(dev_desc, &stats));
+	ut_asserteq(2, stats.xfers - before.xfers);
+	ut_asserteq(0, stats.errors - before.errors);
+	ut_asserteq(4096 * 512, stats.read_bytes - before.read_bytes);
+
+	/* A device which fails large transfers drops back to 240 blocks */
+	before = stats;
+	sandbox_flash_set_max_xfer_blk(emul, 1000);
+	memset(buf, '\xff', 4096 * 512);
+	ut_asserteq(4096, blk_dread(dev_desc, 0, 4096, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	for (i = 16; i < 4096 * 512; i++) {
+		if (buf[i])
+			break;
+	}
+	ut_asserteq(4096 * 512, i);
+	ut_assertok(usb_stor_get_stats(dev_desc, &stats));
+	ut_asserteq(240, stats.max_xfer_blk);
+	ut_asserteq(1, stats.errors - before.errors);
+	ut_asserteq(DIV_ROUND_UP(4096, 240), stats.xfers - before.xfers);
+	ut_asserteq(4096 * 512, stats.read_bytes - before.read_bytes);
+
+	sandbox_flash_set_max_xfer_blk(emul, 0);
+	free(buf);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_xfer, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
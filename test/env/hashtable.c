@@ -6,7 +6,10 @@
 
 #include <common.h>
 #include <command.h>
+#include <env_index.h>
+#include <env_internal.h>
 #include <log.h>
+#include <malloc.h>
 #include <search.h>
 #include <stdio.h>
 #include <test/env.h>
@@ -14,6 +17,7 @@
 
 #define SIZE 32
 #define ITERATIONS 10000
+#define BENCH_SIZE 10000
 
 static int htab_fill(struct unit_test_state *uts,
 		     struct hsearch_data *htab, size_t size)
@@ -124,3 +128,280 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hashtable far beyond its initial size */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 20));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 20));
+	ut_asserteq(SIZE * 20, htab.filled);
+	ut_assert(htab.size > SIZE * 20);
+
+	ut_assertok(htab_create_delete(uts, &htab, ITERATIONS));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 20));
+	ut_asserteq(SIZE * 20, htab.filled);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Check that the export is sorted, as entries are added and deleted */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	char *const argv[] = { "1" };
+	struct env_entry item, *ritem;
+	struct hsearch_data htab;
+	char *res = NULL;
+
+	memset(&item, 0, sizeof(item));
+	item.data = "x";
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	/* "0" to "31" go in out of order, as strings */
+	ut_assertok(htab_fill(uts, &htab, SIZE));
+	ut_asserteq(1, hdelete_r("2", &htab, 0));
+	ut_asserteq(1, hdelete_r("17", &htab, 0));
+	ut_assert(hexport_r(&htab, ' ', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("0=0 1=1 10=10 11=11 12=12 13=13 14=14 15=15 16=16 "
+			"18=18 19=19 20=20 21=21 22=22 23=23 24=24 25=25 "
+			"26=26 27=27 28=28 29=29 3=3 30=30 31=31 4=4 5=5 6=6 "
+			"7=7 8=8 9=9 ", res);
+	free(res);
+	res = NULL;
+
+	/* Merge some new entries with the sorted ones */
+	item.key = "100";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	item.key = "05";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(1, hdelete_r("10", &htab, 0));
+	ut_asserteq(1, hdelete_r("31", &htab, 0));
+	ut_assert(hexport_r(&htab, ' ', H_MATCH_KEY | H_MATCH_SUBSTR, &res, 0,
+			    1, argv) > 0);
+	ut_asserteq_str("1=1 100=x 11=11 12=12 13=13 14=14 15=15 16=16 18=18 "
+			"19=19 21=21 ", res);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
+
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+#define INDEX_BUF_SIZE	1024
+
+/* Check that variables are entered from an index as they are looked up */
+static int env_test_htab_index(struct unit_test_state *uts)
+{
+	struct env_entry item, *ritem;
+	struct hsearch_data htab;
+	char *buf, *res = NULL;
+	int i, n;
+
+	memset(&item, 0, sizeof(item));
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+	ut_assertok(htab_fill(uts, &htab, SIZE));
+	item.key = "back";
+	item.data = "a\\b";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+
+	/* There must be room for the index after the list */
+	buf = calloc(1, INDEX_BUF_SIZE);
+	ut_assertnonnull(buf);
+	ut_assert(hexport_r(&htab, '\0', 0, &buf, INDEX_BUF_SIZE, 0,
+			    NULL) > 0);
+	ut_asserteq(-ENOSPC, hexport_index(buf, 200));
+	ut_assertok(hexport_index(buf, INDEX_BUF_SIZE));
+	hdestroy_r(&htab);
+
+	ut_asserteq(1, himport_index_r(&htab, buf, INDEX_BUF_SIZE, 0));
+	ut_asserteq(SIZE + 1, htab.index_count);
+	ut_asserteq(0, htab.filled);
+
+	item.data = NULL;
+	item.key = "7";
+	ut_assert(hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+	ut_asserteq_str("7", ritem->data);
+	item.key = "back";
+	ut_assert(hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+	ut_asserteq_str("a\\b", ritem->data);
+	item.key = "70";
+	ut_asserteq(0, hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+	ut_asserteq(2, htab.filled);
+
+	/* Changes go to the table, and are not undone by the index */
+	item.key = "8";
+	item.data = "new";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(1, hdelete_r("9", &htab, 0));
+	item.data = NULL;
+	ut_assert(hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+	ut_asserteq_str("new", ritem->data);
+	item.key = "9";
+	ut_asserteq(0, hsearch_r(item, ENV_FIND, &ritem, &htab, 0));
+	ut_asserteq(3, htab.filled);
+
+	/* Matching enters all variables with the prefix: "1", "10" to "19" */
+	for (i = 0, n = 0; (i = hmatch_r("1", i, &ritem, &htab)); n++)
+		ut_asserteq('1', ritem->key[0]);
+	ut_asserteq(11, n);
+	ut_asserteq(14, htab.filled);
+
+	/* Exporting enters the rest, after which the index is dropped */
+	ut_assert(hexport_r(&htab, ' ', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq(SIZE, htab.filled);
+	ut_asserteq(0, htab.index_count);
+	ut_assertnonnull(strstr(res, " 8=new "));
+	ut_assertnull(strstr(res, " 9=9 "));
+	free(res);
+
+	/* An index which does not match the list is not used */
+	buf[0] = 'x';
+	ut_asserteq(0, himport_index_r(&htab, buf, INDEX_BUF_SIZE, 0));
+	memset(buf + INDEX_BUF_SIZE - 16, '\0', 16);
+	ut_asserteq(0, himport_index_r(&htab, buf, INDEX_BUF_SIZE, 0));
+	ut_asserteq(SIZE, htab.filled);
+	free(buf);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_index, 0);
+
+/*
+ * Check an indexed environment with ".flags" in it. Entering ".flags" calls
+ * on_flags(), which enters the whole index while ".flags" itself is still
+ * being entered from it.
+ */
+static int env_test_htab_index_flags(struct unit_test_state *uts)
+{
+	struct env_entry item, *ritem;
+	struct hsearch_data htab;
+	char *buf, *saved = NULL;
+	ssize_t len;
+
+	/* Keep the environment, as this test replaces it */
+	len = hexport_r(&env_htab, '\0', 0, &saved, 0, 0, NULL);
+	ut_assert(len > 0);
+
+	memset(&item, 0, sizeof(item));
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+	ut_assertok(htab_fill(uts, &htab, SIZE));
+	item.key = ".flags";
+	item.data = "num:d";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	item.key = "num";
+	item.data = "12";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+
+	buf = calloc(1, INDEX_BUF_SIZE);
+	ut_assertnonnull(buf);
+	ut_assert(hexport_r(&htab, '\0', 0, &buf, INDEX_BUF_SIZE, 0,
+			    NULL) > 0);
+	ut_assertok(hexport_index(buf, INDEX_BUF_SIZE));
+	hdestroy_r(&htab);
+
+	ut_asserteq(1, himport_index_r(&env_htab, buf, INDEX_BUF_SIZE, 0));
+	free(buf);
+	ut_asserteq(SIZE + 2, env_htab.index_count);
+
+	/* This enters everything and drops the index once it is done */
+	ut_asserteq_str("num:d", env_get(".flags"));
+	ut_asserteq(0, env_htab.index_count);
+	ut_asserteq(SIZE + 2, env_htab.filled);
+	ut_asserteq_str("12", env_get("num"));
+	ut_asserteq_str("7", env_get("7"));
+
+	item.key = "num";
+	item.data = NULL;
+	ut_assert(hsearch_r(item, ENV_FIND, &ritem, &env_htab, 0));
+	ut_asserteq(env_flags_vartype_decimal,
+		    ritem->flags & ENV_FLAGS_VARTYPE_BIN_MASK);
+
+	ut_asserteq(1, himport_r(&env_htab, saved, len, '\0', 0, 0, 0, NULL));
+	free(saved);
+
+	return 0;
+}
+
+ENV_TEST(env_test_htab_index_flags, 0);
+#endif
+
+/* Measure a large environment: create, look up, export and import it */
+static int env_test_htab_bench(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	ulong start, fill, check, export, import;
+	char *res = NULL;
+	ssize_t len;
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+	size_t size;
+	char *buf;
+#endif
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	start = get_timer(0);
+	ut_assertok(htab_fill(uts, &htab, BENCH_SIZE));
+	fill = get_timer(start);
+
+	start = get_timer(0);
+	ut_assertok(htab_check_fill(uts, &htab, BENCH_SIZE));
+	check = get_timer(start);
+
+	start = get_timer(0);
+	len = hexport_r(&htab, '\0', 0, &res, 0, 0, NULL);
+	export = get_timer(start);
+	ut_assert(len > 0);
+
+	start = get_timer(0);
+	ut_asserteq(1, himport_r(&htab, res, len, '\0', 0, 0, 0, NULL));
+	import = get_timer(start);
+	ut_asserteq(BENCH_SIZE, htab.filled);
+	ut_assertok(htab_check_fill(uts, &htab, BENCH_SIZE));
+
+	printf("%d variables: fill %lu ms, find %lu ms, export %lu ms, import %lu ms\n",
+	       BENCH_SIZE, fill, check, export, import);
+
+#if CONFIG_IS_ENABLED(ENV_INDEX)
+	/* The same again with an index, which only costs on lookup */
+	size = len + BENCH_SIZE * sizeof(u32) + sizeof(struct env_index_tail);
+	buf = calloc(1, size);
+	ut_assertnonnull(buf);
+	memcpy(buf, res, len);
+	ut_assertok(hexport_index(buf, size));
+
+	start = get_timer(0);
+	ut_asserteq(1, himport_index_r(&htab, buf, size, 0));
+	import = get_timer(start);
+	ut_asserteq(0, htab.filled);
+
+	start = get_timer(0);
+	ut_assertok(htab_check_fill(uts, &htab, BENCH_SIZE));
+	check = get_timer(start);
+	ut_asserteq(BENCH_SIZE, htab.filled);
+	free(buf);
+
+	printf("%d variables with an index: import %lu ms, find %lu ms\n",
+	       BENCH_SIZE, import, check);
+#endif
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_bench, 0);
@@ -0,0 +1,116 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0+
+
+# This script compares the time U-Boot takes to read a file from a FAT
+# filesystem when the file is stored contiguously and when it is badly
+# fragmented.
+#
+# FAT reads each run of consecutive clusters of a file with one disk
+# access, and keep recently used FAT sectors between reads. With that, the fragmented file should not take much longer to
+# load than the contiguous one.
+#
+# To execute the benchmark, simply run it from the U-Boot source root
+# directory:
+#
+#    cd u-boot
+#    ./test/fs/fat-extent-bench.sh
+#
+# Two FAT filesystem images are created, one holding a contiguous file and
+# one holding a file of the same size scattered over many one-cluster free
+# areas. U-Boot sandbox is built, then loads each file several times, prints
+# the time taken and checks the CRC of the data read. The important parts of
+# the log are the "time:" lines and the "PASS" or "FAILURE" lines.
+#
+# All temporary files used by this script are created in ./sandbox to avoid
+# polluting the source tree, as done by test/fs/fat-noncontig-test.sh.
+
+odir=sandbox
+mnt=${odir}/mnt
+fill=/dev/urandom
+testfn=bench.img
+crcaddr=0
+loadaddr=1000
+# Size of the test file in 512-byte sectors
+sects=$((16 * 1024 * 2))
+loops=10
+# Number of filler files per directory, well below the FAT limit of 65536
+# entries in a directory
+perdir=4096
+
+for prereq in fallocate mkfs.fat dd crc32; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
+
+mkdir -p ${mnt}
+
+# create_image <image> <fragment>
+# Sets crc to the CRC of the test file, in the byte order used by itest.l
+create_image() {
+    img=$1
+
+    rm -f ${img}
+    fallocate -l 64M ${img} || exit $?
+    # One sector per cluster makes for the longest cluster chain
+    mkfs.fat -F 32 -s 1 ${img} >/dev/null || exit $?
+
+    sudo mount -o loop,uid=$(id -u) ${img} ${mnt} || exit $?
+
+    if [ $2 -ne 0 ]; then
+        # Fill the disk with one-cluster files, then free every other one
+        for ((i = 0; i < 2 * sects + 64; i++)); do
+            dir=${mnt}/d-$((i / perdir))
+            [ $((i % perdir)) -eq 0 ] && mkdir ${dir}
+            dd if=/dev/zero of=${dir}/f-${i} bs=512 count=1 \
+                >/dev/null 2>&1 || break
+        done
+        for ((i = 0; i < 2 * sects + 64; i += 2)); do
+            rm -f ${mnt}/d-$((i / perdir))/f-${i}
+        done
+    fi
+
+    dd if=${fill} of=${mnt}/${testfn} bs=512 count=${sects} >/dev/null 2>&1
+    crc=0x`crc32 ${mnt}/${testfn}`
+
+    sudo umount ${mnt} || exit $?
+
+    crc=`printf %02x%02x%02x%02x \
+        $((${crc} & 0xff)) \
+        $(((${crc} >> 8) & 0xff)) \
+        $(((${crc} >> 16) & 0xff)) \
+        $((${crc} >> 24))`
+}
+
+bench=
+for ((i = 0; i < loops; i++)); do
+    bench="${bench}load host 0:0 ${loadaddr} ${testfn}; "
+done
+
+for frag in 0 1; do
+    img=${odir}/fat-bench-${frag}.img
+    create_image ${img} ${frag}
+
+    if [ ${frag} -ne 0 ]; then
+        echo "== fragmented: ${loops} loads of $((sects / 2)) KiB =="
+    else
+        echo "== contiguous: ${loops} loads of $((sects / 2)) KiB =="
+    fi
+
+    ./sandbox/u-boot << EOF
+host bind 0 ${img}
+setenv bench '${bench}'
+time run bench
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${crc}; then echo FAILURE; else echo PASS; fi
+reset
+EOF
+    status=$?
+    if [ ${status} -ne 0 ]; then
+        echo U-Boot exit status indicates an error
+        exit ${status}
+    fi
+done
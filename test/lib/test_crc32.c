@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the CRC32 and CRC32C functions
+ *
+ * The optimised implementations handle unaligned heads, whole words and short
+ * tails separately, so each length and alignment up to a few words is checked
+ * against a bit-at-a-time reference.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+
+#define CRC32_POLY	0xedb88320
+#define CRC32C_POLY	0x82f63b78
+
+/* Alignments and lengths checked against the reference */
+#define SWEEP		16
+#define MAX_LEN		80
+
+/* Size of the buffer used for the benchmark, and how often it is hashed */
+#define BENCH_SIZE	SZ_1M
+#define BENCH_LOOPS	16
+
+static u32 crc_ref(u32 poly, u32 crc, const u8 *p, uint len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void fill_buf(u8 *buf, uint len)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (i * 167 + (i >> 7)) & 0xff;
+}
+
+/* Test the well-known check values */
+static int lib_test_crc32_check(struct unit_test_state *uts)
+{
+	const u8 *check = (const u8 *)"123456789";
+
+	ut_asserteq(0xcbf43926, crc32(0, check, 9));
+	ut_asserteq(0, crc32(0, check, 0));
+	/* Computing in pieces gives the same result */
+	ut_asserteq(0xcbf43926, crc32(crc32(0, check, 4), check + 4, 5));
+#ifdef CONFIG_CRC32C
+	{
+		u32 table[256];
+
+		crc32c_init(table, CRC32C_POLY);
+		ut_asserteq(0xe3069283,
+			    crc32c_cal(~0, (const char *)check, 9, table) ^ ~0);
+	}
+#endif
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_check, 0);
+
+/* Test all alignments and short lengths against the reference */
+static int lib_test_crc32_sweep(struct unit_test_state *uts)
+{
+	u8 buf[SWEEP + MAX_LEN];
+	uint offset, len;
+#ifdef CONFIG_CRC32C
+	u32 table[256];
+
+	crc32c_init(table, CRC32C_POLY);
+#endif
+
+	fill_buf(buf, sizeof(buf));
+	for (offset = 0; offset < SWEEP; offset++) {
+		for (len = 0; len <= MAX_LEN; len++) {
+			const u8 *p = buf + offset;
+
+			ut_asserteq(crc_ref(CRC32_POLY, 0x12345678, p, len),
+				    crc32_no_comp(0x12345678, p, len));
+			ut_asserteq(crc_ref(CRC32_POLY, ~0, p, len) ^ ~0,
+				    crc32(0, p, len));
+#ifdef CONFIG_CRC32C
+			ut_asserteq(crc_ref(CRC32C_POLY, ~0, p, len),
+				    crc32c_cal(~0, (const char *)p, len,
+					       table));
+#endif
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_sweep, 0);
+
+/* Measure the throughput of crc32() on a large buffer */
+static int lib_test_crc32_bench(struct unit_test_state *uts)
+{
+	ulong start, time;
+	u32 crc = 0;
+	u8 *buf;
+	int i;
+
+	buf = malloc(BENCH_SIZE);
+	ut_assertnonnull(buf);
+	fill_buf(buf, BENCH_SIZE);
+
+	/* A megabyte is too much for the reference, check a part of it */
+	ut_asserteq(crc_ref(CRC32_POLY, ~0, buf, SZ_64K) ^ ~0,
+		    crc32(0, buf, SZ_64K));
+
+	start = get_timer(0);
+	for (i = 0; i < BENCH_LOOPS; i++)
+		crc = crc32(crc, buf, BENCH_SIZE);
+	time = get_timer(start);
+	printf("crc32: %d MiB in %lu ms", BENCH_LOOPS, time);
+	if (time)
+		printf(", %lu MiB/s", BENCH_LOOPS * 1000 / time);
+	printf("\n");
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_bench, 0);
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for running jobs on secondary CPUs
+ *
+ * On sandbox the secondary CPUs are host threads, so the jobs really do run
+ * at the same time.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mp_job.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+
+#define NUM_JOBS	16
+#define JOB_SIZE	SZ_64K
+
+struct crc_job {
+	const u8 *buf;
+	uint len;
+	u32 crc;
+	int fail;
+};
+
+static int crc_job_run(void *arg)
+{
+	struct crc_job *job = arg;
+
+	if (job->fail)
+		return job->fail;
+	job->crc = crc32(0, job->buf, job->len);
+
+	return 0;
+}
+
+static void setup_jobs(struct mp_job *jobs, struct crc_job *crc_jobs,
+		       const u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < NUM_JOBS; i++) {
+		crc_jobs[i].buf = buf + i * JOB_SIZE;
+		crc_jobs[i].len = JOB_SIZE - i;
+		crc_jobs[i].crc = 0;
+		crc_jobs[i].fail = 0;
+		jobs[i].func = crc_job_run;
+		jobs[i].arg = &crc_jobs[i];
+		jobs[i].ret = -EBUSY;
+	}
+}
+
+/* Test that each job runs once and gives the same result as run in turn */
+static int lib_test_mp_job_run(struct unit_test_state *uts)
+{
+	struct crc_job crc_jobs[NUM_JOBS];
+	struct mp_job jobs[NUM_JOBS];
+	u8 *buf;
+	int i;
+
+	ut_asserteq(CONFIG_MP_JOBS_CPUS, mp_job_cpus());
+	buf = malloc(NUM_JOBS * JOB_SIZE);
+	ut_assertnonnull(buf);
+	for (i = 0; i < NUM_JOBS * JOB_SIZE; i++)
+		buf[i] = (i * 31 + (i >> 9)) & 0xff;
+
+	setup_jobs(jobs, crc_jobs, buf);
+	ut_assertok(mp_run_jobs(jobs, NUM_JOBS));
+	for (i = 0; i < NUM_JOBS; i++) {
+		ut_assertok(jobs[i].ret);
+		ut_asserteq(crc32(0, crc_jobs[i].buf, crc_jobs[i].len),
+			    crc_jobs[i].crc);
+	}
+
+	/* Fewer jobs than CPUs, and no jobs at all */
+	setup_jobs(jobs, crc_jobs, buf);
+	ut_assertok(mp_run_jobs(jobs, 1));
+	ut_asserteq(crc32(0, buf, JOB_SIZE), crc_jobs[0].crc);
+	ut_assertok(mp_run_jobs(jobs, 0));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_mp_job_run, 0);
+
+/* Test that an error from a job is returned and the other jobs still run */
+static int lib_test_mp_job_error(struct unit_test_state *uts)
+{
+	struct crc_job crc_jobs[NUM_JOBS];
+	struct mp_job jobs[NUM_JOBS];
+	u8 *buf;
+	int i;
+
+	buf = calloc(NUM_JOBS, JOB_SIZE);
+	ut_assertnonnull(buf);
+
+	setup_jobs(jobs, crc_jobs, buf);
+	crc_jobs[5].fail = -EINVAL;
+	crc_jobs[9].fail = -EIO;
+	ut_asserteq(-EINVAL, mp_run_jobs(jobs, NUM_JOBS));
+	for (i = 0; i < NUM_JOBS; i++) {
+		ut_asserteq(crc_jobs[i].fail, jobs[i].ret);
+		if (!crc_jobs[i].fail)
+			ut_asserteq(crc32(0, crc_jobs[i].buf, crc_jobs[i].len),
+				    crc_jobs[i].crc);
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_mp_job_error, 0);
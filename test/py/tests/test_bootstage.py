@@ -0,0 +1,53 @@
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Check the Chrome trace-event JSON written by 'bootstage export'
+
+import json
+import os
+import pytest
+import u_boot_utils as util
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_timeline')
+def test_bootstage_export(u_boot_console):
+    cons = u_boot_console
+    disk = os.path.join(cons.config.build_dir, 'bootstage-disk.img')
+    out = os.path.join(cons.config.build_dir, 'bootstage-timeline.json')
+    addr = util.find_ram_base(cons) + 0x100000
+
+    # Read a few blocks so that the timeline has a block transfer in it
+    with open(disk, 'wb') as fd:
+        fd.write(bytes(0x10000))
+    cons.run_command('host bind 0 %s' % disk)
+    output = cons.run_command('read host 0 %x 0 8' % addr)
+    assert 'error' not in output.lower()
+
+    output = cons.run_command('bootstage export %x' % addr)
+    assert 'bytes written' in output
+    cons.run_command('host save hostfs - %x %s ${filesize}' % (addr, out))
+    cons.run_command('host bind 0')
+
+    with open(out) as fd:
+        trace = json.load(fd)
+
+    events = trace['traceEvents']
+    names = {e['tid']: e['args']['name'] for e in events if e['ph'] == 'M'}
+    assert names == {0: 'bootstage', 1: 'probe', 2: 'blk', 3: 'net'}
+
+    spans = [e for e in events if e['ph'] == 'X']
+    for span in spans:
+        assert span['pid'] == 1
+        assert isinstance(span['ts'], int) and span['ts'] >= 0
+        assert isinstance(span['dur'], int) and span['dur'] >= 0
+    cats = [span['cat'] for span in spans]
+    assert 'stage' in cats
+    assert 'probe' in cats
+
+    # The read above is the last block transfer
+    reads = [span for span in spans if span['cat'] == 'blk_read']
+    assert reads
+    assert reads[-1]['tid'] == 2
+    assert reads[-1]['args']['bytes'] == 8 * 512
+
+    assert int(trace['otherData']['dropped']) >= 0
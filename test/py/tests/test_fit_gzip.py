@@ -0,0 +1,186 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check that unsigned gzip images in a FIT are hashed while they are
+# decompressed (CONFIG_FIT_STREAM_DECOMP)
+
+import os
+import pytest
+import u_boot_utils as util
+
+base_its = '''
+/dts-v1/;
+
+/ {
+        description = "FIT with unsigned gzip images";
+        #address-cells = <1>;
+
+        images {
+                kernel-1 {
+                        data = /incbin/("%(kernel)s");
+                        type = "kernel";
+                        arch = "sandbox";
+                        os = "linux";
+                        compression = "none";
+                        load = <0x40000>;
+                        entry = <0x8>;
+                };
+                fdt-1 {
+                        data = /incbin/("%(fdt)s");
+                        type = "flat_dt";
+                        arch = "sandbox";
+                        compression = "gzip";
+                        load = <%(fdt_addr)#x>;
+                        hash-1 {
+                                algo = "sha1";
+                        };
+                };
+                firmware-1 {
+                        data = /incbin/("%(firmware)s");
+                        type = "firmware";
+                        arch = "sandbox";
+                        os = "u-boot";
+                        compression = "gzip";
+                        load = <%(firmware_addr)#x>;
+                        hash-1 {
+                                algo = "crc32";
+                        };
+                        hash-2 {
+                                algo = "sha256";
+                        };
+                };
+        };
+        configurations {
+                default = "conf-1";
+                conf-1 {
+                        kernel = "kernel-1";
+                        fdt = "fdt-1";
+                        loadables = "firmware-1";
+                };
+        };
+};
+'''
+
+# Control FDT without a /signature node, so that no key can be required
+base_fdt = '''
+/dts-v1/;
+
+/ {
+	#address-cells = <1>;
+	#size-cells = <0>;
+
+	model = "Sandbox FIT gzip Test";
+	compatible = "sandbox";
+};
+'''
+
+base_script = '''
+host load hostfs 0 %(fit_addr)x %(fit)s
+fdt addr %(fit_addr)x
+%(fit_change)s
+bootm start %(fit_addr)x
+host save hostfs 0 %(fdt_addr)x %(fdt_out)s %(fdt_size)x
+host save hostfs 0 %(firmware_addr)x %(firmware_out)s %(firmware_size)x
+'''
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit_stream_decomp')
+@pytest.mark.requiredtool('dtc')
+def test_fit_gzip(u_boot_console):
+    def make_fname(leaf):
+        return os.path.join(cons.config.build_dir, leaf)
+
+    def read_file(fname):
+        with open(fname, 'rb') as fd:
+            return fd.read()
+
+    def make_dtb():
+        src = make_fname('fit-gzip-u-boot.dts')
+        dtb = make_fname('fit-gzip-u-boot.dtb')
+        with open(src, 'w') as fd:
+            fd.write(base_fdt)
+        util.run_and_log(cons, ['dtc', src, '-O', 'dtb', '-o', dtb])
+        return dtb
+
+    def make_file(leaf, data):
+        fname = make_fname(leaf)
+        with open(fname, 'wb') as fd:
+            fd.write(data)
+        return fname
+
+    def make_compressed(fname):
+        util.run_and_log(cons, ['gzip', '-f', '-k', fname])
+        return fname + '.gz'
+
+    def make_fit(params):
+        its = make_fname('fit-gzip.its')
+        fit = make_fname('fit-gzip.fit')
+        with open(its, 'w') as fd:
+            print(base_its % params, file=fd)
+        util.run_and_log(cons, [mkimage, '-f', its, fit])
+        return fit
+
+    def run_script(params):
+        cons.restart_uboot()
+        return '\n'.join(cons.run_command_list(
+            (base_script % params).splitlines()))
+
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    control_dtb = make_dtb()
+    kernel = make_file('fit-gzip-kernel.bin', b'not a kernel\n' * 100)
+
+    # Firmware which compresses to about a third of its size
+    data = b''.join(b'%d firmware line %x\n' % (i, i * 7919 % 65521)
+                    for i in range(4000))
+    firmware = make_file('fit-gzip-firmware.bin', data)
+
+    params = {
+        'fit_addr' : 0x1000,
+        'kernel' : kernel,
+        'fdt' : make_compressed(control_dtb),
+        'fdt_addr' : 0x80000,
+        'fdt_out' : make_fname('fit-gzip-fdt-out.dtb'),
+        'fdt_size' : len(read_file(control_dtb)),
+        'firmware' : make_compressed(firmware),
+        'firmware_addr' : 0x100000,
+        'firmware_out' : make_fname('fit-gzip-firmware-out.bin'),
+        'firmware_size' : len(data),
+        'fit_change' : '',
+    }
+    params['fit'] = make_fit(params)
+
+    old_dtb = cons.config.dtb
+    try:
+        cons.config.dtb = control_dtb
+
+        with cons.log.section('Unsigned gzip images'):
+            output = run_script(params)
+            assert 'Bad Data Hash' not in output
+            assert output.count('Verifying Hash Integrity ... ') >= 2
+            assert 'sha1+ OK' in output
+            assert 'crc32+ sha256+ OK' in output
+            assert (read_file(params['fdt_out']) ==
+                    read_file(control_dtb)), 'FDT not decompressed'
+            assert (read_file(params['firmware_out']) ==
+                    data), 'Firmware not decompressed'
+
+        with cons.log.section('Bad hash of gzip image'):
+            params['fit_change'] = ('fdt set /images/firmware-1/hash-2 value '
+                                    '[%s]' % ' '.join(['00'] * 32))
+            output = run_script(params)
+            assert 'Bad hash value' in output
+            assert 'Bad Data Hash' in output
+
+        # Zeros compress so well that they do not fit in the buffer which
+        # fit_image_load() allows for decompressing
+        with cons.log.section('Truncated gzip image'):
+            params['fit_change'] = ''
+            firmware = make_file('fit-gzip-firmware.bin', bytes(0x40000))
+            params['firmware'] = make_compressed(firmware)
+            params['fit'] = make_fit(params)
+            output = run_script(params)
+            assert 'gunzip output buffer too small' in output
+            assert 'Error decompressing' in output
+    finally:
+        cons.config.dtb = old_dtb
+        cons.restart_uboot()
@@ -0,0 +1,61 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: Block Cache Test
+
+"""
+This test measures how much the block cache speeds up reading a file system.
+"""
+
+import pytest
+import re
+from fstest_defs import *
+
+def walk_fs(u_boot_console, fs_type):
+    """Walk the file system with the current cache settings
+
+    Return:
+        A tuple of the time taken in seconds and the number of reads which
+        went to the device.
+    """
+    cmd = ('%sls host 0:0; %sls host 0:0 /SUBDIR; '
+           '%ssize host 0:0 /%s; %sload host 0:0 %x /%s'
+           % (fs_type, fs_type, fs_type, SMALL_FILE, fs_type, ADDR,
+              SMALL_FILE))
+    output = u_boot_console.run_command_list([
+        'blkcache show',
+        'setenv walk "%s"' % cmd,
+        'time run walk',
+        'blkcache show',
+        'setenv walk'])
+    assert('filesize=100000' in u_boot_console.run_command('printenv filesize'))
+    secs = float(re.search(r'time: ([0-9.]+) seconds', output[2]).group(1))
+    misses = int(re.search(r'misses: (\d+)', output[3]).group(1))
+    return secs, misses
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_block_cache')
+@pytest.mark.buildconfigspec('cmd_time')
+@pytest.mark.slow
+class TestFsBlkcache(object):
+    def test_fs_blkcache(self, u_boot_console, fs_obj_basic):
+        """
+        Test Case 1 - walk a file system without and with the block cache
+        """
+        fs_type,fs_img,md5val = fs_obj_basic
+        with u_boot_console.log.section('Test Case 1 - block cache'):
+            u_boot_console.run_command('host bind 0 %s' % fs_img)
+
+            # Each miss is one read from the device, with or without the
+            # cache; changing the settings empties the cache
+            u_boot_console.run_command('blkcache configure 8 0 0')
+            nocache_secs, nocache_reads = walk_fs(u_boot_console, fs_type)
+            u_boot_console.run_command('blkcache configure 8 32 32')
+            cache_secs, cache_reads = walk_fs(u_boot_console, fs_type)
+
+            u_boot_console.log.info(
+                'without cache: %d reads in %.3f s, with cache: %d reads '
+                'in %.3f s, speedup %.2f' %
+                (nocache_reads, nocache_secs, cache_reads, cache_secs,
+                 nocache_secs / max(cache_secs, 0.001)))
+            assert(cache_reads < nocache_reads)
+            u_boot_console.run_command('host bind 0')
@@ -548,6 +548,116 @@ class DtbPlatdata(object):
             self.output_node(node)
             nodes_to_output.remove(node)
 
+    def generate_live_tree(self):
+        """Generate a live tree for the whole device tree
+
+        This writes out a struct device_node for each node and a struct
+        property for each property, linked together the same way as
+        unflatten_device_tree() in lib/of_live.c links them, so that SPL can
+        use a live tree without unflattening the device tree. The root node is
+        the first entry of dt_live_nodes[].
+        """
+        nodes = []
+        node_props = []
+        data = bytearray()
+
+        def _scan(node):
+            nodes.append(node)
+            for subnode in node.subnodes:
+                _scan(subnode)
+
+        _scan(self._fdt.GetRoot())
+        index = {id(node): i for i, node in enumerate(nodes)}
+
+        for node in nodes:
+            props = [(prop.name, prop.bytes) for prop in node.props.values()]
+
+            # Add a 'name' property if there is none, as of_live.c does
+            if 'name' not in node.props:
+                name = '' if node.parent is None else node.name.split('@')[0]
+                props.append(('name', name.encode('utf-8') + b'\0'))
+            node_props.append([])
+            for pname, value in props:
+                node_props[-1].append((pname, len(value), len(data)))
+                data += value
+                data += bytes(-len(data) % 4)
+
+        def _get_str(node_idx, pname, default):
+            for name, length, offset in node_props[node_idx]:
+                if name == pname:
+                    value = bytes(data[offset:offset + length])
+                    return value.split(b'\0')[0].decode('utf-8')
+            return default
+
+        def _get_phandle(node_idx):
+            phandle = 0
+            for name, length, offset in node_props[node_idx]:
+                if name not in ('phandle', 'linux,phandle', 'ibm,phandle'):
+                    continue
+                cell = fdt_util.fdt32_to_cpu(bytes(data[offset:offset + 4]))
+                if name == 'ibm,phandle' or not phandle:
+                    phandle = cell
+            return phandle
+
+        def _node_ref(node):
+            return '&dt_live_nodes[%d]' % index[id(node)] if node else 'NULL'
+
+        num_props = sum(len(props) for props in node_props)
+        self.out_header()
+        self.out('#include <common.h>\n')
+        self.out('#include <dm/of.h>\n')
+        self.out('\n')
+        self.out('static struct property dtl_prop[%d];\n' % num_props)
+        self.out('\n')
+        self.out('static unsigned char dtl_data[] __aligned(4) = {\n')
+        for i in range(0, len(data), 8):
+            self.out('\t%s,\n' % ', '.join('%#04x' % byte
+                                            for byte in data[i:i + 8]))
+        self.out('};\n')
+        self.out('\n')
+
+        self.out('struct device_node dt_live_nodes[] = {\n')
+        for i, node in enumerate(nodes):
+            parent = node.parent
+            sibling = None
+            if parent:
+                pos = parent.subnodes.index(node)
+                if pos + 1 < len(parent.subnodes):
+                    sibling = parent.subnodes[pos + 1]
+            child = node.subnodes[0] if node.subnodes else None
+            self.out('\t[%d] = {\n' % i)
+            self.out('\t\t.name\t\t= "%s",\n' % _get_str(i, 'name', '<NULL>'))
+            self.out('\t\t.type\t\t= "%s",\n' %
+                     _get_str(i, 'device_type', '<NULL>'))
+            self.out('\t\t.phandle\t= %#x,\n' % _get_phandle(i))
+            self.out('\t\t.full_name\t= "%s",\n' % node.path)
+            if node_props[i]:
+                first = sum(len(props) for props in node_props[:i])
+                self.out('\t\t.properties\t= &dtl_prop[%d],\n' % first)
+            self.out('\t\t.parent\t\t= %s,\n' % _node_ref(parent))
+            self.out('\t\t.child\t\t= %s,\n' % _node_ref(child))
+            self.out('\t\t.sibling\t= %s,\n' % _node_ref(sibling))
+            self.out('\t},\n')
+        self.out('};\n')
+        self.out('\n')
+
+        self.out('static struct property dtl_prop[%d] = {\n' % num_props)
+        prop_idx = 0
+        for props in node_props:
+            for i, (pname, length, offset) in enumerate(props):
+                if i + 1 < len(props):
+                    next_ref = '&dtl_prop[%d]' % (prop_idx + 1)
+                else:
+                    next_ref = 'NULL'
+                self.out('\t[%d] = {\n' % prop_idx)
+                self.out('\t\t.name\t\t= (char *)"%s",\n' % pname)
+                self.out('\t\t.length\t\t= %d,\n' % length)
+                self.out('\t\t.value\t\t= &dtl_data[%d],\n' % offset)
+                self.out('\t\t.next\t\t= %s,\n' % next_ref)
+                self.out('\t},\n')
+                prop_idx += 1
+        self.out('};\n')
+
 
 def run_steps(args, dtb_file, include_disabled, output):
     """Run all the steps of the dtoc tool
@@ -559,21 +669,28 @@ def run_steps(args, dtb_file, include_disabled, output):
         output: Name of output file
     """
     if not args:
-        raise ValueError('Please specify a command: struct, platdata')
+        raise ValueError('Please specify a command: struct, platdata, '
+                         'livetree')
 
     plat = DtbPlatdata(dtb_file, include_disabled)
     plat.scan_dtb()
-    plat.scan_tree()
-    plat.scan_reg_sizes()
     plat.setup_output(output)
-    structs = plat.scan_structs()
-    plat.scan_phandles()
+    cmds = args[0].split(',')
+
+    # The live tree covers all nodes, so needs none of the scanning below
+    if cmds != ['livetree']:
+        plat.scan_tree()
+        plat.scan_reg_sizes()
+        structs = plat.scan_structs()
+        plat.scan_phandles()
 
-    for cmd in args[0].split(','):
+    for cmd in cmds:
         if cmd == 'struct':
             plat.generate_structs(structs)
         elif cmd == 'platdata':
             plat.generate_tables()
+        elif cmd == 'livetree':
+            plat.generate_live_tree()
         else:
-            raise ValueError("Unknown command '%s': (use: struct, platdata)" %
-                             cmd)
+            raise ValueError("Unknown command '%s': (use: struct, platdata, "
+                             "livetree)" % cmd)
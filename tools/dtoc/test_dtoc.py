@@ -707,5 +707,49 @@ U_BOOT_DEVICE(spl_test2) = {
         output = tools.GetOutputFilename('output')
         with self.assertRaises(ValueError) as e:
             dtb_platdata.run_steps(['invalid-cmd'], dtb_file, False, output)
-        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata)",
-                      str(e.exception))
+        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata, "
+                      "livetree)", str(e.exception))
+
+    def testLiveTree(self):
+        """Test output of a live tree"""
+        dtb_file = get_dtb_file('dtoc_test_simple.dts')
+        output = tools.GetOutputFilename('output')
+        dtb_platdata.run_steps(['livetree'], dtb_file, False, output)
+        with open(output) as infile:
+            data = infile.read()
+
+        # The root node gets an empty name, as of_live.c gives it
+        self.assertIn('''\t[0] = {
+\t\t.name\t\t= "",
+\t\t.type\t\t= "<NULL>",
+\t\t.phandle\t= 0x0,
+\t\t.full_name\t= "/",
+\t\t.properties\t= &dtl_prop[0],
+\t\t.parent\t\t= NULL,
+\t\t.child\t\t= &dt_live_nodes[1],
+\t\t.sibling\t= NULL,
+\t},''', data)
+        self.assertIn('''\t[1] = {
+\t\t.name\t\t= "spl-test",
+\t\t.type\t\t= "<NULL>",
+\t\t.phandle\t= 0x0,
+\t\t.full_name\t= "/spl-test",
+\t\t.properties\t= &dtl_prop[3],
+\t\t.parent\t\t= &dt_live_nodes[0],
+\t\t.child\t\t= NULL,
+\t\t.sibling\t= &dt_live_nodes[2],
+\t},''', data)
+
+        # Properties keep their order, with the added 'name' at the end
+        self.assertIn('''\t[2] = {
+\t\t.name\t\t= (char *)"name",
+\t\t.length\t\t= 1,
+\t\t.value\t\t= &dtl_data[8],
+\t\t.next\t\t= NULL,
+\t},
+\t[3] = {
+\t\t.name\t\t= (char *)"u-boot,dm-pre-reloc",
+\t\t.length\t\t= 0,
+\t\t.value\t\t= &dtl_data[12],
+\t\t.next\t\t= &dtl_prop[4],
+\t},''', data)
@@ -22,6 +22,7 @@
 #include <sys/mman.h>
 
 #include "compiler.h"
+#include <env_index.h>
 #include <u-boot/crc.h>
 #include <version.h>
 
@@ -29,7 +30,7 @@
 
 static void usage(const char *exec_name)
 {
-	fprintf(stderr, "%s [-h] [-r] [-b] [-p <byte>] -s <environment partition size> -o <output> <input file>\n"
+	fprintf(stderr, "%s [-h] [-r] [-b] [-i] [-p <byte>] -s <environment partition size> -o <output> <input file>\n"
 	       "\n"
 	       "This tool takes a key=value input file (same as would a `printenv' show) and generates the corresponding environment image, ready to be flashed.\n"
 	       "\n"
@@ -42,6 +43,7 @@ static void usage(const char *exec_name)
 	       "\t-r : the environment has multiple copies in flash\n"
 	       "\t-b : the target is big endian (default is little endian)\n"
 	       "\t-p <byte> : fill the image with <byte> bytes instead of 0xff bytes\n"
+	       "\t-i : add an index for U-Boot to look up variables in place\n"
 	       "\t-V : print version information and exit\n"
 	       "\n"
 	       "If the input file is \"-\", data is read from standard input\n",
@@ -68,6 +70,115 @@ long int xstrtol(const char *s)
 
 #define CHUNK_SIZE 4096
 
+static const char *sort_env;
+
+/* Compare the names of two entries, like strcmp() but ending at '=' */
+static int cmp_names(const char *n1, const char *n2)
+{
+	unsigned char c1, c2;
+
+	do {
+		c1 = *n1++;
+		c2 = *n2++;
+		if (c1 == '=')
+			c1 = '\0';
+		if (c2 == '=')
+			c2 = '\0';
+	} while (c1 && c1 == c2);
+
+	return c1 - c2;
+}
+
+/* Sort entries by name, and entries of the same variable in order */
+static int cmp_entries(const void *p1, const void *p2)
+{
+	uint32_t off1 = *(const uint32_t *)p1;
+	uint32_t off2 = *(const uint32_t *)p2;
+	int ret;
+
+	ret = cmp_names(sort_env + off1, sort_env + off2);
+	if (ret)
+		return ret;
+
+	return off1 < off2 ? -1 : off1 > off2;
+}
+
+/*
+ * Add an index of the variables at the end of the environment, see
+ * env_index.h. The entries are taken as U-Boot imports them: the last one
+ * of a variable counts, and an empty one deletes it.
+ */
+static int add_index(unsigned char *envptr, unsigned int envsize,
+		     unsigned int listsize, int bigendian)
+{
+	const char *env = (const char *)envptr;
+	struct env_index_tail tail;
+	unsigned int count, i, n, off;
+	unsigned char *index;
+	uint32_t *offs;
+
+	offs = malloc(listsize * sizeof(*offs));
+	if (!offs) {
+		fprintf(stderr, "Can't alloc memory for the index\n");
+		return -1;
+	}
+
+	for (off = 0, count = 0; env[off]; off += strlen(env + off) + 1) {
+		unsigned int start = off;
+
+		while (env[start] == ' ' || env[start] == '\t')
+			start++;
+		if (!env[start] || env[start] == '#')
+			continue;
+		if (env[start] == '=') {
+			fprintf(stderr, "Variable without a name: %s\n",
+				env + start);
+			return -1;
+		}
+		offs[count++] = start;
+	}
+
+	sort_env = env;
+	qsort(offs, count, sizeof(*offs), cmp_entries);
+
+	for (i = 0, n = 0; i < count; i++) {
+		const char *value;
+
+		if (i + 1 < count && !cmp_names(env + offs[i], env + offs[i + 1]))
+			continue;
+		value = strchr(env + offs[i], '=');
+		if (!value || !value[1])
+			continue;
+		offs[n++] = offs[i];
+	}
+
+	if (listsize + n * sizeof(*offs) + sizeof(tail) > envsize) {
+		fprintf(stderr, "The environment file is too large for the target environment storage with an index\n");
+		return -1;
+	}
+
+	index = envptr + envsize - sizeof(tail) - n * sizeof(*offs);
+	for (i = 0; i < n; i++) {
+		off = bigendian ? cpu_to_be32(offs[i]) : cpu_to_le32(offs[i]);
+		memcpy(index, &off, sizeof(off));
+		index += sizeof(off);
+	}
+	free(offs);
+
+	tail.list_size = listsize;
+	tail.list_crc = crc32(0, envptr, listsize);
+	tail.count = n;
+	tail.magic = ENV_INDEX_MAGIC;
+	for (i = 0; i < sizeof(tail) / sizeof(uint32_t); i++) {
+		uint32_t *field = (uint32_t *)&tail + i;
+
+		*field = bigendian ? cpu_to_be32(*field) : cpu_to_le32(*field);
+	}
+	memcpy(index, &tail, sizeof(tail));
+
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
 	uint32_t crc, targetendian_crc;
@@ -78,6 +189,7 @@ int main(int argc, char **argv)
 	unsigned int filesize = 0, envsize = 0, datasize = 0;
 	int bigendian = 0;
 	int redundant = 0;
+	int indexed = 0;
 	unsigned char padbyte = 0xff;
 	int readbytes = 0;
 
@@ -93,7 +205,7 @@ int main(int argc, char **argv)
 	opterr = 0;
 
 	/* Parse the cmdline */
-	while ((option = getopt(argc, argv, ":s:o:rbp:hV")) != -1) {
+	while ((option = getopt(argc, argv, ":s:o:rbip:hV")) != -1) {
 		switch (option) {
 		case 's':
 			datasize = xstrtol(optarg);
@@ -111,6 +223,9 @@ int main(int argc, char **argv)
 		case 'b':
 			bigendian = 1;
 			break;
+		case 'i':
+			indexed = 1;
+			break;
 		case 'p':
 			padbyte = xstrtol(optarg);
 			break;
@@ -254,6 +369,9 @@ int main(int argc, char **argv)
 		envptr[ep] = '\0';
 	}
 
+	if (indexed && add_index(envptr, envsize, ep + 1, bigendian))
+		return EXIT_FAILURE;
+
 	/* Computes the CRC and put it at the beginning of the data */
 	crc = crc32(0, envptr, envsize);
 	targetendian_crc = bigendian ? cpu_to_be32(crc) : cpu_to_le32(crc);
@@ -22,6 +22,9 @@
 
 #define MAX_LINE_LEN 500
 
+/* Track (thread ID) of function calls in Chrome trace output */
+#define TRACE_CHROME_TID	10
+
 enum {
 	FUNCF_TRACE	= 1 << 0,	/* Include this function in trace */
 };
@@ -85,8 +88,10 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-chrome\t\tDump out JSON data in Chrome trace format\n"
 		"\n"
 		"Options:\n"
+		"   -b <json>\tAdd to output of 'bootstage export' (dump-chrome)\n"
 		"   -m <map>\tSpecify Systen.map file\n"
 		"   -t <trace>\tSpecific trace data file (from U-Boot)\n"
 		"   -v <0-4>\tSpecify verbosity\n");
@@ -532,9 +537,93 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/*
+ * Function calls are written as pairs of begin/end events on a track of their
+ * own. With a bootstage export (from 'bootstage export'), they are put into
+ * its event list, which starts after its first line, so that the two can be
+ * viewed together.
+ */
+static int make_chrome(const char *bootstage_fname)
+{
+	struct trace_call *call;
+	char buff[MAX_LINE_LEN];
+	FILE *bootstage = NULL;
+	ulong time, last = 0, base = 0;
+	int missing_count = 0, skip_count = 0;
+	int i;
+
+	if (bootstage_fname) {
+		bootstage = fopen(bootstage_fname, "r");
+		if (!bootstage) {
+			error("Cannot open bootstage file '%s'\n",
+			      bootstage_fname);
+			return -1;
+		}
+		if (!fgets(buff, sizeof(buff), bootstage) ||
+		    strcmp(buff, "{\"traceEvents\":[\n")) {
+			error("Bootstage file '%s' is not a timeline export\n",
+			      bootstage_fname);
+			fclose(bootstage);
+			return -1;
+		}
+	}
+
+	printf("{\"traceEvents\":[\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"trace\"}}",
+	       TRACE_CHROME_TID);
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = find_func_by_offset(call->func);
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!func) {
+			warn("Cannot find function at %lx\n",
+			     text_offset + call->func);
+			missing_count++;
+			continue;
+		}
+
+		if (!(func->flags & FUNCF_TRACE)) {
+			debug("Funcion '%s' is excluded from trace\n",
+			      func->name);
+			skip_count++;
+			continue;
+		}
+
+		/* The timestamp only has 30 bits, so unwrap it */
+		time = call->flags & FUNCF_TIMESTAMP_MASK;
+		if (time < last)
+			base += FUNCF_TIMESTAMP_MASK + 1UL;
+		last = time;
+
+		printf(",\n{\"name\":\"%s\",\"cat\":\"trace\",\"ph\":\"%s\",\"ts\":%lu,\"pid\":1,\"tid\":%d}",
+		       func->name,
+		       TRACE_CALL_TYPE(call) == FUNCF_ENTRY ? "B" : "E",
+		       base + time, TRACE_CHROME_TID);
+	}
+
+	if (bootstage) {
+		size_t len;
+
+		/* The export ends the list itself, after its own events */
+		printf(",\n");
+		while ((len = fread(buff, 1, sizeof(buff), bootstage)) > 0)
+			fwrite(buff, 1, len, stdout);
+		fclose(bootstage);
+	} else {
+		printf("\n],\n\"displayTimeUnit\":\"ms\"}\n");
+	}
+	info("chrome: %d functions not found, %d excluded\n", missing_count,
+	     skip_count);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char *const argv[],
 		     const char *prof_fname, const char *map_fname,
-		     const char *trace_config_fname)
+		     const char *trace_config_fname,
+		     const char *bootstage_fname)
 {
 	int err = 0;
 
@@ -552,6 +641,8 @@ static int prof_tool(int argc, char *const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-chrome"))
+			err = make_chrome(bootstage_fname);
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}
@@ -564,11 +655,16 @@ int main(int argc, char *argv[])
 	const char *map_fname = "System.map";
 	const char *prof_fname = NULL;
 	const char *trace_config_fname = NULL;
+	const char *bootstage_fname = NULL;
 	int opt;
 
 	verbose = 2;
-	while ((opt = getopt(argc, argv, "m:p:t:v:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:m:p:t:v:")) != -1) {
 		switch (opt) {
+		case 'b':
+			bootstage_fname = optarg;
+			break;
+
 		case 'm':
 			map_fname = optarg;
 			break;
@@ -595,5 +691,5 @@ int main(int argc, char *argv[])
 
 	debug("Debug enabled\n");
 	return prof_tool(argc, argv, prof_fname, map_fname,
-			 trace_config_fname);
+			 trace_config_fname, bootstage_fname);
 }
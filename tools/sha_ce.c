@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA1 and SHA256 block transforms for host tools built on arm64 Linux,
+ * using the ARMv8 Crypto Extensions through compiler intrinsics. The tools
+ * Makefile builds this file with -march=armv8-a+crypto.
+ */
+
+#include <arm_neon.h>
+#include <stdint.h>
+#include <sys/auxv.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+int sha1_ce_supported(void)
+{
+	return !!(getauxval(AT_HWCAP) & HWCAP_SHA1);
+}
+
+void sha1_ce_transform(uint32_t state[5], const uint8_t *src,
+		       unsigned int blocks)
+{
+	static const uint32_t k[4] = {
+		0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+	};
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32_t e = state[4];
+
+	do {
+		uint32x4_t abcd0 = abcd, w[4], wk;
+		uint32_t e0 = e, e1;
+		int i;
+
+		for (i = 0; i < 4; i++)
+			w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src +
+								       16 * i)));
+		for (i = 0; i < 20; i++) {
+			wk = vaddq_u32(w[i & 3], vdupq_n_u32(k[i / 5]));
+			if (i < 16)
+				w[i & 3] = vsha1su1q_u32(
+					vsha1su0q_u32(w[i & 3], w[(i + 1) & 3],
+						      w[(i + 2) & 3]),
+					w[(i + 3) & 3]);
+			e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (i < 5)
+				abcd = vsha1cq_u32(abcd, e, wk);
+			else if (i >= 10 && i < 15)
+				abcd = vsha1mq_u32(abcd, e, wk);
+			else
+				abcd = vsha1pq_u32(abcd, e, wk);
+			e = e1;
+		}
+		abcd = vaddq_u32(abcd, abcd0);
+		e += e0;
+		src += 64;
+	} while (--blocks);
+
+	vst1q_u32(state, abcd);
+	state[4] = e;
+}
+
+static const uint32_t sha256_ce_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+int sha256_ce_supported(void)
+{
+	return !!(getauxval(AT_HWCAP) & HWCAP_SHA2);
+}
+
+void sha256_ce_transform(uint32_t state[8], const uint8_t *src,
+			 unsigned int blocks)
+{
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32x4_t efgh = vld1q_u32(state + 4);
+
+	do {
+		uint32x4_t abcd0 = abcd, efgh0 = efgh;
+		uint32x4_t w[4], wk, tmp;
+		int i;
+
+		for (i = 0; i < 4; i++)
+			w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src +
+								       16 * i)));
+		for (i = 0; i < 16; i++) {
+			wk = vaddq_u32(w[i & 3], vld1q_u32(sha256_ce_k + 4 * i));
+			if (i < 12)
+				w[i & 3] = vsha256su1q_u32(
+					vsha256su0q_u32(w[i & 3],
+							w[(i + 1) & 3]),
+					w[(i + 2) & 3], w[(i + 3) & 3]);
+			tmp = abcd;
+			abcd = vsha256hq_u32(abcd, efgh, wk);
+			efgh = vsha256h2q_u32(efgh, tmp, wk);
+		}
+		abcd = vaddq_u32(abcd, abcd0);
+		efgh = vaddq_u32(efgh, efgh0);
+		src += 64;
+	} while (--blocks);
+
+	vst1q_u32(state, abcd);
+	vst1q_u32(state + 4, efgh);
+}